@@ -25,10 +25,10 @@
 #include "random.h"
 #include "launcher.h"
 #include "timer.h"
-#include "dlib/numerical_integration.h"
 #include <cstdlib>
 #include <vector>
 #include <deque>
+#include <queue>
 #include <algorithm>
 #include <numeric>
 
@@ -1400,8 +1400,8 @@ double CalculatedPeak::structureFactorSquared(Method method, double wavelength,
     int i, j, k;
     double dot;
     double pre;
-    double real = 0;
-    double imag = 0;
+    Accumulator real;
+    Accumulator imag;
     double sinTerm;
     double cosTerm;
     double thermFactor;
@@ -1431,7 +1431,7 @@ double CalculatedPeak::structureFactorSquared(Method method, double wavelength,
 	}
 	
     // Return the square of the magnitude
-    return real * real + imag*imag;
+    return real.value() * real.value() + imag.value() * imag.value();
 }
 
 /**
@@ -1705,38 +1705,40 @@ double CalculatedPattern::getRietveldRFactor(const Diffraction& referencePattern
 	vector<double> thisIntensities = generatePeakSignal(twoTheta);
 	
 	if (rMethod == DR_ABS) {	
-		double num = 0;
-		double denom = 0;
+		Accumulator num;
+		Accumulator denom;
 		for (int i=0; i<thisIntensities.size(); i++) {
 			double refI = refIntensities[i];
 			if (refI <= 0) continue; // Don't consider regions outside of background
 			num += abs(refI - _optimalScale * thisIntensities[i]);
 			denom += refI;
 		}
-		return denom > 0 ? num / denom : 1;
+		return denom.value() > 0 ? num.value() / denom.value() : 1;
 	} else if (rMethod == DR_SQUARED) {
 		vector<double> weight; weight.reserve(twoTheta.size());
 		for (int i=0; i<refIntensities.size(); i++) {
 			weight.push_back(rawRefIntensities[i] > 0 ? 1.0 / rawRefIntensities[i] : 0.0);
 		}
-		double denom = 0.0, num = 0.0, diff = 0.0;
+		Accumulator denom, num;
+		double diff = 0.0;
 		for (int i=0; i<weight.size(); i++) {
 			diff = refIntensities[i] - _optimalScale * thisIntensities[i];
 			num += weight[i] * diff * diff;
 			denom += weight[i] * refIntensities[i] * refIntensities[i];
 		}
-		return sqrt(num/denom);
+		return sqrt(num.value()/denom.value());
 	} else if (rMethod == DR_RIETVELD) {
 		vector<double> weight; weight.reserve(twoTheta.size());
 		for (int i=0; i<rawRefIntensities.size(); i++) {
 			weight.push_back(rawRefIntensities[i] > 0 ? 1.0 / rawRefIntensities[i] : 0.0);
 		}
-		double num = 0.0, diff = 0.0;
+		Accumulator num;
+		double diff = 0.0;
 		for (int i=0; i<weight.size(); i++) {
 			diff = rawRefIntensities[i] - _optimalScale * (thisIntensities[i] + background[i]);
 			num += weight[i] * diff * diff;
 		}
-		return num;
+		return num.value();
 	} else {
 		Output::newline(ERROR);
 		Output::print("Internal Error: Mint can't calculate a rietveld R factor with that method");
@@ -2285,6 +2287,14 @@ void ExperimentalPattern::getPeakIntensities(const vector<vector<double> >& peak
     VectorFunctor<ExperimentalPattern> compositeGaussDeriv(this, &ExperimentalPattern::compositeGaussianDerivs);
     VectorFunctor<ExperimentalPattern> psDeriv(this, &ExperimentalPattern::PVderivs);
     VectorFunctor<ExperimentalPattern> compositePVDeriv(this, &ExperimentalPattern::compositePVDerivs);
+    gaussFun.threadSafe(true);
+    compositeGaussFun.threadSafe(true);
+    psFun.threadSafe(true);
+    compositePVFun.threadSafe(true);
+    gaussDeriv.threadSafe(true);
+    compositeGaussDeriv.threadSafe(true);
+    psDeriv.threadSafe(true);
+    compositePVDeriv.threadSafe(true);
 
 
     // Part #0: Save two-theta/intensity pairs in a format compatable with 
@@ -2420,8 +2430,21 @@ void ExperimentalPattern::getPeakIntensities(const vector<vector<double> >& peak
             intensity = Solve<ExperimentalPattern>::maximize(psTT, 1e-8, initialTwoTheta, twoThetaStep, location);
             
             // Integrate the peak
+            double intError;
             PVPeakFunction peakFunc(this, psParams[curPeak]);
-            intensity = dlib::integrate_function_adapt_simp(peakFunc, groupMin, groupMax, 1e-8);
+            intensity = Num<double>::integrateBatch(peakFunc, groupMin, groupMax, GAUSSKRONROD, 1e-8, &intError);
+			
+			// Warn if the integral did not reach the tolerance
+			if (intError > 1e-8 * fabs(intensity)) {
+				Output::newline(WARNING);
+				Output::print("Integration of peak near ");
+				Output::print(location, 3);
+				Output::print(" did not converge (estimated error of ");
+				Output::printSci(intError);
+				Output::print(" in an intensity of ");
+				Output::printSci(intensity);
+				Output::print(")");
+			}
 			
 			// Check that results make sense
 			if (intensity < 0.0) {
@@ -413,6 +413,7 @@ private:
 	// Functions for fitting pseudo-Voigt function
 	// Params order: eta0, eta1, eta2, 2*theta_k, u, v, w, I0
 	double PV(const Vector& params, double twoTheta);
+	void PV(const Vector& params, int num, const double* twoTheta, double* res);
 	Vector PVderivs(const Vector& params, double twoTheta);
 	double PVderiv(const Vector& params, double twoTheta);
 	double compositePV(const Vector& params, double twoTheta);
@@ -758,6 +759,10 @@ public:
         return _pattern->PV(_params, x);
     }
     
+    void operator() (int num, const double* x, double* res) const {
+        _pattern->PV(_params, num, x, res);
+    }
+    
 private:
     ExperimentalPattern* _pattern;
     Vector _params;
@@ -969,6 +974,36 @@ inline double ExperimentalPattern::PV(const Vector& params, double twoTheta)
                 2 * (1 - eta) / (pi * sqrt(sfw) * den));
 }
 
+/**
+ * Evaluate a Psuedo-Voigt function at several angles
+ * @param params [in] Parameters of Psuedo-Voight function. (eta0, eta1, eta2, 2*Theta_k, 
+ *  u, V, W, I)
+ * @param num [in] Number of angles
+ * @param twoTheta [in] Angles at which function is evaluated
+ * @param res [out] Value of PS at each angle
+ */
+inline void ExperimentalPattern::PV(const Vector& params, int num, const double* twoTheta, double* res)
+{
+	
+	// Set variables that do not depend on angle
+	double Cg  = 4*log(2);
+	double gaussNorm = sqrt(Cg / Constants::pi);
+	double lorentzNorm = 2 / Constants::pi;
+	double degToHalfRad = Constants::pi / 360;
+	
+	// Loop over angles
+	double dif, tTT, sfw, eta;
+	for (int i = 0; i < num; ++i)
+	{
+		dif = twoTheta[i] - params[3];
+		tTT = tan(twoTheta[i] * degToHalfRad);
+		sfw = params[4] + params[5]*tTT + params[6]*tTT*tTT;
+		eta = params[0] + params[1]*twoTheta[i] + params[2]*twoTheta[i]*twoTheta[i];
+		res[i] = params[7] / sqrt(sfw) * (gaussNorm * exp(-Cg * dif*dif / sfw) * eta + \
+			lorentzNorm * (1 - eta) / (1 + 4*dif*dif / sfw));
+	}
+}
+
 
 
 /**
@@ -0,0 +1,743 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "multi.h"
+#include "eam.h"
+#include "language.h"
+#include "output.h"
+#include "fileSystem.h"
+#include <cstdlib>
+#include <cmath>
+
+/**
+ * Set EAM potential from input. Expected format of line #1
+ *	eam <setfl file>
+ *	eam <funcfl file> <element>
+ */
+void EAM::set(const Text& input)
+{
+	
+	// Finished if empty
+	if (!input.length())
+		return;
+	
+	// Line is too short
+	if (input[0].length() < 2)
+		readError(input[0]);
+	
+	// Check for element
+	bool isFuncfl = false;
+	Element element;
+	if ((input[0].length() > 2) && (!Language::isComment(input[0][2])))
+	{
+		if (!Element::isElement(input[0][2], false))
+			readError(input[0]);
+		element = Element::find(input[0][2], false);
+		isFuncfl = true;
+	}
+	
+	// No other options
+	for (int i = 1; i < input.length(); ++i)
+	{
+		if ((input[i].length()) && (!Language::isComment(input[i][0])))
+			readError(input[i]);
+	}
+	
+	// Output
+	Output::newline();
+	Output::print("Embedded-atom method potential from ");
+	Output::print(input[0][1]);
+	Output::increase();
+	
+	// Read file
+	Text content = Read::text(input[0][1]);
+	if (isFuncfl)
+		readFuncfl(content, input[0][1], element);
+	else
+		readSetfl(content, input[0][1]);
+	
+	// Print elements and cutoff
+	Output::newline();
+	Output::print("Elements:");
+	for (int i = 0; i < _elements.length(); ++i)
+	{
+		Output::print(" ");
+		Output::print(_elements[i].symbol());
+	}
+	Output::newline();
+	Output::print("Cutoff: ");
+	Output::print(_cutoff);
+	Output::print(" Ang");
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/**
+ * Read tables from a file in setfl format (or its Finnis-Sinclair variant)
+ * @param content [in] Contents of the file
+ * @param file [in] Name of the file (used in error messages)
+ */
+void EAM::readSetfl(const Text& content, const Word& file)
+{
+	
+	// Check header
+	if ((content.length() < 5) || (content[3].length() < 2) || (content[4].length() < 5))
+		fileError(file, "Header is not in setfl format");
+	
+	// Get elements
+	int i, j, k;
+	int numElements = atoi(content[3][0].array());
+	if ((numElements < 1) || (content[3].length() < numElements + 1))
+		fileError(file, "Elements are not set correctly");
+	for (i = 0; i < numElements; ++i)
+	{
+		if (!Element::isElement(content[3][i + 1], false))
+			fileError(file, "Element is not recognized");
+		_elements += Element::find(content[3][i + 1], false);
+	}
+	
+	// Get grid
+	int numRho = atoi(content[4][0].array());
+	double dRho = atof(content[4][1].array());
+	int numR = atoi(content[4][2].array());
+	double dR = atof(content[4][3].array());
+	_cutoff = atof(content[4][4].array());
+	if ((numRho < 5) || (numR < 5) || (dRho <= 0) || (dR <= 0) || (_cutoff <= 0))
+		fileError(file, "Grid is not set correctly");
+	
+	// Count values in the file to figure out whether the density depends on both elements
+	int numValues = 0;
+	for (i = 5; i < content.length(); ++i)
+	{
+		for (j = 0; j < content[i].length(); ++j)
+		{
+			if (Language::isNumber(content[i][j]))
+				++numValues;
+		}
+	}
+	numValues -= 3 * numElements + numElements * numRho + numElements * (numElements + 1) / 2 * numR;
+	int numDensities = 0;
+	if (numValues == numElements * numR)
+		numDensities = 1;
+	else if (numValues == numElements * numElements * numR)
+		numDensities = numElements;
+	else
+		fileError(file, "Number of values does not match setfl or Finnis-Sinclair format");
+	
+	// Allocate tables
+	_embedding.length(numElements);
+	_density.length(numElements);
+	_pair.length(numElements);
+	for (i = 0; i < numElements; ++i)
+	{
+		_density[i].length(numElements);
+		_pair[i].length(numElements);
+	}
+	
+	// Loop over elements
+	int line = 5;
+	int word = 0;
+	List<double> values;
+	for (i = 0; i < numElements; ++i)
+	{
+		
+		// Element line with number, mass, lattice constant and lattice type
+		if (word)
+		{
+			++line;
+			word = 0;
+		}
+		if ((line >= content.length()) || (content[line].length() < 2))
+			fileError(file, "Missing element information");
+		++line;
+		
+		// Embedding function
+		values.length(numRho);
+		for (j = 0; j < numRho; ++j)
+		{
+			if (!nextValue(content, line, word, values[j]))
+				fileError(file, "Missing embedding function values");
+		}
+		_embedding[i].set(values, dRho);
+		
+		// Density functions
+		values.length(numR);
+		for (j = 0; j < numDensities; ++j)
+		{
+			for (k = 0; k < numR; ++k)
+			{
+				if (!nextValue(content, line, word, values[k]))
+					fileError(file, "Missing density function values");
+			}
+			_density[i][j].set(values, dR);
+		}
+		for (j = numDensities; j < numElements; ++j)
+			_density[i][j] = _density[i][0];
+	}
+	
+	// Pair functions (stored as r*phi)
+	for (i = 0; i < numElements; ++i)
+	{
+		for (j = 0; j <= i; ++j)
+		{
+			for (k = 0; k < numR; ++k)
+			{
+				if (!nextValue(content, line, word, values[k]))
+					fileError(file, "Missing pair function values");
+			}
+			_pair[i][j].set(values, dR);
+			_pair[j][i] = _pair[i][j];
+		}
+	}
+}
+
+
+
+/**
+ * Read tables from a file in funcfl format
+ * @param content [in] Contents of the file
+ * @param file [in] Name of the file (used in error messages)
+ * @param element [in] Element that the file describes
+ */
+void EAM::readFuncfl(const Text& content, const Word& file, const Element& element)
+{
+	
+	// Check header
+	if ((content.length() < 3) || (content[1].length() < 2) || (content[2].length() < 5))
+		fileError(file, "Header is not in funcfl format");
+	
+	// Get grid
+	int numRho = atoi(content[2][0].array());
+	double dRho = atof(content[2][1].array());
+	int numR = atoi(content[2][2].array());
+	double dR = atof(content[2][3].array());
+	_cutoff = atof(content[2][4].array());
+	if ((numRho < 5) || (numR < 5) || (dRho <= 0) || (dR <= 0) || (_cutoff <= 0))
+		fileError(file, "Grid is not set correctly");
+	
+	// Allocate tables
+	_elements += element;
+	_embedding.length(1);
+	_density.length(1);
+	_density[0].length(1);
+	_pair.length(1);
+	_pair[0].length(1);
+	
+	// Embedding function
+	int i;
+	int line = 3;
+	int word = 0;
+	List<double> values(numRho);
+	for (i = 0; i < numRho; ++i)
+	{
+		if (!nextValue(content, line, word, values[i]))
+			fileError(file, "Missing embedding function values");
+	}
+	_embedding[0].set(values, dRho);
+	
+	// Effective charge, converted to r*phi = Z^2 in Hartree*Bohr
+	values.length(numR);
+	for (i = 0; i < numR; ++i)
+	{
+		if (!nextValue(content, line, word, values[i]))
+			fileError(file, "Missing effective charge values");
+		values[i] *= values[i] * 27.2 * 0.529;
+	}
+	_pair[0][0].set(values, dR);
+	
+	// Density function
+	for (i = 0; i < numR; ++i)
+	{
+		if (!nextValue(content, line, word, values[i]))
+			fileError(file, "Missing density function values");
+	}
+	_density[0][0].set(values, dR);
+}
+
+
+
+/**
+ * Compute the EAM energy
+ * @param iso [in] System to evaluate
+ * @param totalEnergy [out] Total energy, EAM energy will be added to this value
+ * @param totalForces [out] Force on each atom, EAM force (in fractional units) will be added to this value
+ */
+void EAM::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const
+{
+	
+	// Build neighbor list and get densities of all atoms
+	int i;
+	_neighbors.update(iso, _cutoff, _skin);
+	setTypes(iso);
+	List<int> atomsToSet(iso.numAtoms());
+	for (i = 0; i < iso.numAtoms(); ++i)
+		atomsToSet[i] = i;
+	setDensities(atomsToSet);
+	
+	// Variable to store forces
+	OList<Vector3D > localForces;
+	if (totalForces)
+	{
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Variable to store energy of each atom
+	List<double> terms;
+	if (totalEnergy)
+	{
+		terms.length(iso.numAtoms());
+		terms.fill(0);
+	}
+	
+	// Loop over atoms
+	int count = 0;
+	for (i = 0; i < iso.numAtoms(); ++i)
+	{
+		if ((++count + Multi::rank()) % Multi::worldSize() == 0)
+		{
+			if (totalEnergy)
+				terms[i] = atomEnergy(i);
+			if (totalForces)
+				localForces[i] = atomForce(iso, i);
+		}
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms);
+	
+	// Send forces between processors
+	if (totalForces)
+	{
+		int j;
+		Vector3D temp;
+		for (i = 0; i < localForces.length(); ++i)
+		{
+			for (j = 0; j < Multi::worldSize(); ++j)
+			{
+				temp = localForces[i];
+				Multi::broadcast(temp, j);
+				(*totalForces)[i] += temp;
+			}
+		}
+	}
+}
+
+
+
+/**
+ * Compute the EAM energy using symmetry
+ * @param iso [in] System to evaluate
+ * @param symmetry [in] Symmetry of the structure
+ * @param totalEnergy [out] Total energy, EAM energy will be added to this value
+ * @param totalForces [out] Force on each atom, EAM force (in fractional units) will be added to this value
+ */
+void EAM::evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, \
+	OList<Vector3D >* totalForces) const
+{
+	
+	// Do not use symmetry unless if reduces the number of atoms by at least a factor of two
+	if (iso.numAtoms() / symmetry.orbits().length() < 2) {
+		evaluate(iso, totalEnergy, totalForces);
+		return;
+	}
+	
+	// Build neighbor list and get densities of unique atoms
+	int i, j;
+	_neighbors.update(iso, _cutoff, _skin);
+	setTypes(iso);
+	List<int> atomsToSet(symmetry.orbits().length());
+	for (i = 0; i < symmetry.orbits().length(); ++i)
+		atomsToSet[i] = symmetry.orbits()[i].atoms()[0]->atomNumber();
+	setDensities(atomsToSet);
+	
+	// Copy densities to equivalent atoms
+	int rep;
+	for (i = 0; i < symmetry.orbits().length(); ++i)
+	{
+		rep = symmetry.orbits()[i].atoms()[0]->atomNumber();
+		for (j = 1; j < symmetry.orbits()[i].atoms().length(); ++j)
+		{
+			_rho[symmetry.orbits()[i].atoms()[j]->atomNumber()] = _rho[rep];
+			_embedEnergy[symmetry.orbits()[i].atoms()[j]->atomNumber()] = _embedEnergy[rep];
+			_embedDerivative[symmetry.orbits()[i].atoms()[j]->atomNumber()] = _embedDerivative[rep];
+		}
+	}
+	
+	// Variable to store forces
+	OList<Vector3D > localForces;
+	if (totalForces)
+	{
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Variable to store energy of each unique atom
+	List<double> terms;
+	if (totalEnergy)
+	{
+		terms.length(symmetry.orbits().length());
+		terms.fill(0);
+	}
+	
+	// Loop over unique atoms
+	int count = 0;
+	for (i = 0; i < symmetry.orbits().length(); ++i)
+	{
+		
+		// Check if adding on current processor
+		if ((++count + Multi::rank()) % Multi::worldSize() != 0)
+			continue;
+		
+		// Add energy
+		rep = symmetry.orbits()[i].atoms()[0]->atomNumber();
+		if (totalEnergy)
+			terms[i] = symmetry.orbits()[i].atoms().length() * atomEnergy(rep);
+		
+		// Get force
+		if (totalForces)
+			localForces[rep] = symmetry.orbits()[i].specialPositions()[0].rotation() * atomForce(iso, rep);
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms);
+	
+	// Send forces between processors
+	if (totalForces)
+	{
+		
+		// Send forces
+		Vector3D temp;
+		OList<Vector3D > uniqueForces(localForces.length());
+		uniqueForces.fill(0.0);
+		for (i = 0; i < localForces.length(); ++i)
+		{
+			for (j = 0; j < Multi::worldSize(); ++j)
+			{
+				temp = localForces[i];
+				Multi::broadcast(temp, j);
+				uniqueForces[i] += temp;
+			}
+		}
+		
+		// Apply symmetry operations to generate forces on equivalent atoms
+		for (i = 0; i < symmetry.orbits().length(); ++i)
+		{
+			rep = symmetry.orbits()[i].atoms()[0]->atomNumber();
+			(*totalForces)[rep] += uniqueForces[rep];
+			for (j = 1; j < symmetry.orbits()[i].atoms().length(); ++j)
+				(*totalForces)[symmetry.orbits()[i].atoms()[j]->atomNumber()] += \
+					symmetry.orbits()[i].generators()[j].rotation() * uniqueForces[rep];
+		}
+	}
+}
+
+
+
+/**
+ * Save the index of the element of each atom in the potential (-1 if element is not in the potential)
+ * @param iso [in] Structure being evaluated
+ */
+void EAM::setTypes(const ISO& iso) const
+{
+	int i, j, k;
+	_types.length(iso.numAtoms());
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < _elements.length(); ++j)
+		{
+			if (_elements[j] == iso.atoms()[i][0].element())
+				break;
+		}
+		if (j == _elements.length())
+			j = -1;
+		for (k = 0; k < iso.atoms()[i].length(); ++k)
+			_types[iso.atoms()[i][k].atomNumber()] = j;
+	}
+}
+
+
+
+/**
+ * First pass of the evaluation: get the density, embedding energy and its derivative for atoms
+ * @param atomsToSet [in] Numbers of the atoms to set (others are set to zero)
+ */
+void EAM::setDensities(const List<int>& atomsToSet) const
+{
+	
+	// Get densities of atoms on current processor
+	int i;
+	int count = 0;
+	_rho.length(_types.length());
+	_rho.fill(0.0);
+	for (i = 0; i < atomsToSet.length(); ++i)
+	{
+		if ((++count + Multi::rank()) % Multi::worldSize() == 0)
+			_rho[atomsToSet[i]] = atomDensity(atomsToSet[i]);
+	}
+	
+	// Send densities between processors
+	int j;
+	double temp;
+	double sum;
+	for (i = 0; i < atomsToSet.length(); ++i)
+	{
+		sum = 0;
+		for (j = 0; j < Multi::worldSize(); ++j)
+		{
+			temp = _rho[atomsToSet[i]];
+			Multi::broadcast(temp, j);
+			sum += temp;
+		}
+		_rho[atomsToSet[i]] = sum;
+	}
+	
+	// Evaluate embedding function
+	_embedEnergy.length(_types.length());
+	_embedDerivative.length(_types.length());
+	_embedEnergy.fill(0.0);
+	_embedDerivative.fill(0.0);
+	for (i = 0; i < atomsToSet.length(); ++i)
+	{
+		if (_types[atomsToSet[i]] >= 0)
+			_embedding[_types[atomsToSet[i]]].evaluate(_rho[atomsToSet[i]], _embedEnergy[atomsToSet[i]], \
+				_embedDerivative[atomsToSet[i]]);
+	}
+}
+
+
+
+/**
+ * Get the density at an atom
+ * @param atomNumber [in] Number of the atom
+ */
+double EAM::atomDensity(int atomNumber) const
+{
+	int type = _types[atomNumber];
+	if (type < 0)
+		return 0;
+	int i, curType;
+	double res = 0;
+	for (i = 0; i < _neighbors.numNeighbors(atomNumber); ++i)
+	{
+		curType = _types[_neighbors.neighbor(atomNumber, i)->atomNumber()];
+		if (curType >= 0)
+			res += _density[curType][type].value(_neighbors.distance(atomNumber, i));
+	}
+	return res;
+}
+
+
+
+/**
+ * Get the energy of an atom (embedding energy and half of each pair interaction)
+ * @param atomNumber [in] Number of the atom (densities must be set)
+ */
+double EAM::atomEnergy(int atomNumber) const
+{
+	int type = _types[atomNumber];
+	if (type < 0)
+		return 0;
+	int i, curType;
+	double distance;
+	double res = 0;
+	for (i = 0; i < _neighbors.numNeighbors(atomNumber); ++i)
+	{
+		curType = _types[_neighbors.neighbor(atomNumber, i)->atomNumber()];
+		if (curType < 0)
+			continue;
+		distance = _neighbors.distance(atomNumber, i);
+		res += _pair[type][curType].value(distance) / distance;
+	}
+	return _embedEnergy[atomNumber] + res / 2;
+}
+
+
+
+/**
+ * Get the force on an atom
+ * @param iso [in] Structure being evaluated
+ * @param atomNumber [in] Number of the atom (densities of all atoms must be set)
+ * @return Force in fractional units
+ */
+Vector3D EAM::atomForce(const ISO& iso, int atomNumber) const
+{
+	
+	// Atom does not interact
+	Vector3D force(0.0);
+	int type = _types[atomNumber];
+	if (type < 0)
+		return force;
+	
+	// Loop over neighbors
+	int i;
+	int curType;
+	int curNumber;
+	double distance;
+	double value;
+	double phi;
+	double phiDerivative;
+	double rhoInDerivative;
+	double rhoOutDerivative;
+	for (i = 0; i < _neighbors.numNeighbors(atomNumber); ++i)
+	{
+		
+		// Get neighbor
+		curNumber = _neighbors.neighbor(atomNumber, i)->atomNumber();
+		curType = _types[curNumber];
+		if (curType < 0)
+			continue;
+		distance = _neighbors.distance(atomNumber, i);
+		
+		// Derivatives of density at current atom and at neighbor
+		_density[curType][type].evaluate(distance, value, rhoInDerivative);
+		_density[type][curType].evaluate(distance, value, rhoOutDerivative);
+		
+		// Derivative of pair function (stored as r*phi)
+		_pair[type][curType].evaluate(distance, phi, phiDerivative);
+		phi /= distance;
+		phiDerivative = (phiDerivative - phi) / distance;
+		
+		// Add force (positive derivative pulls atom towards neighbor)
+		force += _neighbors.cartVector(atomNumber, i) * ((_embedDerivative[atomNumber] * rhoInDerivative + \
+			_embedDerivative[curNumber] * rhoOutDerivative + phiDerivative) / distance);
+	}
+	
+	// Return force in fractional units
+	iso.basis().toFractional(force);
+	return force;
+}
+
+
+
+/**
+ * Set cubic spline coefficients for a table
+ * @param values [in] Values of the function at 0, delta, 2*delta, ...
+ * @param delta [in] Spacing between points
+ */
+void EAM::Table::set(const List<double>& values, double delta)
+{
+	
+	// Get slope at each point (in units of the spacing)
+	int i;
+	int num = values.length();
+	_delta = delta;
+	List<double> slopes(num);
+	slopes[0] = values[1] - values[0];
+	slopes[1] = 0.5 * (values[2] - values[0]);
+	slopes[num - 2] = 0.5 * (values[num - 1] - values[num - 3]);
+	slopes[num - 1] = values[num - 1] - values[num - 2];
+	for (i = 2; i < num - 2; ++i)
+		slopes[i] = ((values[i - 2] - values[i + 2]) + 8 * (values[i + 1] - values[i - 1])) / 12;
+	
+	// Save coefficients of cubic polynomial on each interval
+	_coeffs.length(4 * num);
+	for (i = 0; i < num; ++i)
+	{
+		_coeffs[4*i + 3] = values[i];
+		_coeffs[4*i + 2] = slopes[i];
+		if (i < num - 1)
+		{
+			_coeffs[4*i + 1] = 3 * (values[i + 1] - values[i]) - 2 * slopes[i] - slopes[i + 1];
+			_coeffs[4*i] = slopes[i] + slopes[i + 1] - 2 * (values[i + 1] - values[i]);
+		}
+		else
+		{
+			_coeffs[4*i + 1] = 0;
+			_coeffs[4*i] = 0;
+		}
+	}
+}
+
+
+
+/**
+ * Evaluate table (linear extrapolation beyond the last point)
+ * @param x [in] Point to evaluate
+ * @param value [out] Value at point
+ * @param derivative [out] Derivative at point
+ */
+void EAM::Table::evaluate(double x, double& value, double& derivative) const
+{
+	int num = _coeffs.length() / 4;
+	double p = (x > 0) ? x / _delta : 0;
+	int index = (int) p;
+	if (index >= num - 1)
+	{
+		derivative = _coeffs[4*(num - 1) + 2] / _delta;
+		value = _coeffs[4*(num - 1) + 3] + derivative * (x - (num - 1) * _delta);
+		return;
+	}
+	p -= index;
+	const double* c = &_coeffs[4*index];
+	value = ((c[0] * p + c[1]) * p + c[2]) * p + c[3];
+	derivative = ((3 * c[0] * p + 2 * c[1]) * p + c[2]) / _delta;
+}
+
+
+
+/**
+ * Get the next number in a file
+ * @param content [in] Contents of file
+ * @param line [in/out] Current line
+ * @param word [in/out] Current word on line
+ * @param value [out] Value that was read
+ * @return Whether a number was found
+ */
+bool EAM::nextValue(const Text& content, int& line, int& word, double& value)
+{
+	while (line < content.length())
+	{
+		if (word < content[line].length())
+		{
+			if (!Language::isNumber(content[line][word]))
+				return false;
+			value = atof(content[line][word++].array());
+			return true;
+		}
+		++line;
+		word = 0;
+	}
+	return false;
+}
+
+
+
+/**
+ * Print error in EAM file and quit
+ * @param file [in] Name of file
+ * @param message [in] Description of the error
+ */
+void EAM::fileError(const Word& file, const char* message)
+{
+	Output::newline(ERROR);
+	Output::print("Could not read EAM file ");
+	Output::print(file);
+	Output::print(": ");
+	Output::print(message);
+	Output::quit();
+}
@@ -0,0 +1,113 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef EAM_H
+#define EAM_H
+
+
+
+#include "locPotential.h"
+#include "iso.h"
+#include "elements.h"
+#include "symmetry.h"
+#include "text.h"
+#include "list.h"
+
+
+
+/**
+ * Tabulated embedded-atom method potential
+ * 
+ * E = sum_i F_a(rho_i) + 1/2 sum_{i != j} phi_ab(r_ij),  rho_i = sum_{j != i} rho_ba(r_ij)
+ * 
+ * where a is the element of atom i and b is the element of atom j. Tables are read from
+ *  DYNAMO-style files in the setfl format (multi-element, as used by eam/alloy), the
+ *  Finnis-Sinclair variant of setfl (density depends on both elements, as used by eam/fs),
+ *  or the funcfl format (single element, as used by eam). The setfl variant is detected
+ *  from the number of values in the file. Tables are interpolated with cubic splines.
+ * 
+ * Input format:
+ *	eam <setfl file>
+ *	eam <funcfl file> <element>
+ * 
+ * Atoms of elements that are not in the file do not interact through this potential.
+ */
+class EAM : public SingleLocalPotential {
+	
+	// Cubic spline through uniformly spaced values starting at zero
+	class Table {
+		double _delta;
+		List<double> _coeffs;
+	public:
+		Table()	{ _delta = 1; }
+		void set(const List<double>& values, double delta);
+		void evaluate(double x, double& value, double& derivative) const;
+		double value(double x) const	{ double val, der; evaluate(x, val, der); return val; }
+	};
+	
+	// Variables
+	double _cutoff;
+	OList<Element> _elements;
+	OList<Table> _embedding;
+	OList<Table>::D2 _density;
+	OList<Table>::D2 _pair;
+	
+	// Helper variables
+	mutable NeighborList _neighbors;
+	mutable List<int> _types;
+	mutable List<double> _rho;
+	mutable List<double> _embedEnergy;
+	mutable List<double> _embedDerivative;
+	
+	// Functions
+	void readSetfl(const Text& content, const Word& file);
+	void readFuncfl(const Text& content, const Word& file, const Element& element);
+	void setTypes(const ISO& iso) const;
+	void setDensities(const List<int>& atomsToSet) const;
+	double atomDensity(int atomNumber) const;
+	double atomEnergy(int atomNumber) const;
+	Vector3D atomForce(const ISO& iso, int atomNumber) const;
+	
+	// Helper functions
+	static bool nextValue(const Text& content, int& line, int& word, double& value);
+	static void fileError(const Word& file, const char* message);
+	
+public:
+	
+	// Constructor
+	EAM()	{ _cutoff = 0; }
+	
+	// Setup by file input
+	void set(const Text& input);
+	
+	// Evaluation functions
+	void evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const;
+	void evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, \
+		OList<Vector3D >* totalForces) const;
+	
+	// Access functions
+	double cutoff() const	{ return _cutoff; }
+};
+
+
+
+#endif
@@ -24,6 +24,7 @@
 #include "electrostatic.h"
 #include "text.h"
 #include "pairPotential.h"
+#include "multi.h"
 
 /**
  * Read in options from file. See class documentation for those options
@@ -45,8 +46,16 @@ void Electrostatic::set(const Text& input) {
 	// Read in other options
 	setEwaldOptions(input, true);
 	
+	// Look for split evaluation
+	_fused = true;
+	for (int i=1; i < input.length(); i++) {
+		if ((input[i].length()) && (input[i][0].equal("split", false)))
+			_fused = false;
+	}
+	
 	// Define the hard-sphere potentials
 	_potentials.clear();
+	_pairIndex.assign(_elements.length(), vector<int>(_elements.length(), -1));
 	for (int elem1=0; elem1 < _elements.length(); elem1++) {
 		for (int elem2=elem1; elem2 < _elements.length(); elem2++) {
 			HardSphere hs;
@@ -54,23 +63,307 @@ void Electrostatic::set(const Text& input) {
 			hs.setRadius(_radii[elem1] + _radii[elem2]);
 			hs.setElementOne(_elements[elem1]);
 			hs.setElementTwo(_elements[elem2]);
+			_pairIndex[elem1][elem2] = _pairIndex[elem2][elem1] = _potentials.size();
 			_potentials.push_back(hs);
 		}
 	}
 }
 
 void Electrostatic::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D>* totalForces) const {
-	Ewald::evaluate(iso, totalEnergy, totalForces);
 	
-	for (int i=0; i<_potentials.size(); i++) {
-		_potentials[i].evaluate(iso, totalEnergy, totalForces);
+	// Evaluate each term separately
+	if (!_fused) {
+		Ewald::evaluate(iso, totalEnergy, totalForces);
+		
+		for (int i=0; i<_potentials.size(); i++) {
+			_potentials[i].evaluate(iso, totalEnergy, totalForces);
+		}
+		return;
+	}
+	
+	// Set up the Ewald sum and the shared image iterator
+	initialize(iso, iso.numAtoms());
+	setPairIterator(iso);
+	
+	// Variable to store cartesian forces
+	OList<Vector3D> localForces;
+	if (totalForces) {
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Loop over atoms and add each pair once
+	int i, j;
+	int count = 0;
+	List<double> terms(iso.numAtoms(), 0.0);
+	Atom* atom;
+	for (i=0; i < iso.atoms().length(); i++) {
+		for (j=0; j < iso.atoms()[i].length(); j++) {
+			if ((++count + Multi::rank()) % Multi::worldSize() == 0) {
+				atom = &iso.atoms()[i][j];
+				pairTerms(iso, atom, true, (totalEnergy) ? &terms[count - 1] : 0, \
+					(totalForces) ? &localForces : 0);
+				if (totalForces)
+					localForces[atom->atomNumber()] += recipForce(iso, atom);
+			}
+		}
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms) + recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
+	
+	// Send forces between processors and convert to fractional units
+	if (totalForces) {
+		Vector3D temp;
+		Vector3D sum;
+		for (i=0; i < localForces.length(); i++) {
+			sum = 0.0;
+			for (j=0; j < Multi::worldSize(); j++) {
+				temp = localForces[i];
+				Multi::broadcast(temp, j);
+				sum += temp;
+			}
+			iso.basis().toFractional(sum);
+			(*totalForces)[i] += sum;
+		}
 	}
 }
 
 void Electrostatic::evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, OList<Vector3D>* totalForces) const {
-	Ewald::evaluate(iso, symmetry, totalEnergy, totalForces);
 	
+	// Evaluate each term separately
+	if (!_fused) {
+		Ewald::evaluate(iso, symmetry, totalEnergy, totalForces);
+		
+		for (int i=0; i<_potentials.size(); i++) {
+			_potentials[i].evaluate(iso, symmetry, totalEnergy, totalForces);
+		}
+		return;
+	}
+	
+	// Do not use symmetry unless if reduces the number of atoms by at least a factor of two
+	if (iso.numAtoms() / symmetry.orbits().length() < 2) {
+		evaluate(iso, totalEnergy, totalForces);
+		return;
+	}
+	
+	// Set up the Ewald sum and the shared image iterator
+	initialize(iso, symmetry.orbits().length());
+	setPairIterator(iso);
+	
+	// Variable to store cartesian forces
+	OList<Vector3D> localForces;
+	if (totalForces) {
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Loop over unique atoms
+	int i, j;
+	int count = 0;
+	double atomEnergy;
+	List<double> terms(symmetry.orbits().length(), 0.0);
+	Atom* atom;
+	for (i=0; i < symmetry.orbits().length(); i++) {
+		
+		// Check if adding on current processor
+		if ((++count + Multi::rank()) % Multi::worldSize() != 0)
+			continue;
+		
+		// Add energy and get force on the first atom in the orbit
+		atom = symmetry.orbits()[i].atoms()[0];
+		atomEnergy = 0;
+		pairTerms(iso, atom, false, (totalEnergy) ? &atomEnergy : 0, (totalForces) ? &localForces : 0);
+		terms[count - 1] = symmetry.orbits()[i].atoms().length() * atomEnergy;
+		if (totalForces)
+			localForces[atom->atomNumber()] += recipForce(iso, atom);
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms) + recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
+	
+	// Send forces between processors
+	if (totalForces) {
+		
+		// Send forces of unique atoms and convert to fractional units
+		int rep;
+		Vector3D temp;
+		Vector3D sum;
+		for (i=0; i < symmetry.orbits().length(); i++) {
+			rep = symmetry.orbits()[i].atoms()[0]->atomNumber();
+			sum = 0.0;
+			for (j=0; j < Multi::worldSize(); j++) {
+				temp = localForces[rep];
+				Multi::broadcast(temp, j);
+				sum += temp;
+			}
+			iso.basis().toFractional(sum);
+			sum = symmetry.orbits()[i].specialPositions()[0].rotation() * sum;
+			
+			// Apply symmetry operations to generate forces on equivalent atoms
+			(*totalForces)[rep] += sum;
+			for (j=1; j < symmetry.orbits()[i].atoms().length(); j++)
+				(*totalForces)[symmetry.orbits()[i].atoms()[j]->atomNumber()] += \
+					symmetry.orbits()[i].generators()[j].rotation() * sum;
+		}
+	}
+}
+
+/**
+ * Set the image iterator shared by the real space and hard-sphere terms
+ * 
+ * The cutoff is the larger of the real space cutoff of the Ewald sum (initialize must have been
+ *  called) and the largest hard-sphere radius.
+ * @param iso [in] Structure being evaluated
+ */
+void Electrostatic::setPairIterator(const ISO& iso) const {
+	double cutoff = sqrt(-log(accuracy())) / _alpha;
 	for (int i=0; i<_potentials.size(); i++) {
-		_potentials[i].evaluate(iso, symmetry, totalEnergy, totalForces);
+		if (_potentials[i].cutoff() > cutoff)
+			cutoff = _potentials[i].cutoff();
+	}
+	_pairIterator.setCell(iso.basis(), cutoff);
+}
+
+/**
+ * Add the real space and hard-sphere terms between an atom and all other atoms in a single pass
+ * @param iso [in] Structure being evaluated (image iterator must be set)
+ * @param atom [in] Atom being considered
+ * @param upperOnly [in] Whether to only add pairs with atoms of a higher number, so that each pair is
+ *  visited once and the force on the other atom is also added (false adds half of the energy of each
+ *  pair and only the force on atom)
+ * @param energy [in/out] Energy will be added to this value (optional)
+ * @param forces [in/out] Cartesian force on each atom by atom number will be added to this list (optional)
+ */
+void Electrostatic::pairTerms(const ISO& iso, Atom* atom, bool upperOnly, double* energy, \
+	OList<Vector3D>* forces) const {
+	
+	// Return if atom has no interactions
+	int atomNumber = atom->atomNumber();
+	int elem1 = elementIndex(atom->element());
+	if (elem1 == -1)
+		return;
+	
+	// Compute useful prefactors
+	double twoAoverRootPi = 2 * _alpha / sqrt(Constants::pi);
+	double alphaSquared = _alpha * _alpha;
+	double prefactor = _charges[elem1] / (4 * Constants::pi * _perm);
+	
+	// Loop over elements
+	int e, j;
+	int elem2;
+	int otherNumber;
+	double scale;
+	double distance;
+	double real;
+	double mag;
+	double res = 0;
+	Vector3D force;
+	const HardSphere* pair;
+	for (e=0; e < iso.atoms().length(); e++) {
+		
+		// Get the potentials with the current element
+		elem2 = elementIndex(iso.atoms()[e][0].element());
+		if (elem2 == -1)
+			continue;
+		pair = &_potentials[_pairIndex[elem1][elem2]];
+		
+		// Loop over atoms of current element
+		for (j=0; j < iso.atoms()[e].length(); j++) {
+			
+			// Skip pairs that are added from the other atom
+			otherNumber = iso.atoms()[e][j].atomNumber();
+			if ((upperOnly) && (otherNumber < atomNumber))
+				continue;
+			
+			// Pairs are visited twice unless only upper pairs are used (images of the atom itself are
+			//  always visited twice)
+			scale = ((upperOnly) && (otherNumber != atomNumber)) ? 1 : 0.5;
+			
+			// Loop over images
+			_pairIterator.reset(atom->fractional(), iso.atoms()[e][j].fractional());
+			while (!_pairIterator.finished()) {
+				if (++_pairIterator < 1e-8)
+					continue;
+				
+				// Get terms that are shared by the energy and force
+				distance = _pairIterator.distance();
+				real = erfc(_alpha * distance) / distance;
+				
+				// Add energy
+				if (energy) {
+					res += scale * prefactor * _charges[elem2] * real;
+					if (distance < pair->cutoff())
+						res += scale * pair->energyAt(distance);
+				}
+				
+				// Add force (forces between an atom and its own images cancel)
+				if ((forces) && (otherNumber != atomNumber)) {
+					mag = prefactor * _charges[elem2] * \
+						(real + twoAoverRootPi * exp(-alphaSquared * distance * distance)) / distance;
+					if (distance < pair->cutoff())
+						mag += pair->forceAt(distance);
+					force = _pairIterator.cartVector() * (mag / distance);
+					(*forces)[atomNumber] -= force;
+					if (upperOnly)
+						(*forces)[otherNumber] += force;
+				}
+			}
+		}
+	}
+	
+	// Save energy
+	if (energy)
+		*energy += res;
+}
+
+/**
+ * Get the index of an element in the list of charged elements
+ * @param element [in] Element to look up
+ * @return Index of element, or -1 if it was not set
+ */
+int Electrostatic::elementIndex(const Element& element) const {
+	for (int i=0; i < _elements.length(); i++) {
+		if (_elements[i] == element)
+			return i;
+	}
+	return -1;
+}
+
+void Electrostatic::commit(const ISO& iso) const {
+	Ewald::commit(iso);
+	
+	for (int i=0; i<_potentials.size(); i++) {
+		_potentials[i].commit(iso);
+	}
+}
+
+double Electrostatic::deltaEnergy(const ISO& iso, const LocalMove& move) const {
+	double res = Ewald::deltaEnergy(iso, move);
+	
+	for (int i=0; i<_potentials.size(); i++) {
+		res += _potentials[i].deltaEnergy(iso, move);
+	}
+	return res;
+}
+
+void Electrostatic::precision(LocalPrecision input) {
+	Ewald::precision(input);
+	
+	for (int i=0; i<_potentials.size(); i++) {
+		_potentials[i].precision(input);
+	}
+}
+
+double Electrostatic::errorEstimate() const {
+	double res = Ewald::errorEstimate();
+	
+	// Hard-sphere terms are only approximate when evaluated separately
+	double hardSphere = 0;
+	for (int i=0; (!_fused) && (i<_potentials.size()); i++) {
+		hardSphere = Num<double>::max(hardSphere, _potentials[i].errorEstimate());
 	}
+	return res + hardSphere;
 }
@@ -50,7 +50,9 @@
  * 
  * Input format: &lt;element #1 Symbol, charge, radius&gt; &lt; &lt;that data for each other element&gt;
  * 
- * Options: See options for Ewald (in set)
+ * Options: See options for Ewald (in set). "split" evaluates the Ewald sum and hard-sphere
+ *  terms in separate passes instead of a single pass over the pairs of atoms (used to validate
+ *  the single pass).
  * 
  */
 class Electrostatic : public Ewald {
@@ -60,14 +62,37 @@ class Electrostatic : public Ewald {
 	
 	// Hard sphere potentials
 	vector<HardSphere> _potentials;
+	
+	// Index of the hard sphere potential between each pair of elements (same order as _elements)
+	vector<vector<int> > _pairIndex;
+	
+	// Whether real space and hard-sphere terms are evaluated in one pass over the pairs of atoms
+	//  (false evaluates Ewald and each hard-sphere potential separately, which is kept for validation)
+	bool _fused;
+	
+	// Image iterator shared by the real space and hard-sphere terms
+	mutable ImageIterator _pairIterator;
+	
+	// Functions used in the fused pass
+	void setPairIterator(const ISO& iso) const;
+	void pairTerms(const ISO& iso, Atom* atom, bool upperOnly, double* energy, OList<Vector3D>* forces) const;
+	int elementIndex(const Element& element) const;
 
 public:
+	
+	Electrostatic() : Ewald() { _fused = true; }
 		
 	void set(const Text& input);
 
 	virtual void evaluate(const ISO& iso, double* energy, OList<Vector3D>* forces) const;
 	virtual void evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, OList<Vector3D>* totalForces) const;
 
+	virtual void commit(const ISO& iso) const;
+	virtual double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+	
+	virtual void precision(LocalPrecision input);
+	virtual double errorEstimate() const;
+
 };
 
 #endif	/* POTENTIALPEGS_H */
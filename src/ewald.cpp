@@ -104,6 +104,9 @@ void Ewald::set(const Text& input)
 	Output::newline();
 	Output::print("Accuracy: ");
 	Output::printSci(_accuracy);
+	Output::newline();
+	Output::print("Accuracy when screening: ");
+	Output::printSci(_screenAccuracy);
 	
 	// Output
 	Output::decrease();
@@ -129,8 +132,11 @@ void Ewald::setEwaldOptions(const Text& input, bool forgiving) {
 			continue;
 
 		// Line is too short
-		if (input[i].length() < 2)
+		if (input[i].length() < 2) {
+			if (forgiving)
+				continue;
 			readError(input[i]);
+		}
 
 		// Found accuracy
 		if (input[i][0].equal("accuracy", false, 3)) {
@@ -138,6 +144,13 @@ void Ewald::setEwaldOptions(const Text& input, bool forgiving) {
 				_accuracy = atof(input[i][1].array());
 			else
 				readError(input[i]);
+		}
+			// Found accuracy used when screening
+		else if (input[i][0].equal("screening", false, 4)) {
+			if (Language::isNumber(input[i][1]))
+				_screenAccuracy = atof(input[i][1].array());
+			else
+				readError(input[i]);
 		}
 			// Found permittivity
 		else if (input[i][0].equal("permittivity", false, 4)) {
@@ -161,6 +174,9 @@ void Ewald::setEwaldOptions(const Text& input, bool forgiving) {
 		else if (! forgiving)
 			readError(input[i]);
 	}
+	
+	// Settings changed so any previous setup is no longer valid
+	_setupNumAtoms = -1;
 }
 
 
@@ -180,33 +196,24 @@ void Ewald::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* tota
 	// Loop over elements
 	int i, j;
 	int count = 0;
-	double localReal = 0;
+	List<double> terms(iso.numAtoms(), 0.0);
 	for (i = 0; i < iso.atoms().length(); ++i)
 	{
 		
-		// Loop over atoms of current element and add energy
+		// Loop over atoms of current element and save energy
 		for (j = 0; j < iso.atoms()[i].length(); ++j)
 		{
 			if ((++count + Multi::rank()) % Multi::worldSize() == 0)
 			{
 				if (totalEnergy)
-					localReal += realEnergy(iso, &iso.atoms()[i][j], true);
+					terms[count - 1] = realEnergy(iso, &iso.atoms()[i][j], true);
 			}
 		}
 	}
 	
-	// Send energy between processors
+	// Sum energy over processors
 	if (totalEnergy)
-	{
-		double temp;
-		for (i = 0; i < Multi::worldSize(); ++i)
-		{
-			temp = localReal;
-			Multi::broadcast(temp, i);
-			*totalEnergy += temp;
-		}
-		*totalEnergy += recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
-	}
+		*totalEnergy += Multi::sum(terms) + recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
 	
 	if (totalForces) {
 		computeForces(iso, totalForces);	
@@ -229,38 +236,147 @@ void Ewald::evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEner
 	// Initialize the calculation
 	initialize(iso, symmetry.orbits().length());
 	
-	// Loop over unique atoms and add energy of each
+	// Loop over unique atoms and save energy of each
 	int i;
 	int count = 0;
-	double localReal = 0;
+	List<double> terms(symmetry.orbits().length(), 0.0);
 	for (i = 0; i < symmetry.orbits().length(); ++i)
 	{
 		if ((++count + Multi::rank()) % Multi::worldSize() == 0)
 		{
 			if (totalEnergy)
-				localReal += symmetry.orbits()[i].atoms().length() * \
+				terms[count - 1] = symmetry.orbits()[i].atoms().length() * \
 					realEnergy(iso, symmetry.orbits()[i].atoms()[0], false);
 		}
 	}
 	
-	// Send energy between processors
+	// Sum energy over processors
 	if (totalEnergy)
-	{
-		double temp;
-		for (i = 0; i < Multi::worldSize(); ++i)
-		{
-			temp = localReal;
-			Multi::broadcast(temp, i);
-			*totalEnergy += temp/2;
-		}
-		*totalEnergy += recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
-	}
+		*totalEnergy += Multi::sum(terms)/2 + recipEnergy(iso) - selfEnergy(iso) - chargedEnergy(iso);
 	
 	if (totalForces) {
 		computeForces(iso, totalForces);
 	}
 }
 
+/**
+ * Save the reference state used to compute energy changes of local moves
+ * 
+ * The mixing parameter and reciprocal space vectors of the committed structure are kept
+ *  fixed for all moves, and the structure factor at each reciprocal space vector is saved
+ *  so that it can be updated for only the atoms that change.
+ * @param iso [in] Reference structure
+ */
+void Ewald::commit(const ISO& iso) const {
+	
+	// Set up the sum for the reference structure
+	initialize(iso, iso.numAtoms());
+	_refAlpha = _alpha;
+	_refFactors = _recipFactors;
+	_refVectors.length(_recipVectors.length());
+	int i = 0;
+	for (Linked<Vector3D >::iterator it = _recipVectors.begin(); it != _recipVectors.end(); ++it, ++i)
+		_refVectors[i] = *it;
+	
+	// Build bins for the real space sum
+	_reference.set(iso, sqrt(-log(accuracy())) / _alpha, false);
+	
+	// Save the structure factor
+	int j, k;
+	double dot;
+	double charge;
+	_refCos.length(_refVectors.length());
+	_refSin.length(_refVectors.length());
+	_refCos.fill(0.0);
+	_refSin.fill(0.0);
+	_refCharge = 0;
+	for (i = 0; i < iso.atoms().length(); ++i) {
+		charge = getCharge(iso.atoms()[i][0].element());
+		if (charge == 0)
+			continue;
+		_refCharge += charge * iso.atoms()[i].length();
+		for (j = 0; j < iso.atoms()[i].length(); ++j) {
+			for (k = 0; k < _refVectors.length(); ++k) {
+				dot = _refVectors[k] * iso.atoms()[i][j].fractional();
+				_refCos[k] += charge * cos(dot);
+				_refSin[k] += charge * sin(dot);
+			}
+		}
+	}
+	
+	// Save revision of the reference structure
+	markCommitted(iso);
+}
+
+/**
+ * Compute the change in Ewald energy from a local move using the reference state saved by commit
+ * 
+ * The real space term is evaluated only for interactions involving changed atoms and the 
+ *  reciprocal space term is found by updating the saved structure factor, so the cost
+ *  scales with the number of changed atoms rather than the size of the structure.
+ * @param iso [in] Reference structure
+ * @param move [in] Changes to apply to the structure
+ * @return Energy after the move minus energy before the move
+ */
+double Ewald::deltaEnergy(const ISO& iso, const LocalMove& move) const {
+	
+	// Save reference if it has not been set or the structure has changed
+	if (!committed(iso))
+		commit(iso);
+	
+	// Real space term
+	double res = localPairEnergy(iso, _reference, move, true) - localPairEnergy(iso, _reference, move, false);
+	
+	// Get change in charges
+	int i, j;
+	double charge;
+	double dot;
+	double chargeChange = 0;
+	double chargeSquaredChange = 0;
+	for (i = 0; i < move.length(); ++i) {
+		for (j = 0; j < 2; ++j) {
+			if (!move.present(i, j))
+				continue;
+			charge = getCharge(move.element(i, j));
+			chargeChange += (j) ? charge : -charge;
+			chargeSquaredChange += (j) ? charge * charge : -charge * charge;
+		}
+	}
+	
+	// Reciprocal space term from change in structure factor
+	int k;
+	double cosChange;
+	double sinChange;
+	double recip = 0;
+	for (k = 0; k < _refVectors.length(); ++k) {
+		cosChange = 0;
+		sinChange = 0;
+		for (i = 0; i < move.length(); ++i) {
+			for (j = 0; j < 2; ++j) {
+				if (!move.present(i, j))
+					continue;
+				charge = getCharge(move.element(i, j));
+				if (charge == 0)
+					continue;
+				if (!j)
+					charge = -charge;
+				dot = _refVectors[k] * move.fractional(i, j);
+				cosChange += charge * cos(dot);
+				sinChange += charge * sin(dot);
+			}
+		}
+		recip += _refFactors[k] * (cosChange * (2 * _refCos[k] + cosChange) + sinChange * (2 * _refSin[k] + sinChange));
+	}
+	res += recip / 2;
+	
+	// Self and charged cell terms
+	res -= chargeSquaredChange * _refAlpha / (4 * pow(Constants::pi, 3.0/2.0) * _perm);
+	res -= chargeChange * (2 * _refCharge + chargeChange) / (8 * _perm * iso.basis().volume() * _refAlpha * _refAlpha);
+	
+	// Return energy change
+	return res;
+}
+
 /**
  * Compute the forces on each atom using 
  * @param iso [in] Structure being evaluated
@@ -280,6 +396,24 @@ void Ewald::computeForces(const ISO& iso, OList<Vector3D>* totalForces) const {
 	}
 }
 
+/**
+ * Return an estimate of the error in each pair term of the energy at the current precision
+ * 
+ * Real and reciprocal space terms are truncated where they fall below the accuracy relative to the bare
+ *  Coulomb interaction at the real space cutoff. This is the usual Ewald error estimate rather than a
+ *  strict bound, and it uses the cell of the last evaluation.
+ * @return Largest truncated term for the most highly charged pair (zero at full precision or before setup)
+ */
+double Ewald::errorEstimate() const {
+	if ((_precision != LP_SCREENING) || (_setupNumAtoms == -1))
+		return 0;
+	double maxCharge = 0;
+	for (int i = 0; i < _charges.length(); ++i)
+		maxCharge = Num<double>::max(maxCharge, fabs(_charges[i]));
+	double realCut = sqrt(-log(accuracy())) / _alpha;
+	return maxCharge * maxCharge * accuracy() / (4 * Constants::pi * _perm * realCut);
+}
+
 /**
  * Precompute parameters needed for the Ewald sum, such as:
  *  - Determining optimal mixing parameter (alpha)
@@ -291,6 +425,29 @@ void Ewald::computeForces(const ISO& iso, OList<Vector3D>* totalForces) const {
 void Ewald::initialize(const ISO& iso, int numUniqueAtoms) const
 {
 	
+	// Reuse the previous setup if the cell and number of atoms have not changed
+	int i, j;
+	if ((iso.numAtoms() == _setupNumAtoms) && (numUniqueAtoms == _setupNumUnique))
+	{
+		bool same = true;
+		for (i = 0; (same) && (i < 3); ++i)
+		{
+			for (j = 0; j < 3; ++j)
+			{
+				if (iso.basis().vectors()(i, j) != _setupVectors(i, j))
+				{
+					same = false;
+					break;
+				}
+			}
+		}
+		if (same)
+			return;
+	}
+	_setupNumAtoms = iso.numAtoms();
+	_setupNumUnique = numUniqueAtoms;
+	_setupVectors = iso.basis().vectors();
+	
 	// Set alpha value
 	double w = 0.05;
 	if (numUniqueAtoms > 400)
@@ -300,7 +457,7 @@ void Ewald::initialize(const ISO& iso, int numUniqueAtoms) const
 	_alpha = sqrt(Constants::pi) * pow(w * iso.numAtoms(), 1.0/6.0) / pow(iso.basis().volume(), 1.0/3.0);
 	
 	// Set cutoffs
-	double sqrtLogAcc = sqrt(-log(_accuracy));
+	double sqrtLogAcc = sqrt(-log(accuracy()));
     double realCut = sqrtLogAcc / _alpha;
     double recipCut = 2 * _alpha * sqrtLogAcc;
 	
@@ -325,7 +482,7 @@ void Ewald::initialize(const ISO& iso, int numUniqueAtoms) const
 	}
 	
 	// Save the prefactors needed in reciprocal space energy evaluation
-	int i = 0;
+	i = 0;
 	double magSquared;
 	Vector3D tempVec;
 	_recipFactors.length(_recipVectors.length());
@@ -356,9 +513,9 @@ double Ewald::realEnergy(const ISO& iso, Atom* atom, bool skipLowerAtoms) const
 	
 	// Evaluate the real space term
 	int i, j;
-	double real = 0;
 	double curCharge;
-	double tempEnergy;
+	Accumulator real;
+	Accumulator tempEnergy;
 	for (i = 0; i < iso.atoms().length(); ++i)
 	{
 		
@@ -368,7 +525,7 @@ double Ewald::realEnergy(const ISO& iso, Atom* atom, bool skipLowerAtoms) const
 			continue;
 		
 		// Loop over atoms of current element
-		tempEnergy = 0;
+		tempEnergy.clear();
 		for (j = 0; j < iso.atoms()[i].length(); ++j)
 		{
 			
@@ -404,11 +561,11 @@ double Ewald::realEnergy(const ISO& iso, Atom* atom, bool skipLowerAtoms) const
 		}
 		
 		// Add energy for previous set of atoms
-		real += atomCharge * curCharge * tempEnergy;
+		real += atomCharge * curCharge * tempEnergy.value();
 	}
 	
 	// Return the real energy
-	return real / (4 * Constants::pi * _perm);
+	return real.value() / (4 * Constants::pi * _perm);
 }
 
 /**
@@ -468,7 +625,7 @@ double Ewald::recipEnergy(const ISO& iso) const {
 	double charge;
 	double cosTerm;
 	double sinTerm;
-	double localRecip = 0;
+	List<double> terms(_recipFactors.length(), 0.0);
 	Linked<Vector3D >::iterator itVector = _recipVectors.begin();
 	for (i = 0; itVector != _recipVectors.end(); ++itVector, ++i)
 	{
@@ -499,22 +656,12 @@ double Ewald::recipEnergy(const ISO& iso) const {
 			}
 		}
 		
-		// Add energy
-		localRecip += _recipFactors[i] * (cosTerm*cosTerm + sinTerm*sinTerm);
+		// Save energy
+		terms[i] = _recipFactors[i] * (cosTerm*cosTerm + sinTerm*sinTerm);
 	}
 	
-	// Send energy between processors
-	double temp;
-	double recip = 0;
-	for (i = 0; i < Multi::worldSize(); ++i)
-	{
-		temp = localRecip;
-		Multi::broadcast(temp, i);
-		recip += temp;
-	}
-
-	// Return energy
-	return recip / 2;
+	// Sum energy over processors
+	return Multi::sum(terms) / 2;
 }
 
 /**
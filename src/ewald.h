@@ -53,6 +53,7 @@ protected:
 	// General variables
 	double _perm;
 	double _accuracy;
+	double _screenAccuracy;
 	
 	// Helper variables
 	// Mixing parameter between short/long range terms
@@ -61,6 +62,20 @@ protected:
 	// For each recipVector, 1/(e_0*V*|k|^2) * exp(-|k|^2/4/alpha^2)
 	mutable List<double> _recipFactors; 
 	mutable Linked<Vector3D > _recipVectors;
+	// Cell and number of atoms used in the last setup
+	mutable int _setupNumAtoms;
+	mutable int _setupNumUnique;
+	mutable Matrix3D _setupVectors;
+	
+	// Reference state for local moves
+	// Alpha, reciprocal vectors, prefactors and structure factor of the committed structure
+	mutable double _refAlpha;
+	mutable double _refCharge;
+	mutable List<double> _refFactors;
+	mutable List<Vector3D > _refVectors;
+	mutable List<double> _refCos;
+	mutable List<double> _refSin;
+	mutable NeighborList _reference;
 	
 	// Functions
 	void initialize(const ISO& iso, int numUniqueAtoms) const;
@@ -72,14 +87,18 @@ protected:
 	double selfEnergy(const ISO& iso) const;
 	double chargedEnergy(const ISO& iso) const;
 	double realEnergy(double distance) const	{ return erfc(_alpha * distance) / distance; }
+	double accuracy() const
+		{ return ((_precision == LP_SCREENING) && (_accuracy < _screenAccuracy)) ? _screenAccuracy : _accuracy; }
 	
 	// Helper functions
 	double getCharge(const Element& element) const;
+	double interaction(const Element& elem1, const Element& elem2, double distance) const
+		{ return getCharge(elem1) * getCharge(elem2) * erfc(_refAlpha * distance) / (distance * 4 * Constants::pi * _perm); }
 	
 public:
 	
 	// Constructor
-	Ewald()	{ _perm = Constants::eps0; _accuracy = 1e-8; }
+	Ewald()	{ _perm = Constants::eps0; _accuracy = 1e-8; _screenAccuracy = 1e-4; _refAlpha = 1; _refCharge = 0; _setupNumAtoms = -1; }
 	
 	// Setup by file input
 	void set(const Text& input);
@@ -88,6 +107,15 @@ public:
 	void evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const;
 	void evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, \
 		OList<Vector3D >* totalForces) const;
+	
+	// Energy changes for local moves
+	void commit(const ISO& iso) const;
+	double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+	
+	// Precision (screening uses a lower accuracy and so shorter real and reciprocal space cutoffs)
+	void precision(LocalPrecision input)
+		{ if (input != _precision) { _setupNumAtoms = -1; _committed = 0; } _precision = input; }
+	double errorEstimate() const;
 };
 
 
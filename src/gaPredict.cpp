@@ -28,6 +28,7 @@
 #include "output.h"
 #include "num.h"
 #include "settings.h"
+#include "phonons.h"
 
 
 
@@ -165,6 +166,13 @@ void GAPredict::run(ISO& iso, Random& random, bool restartable,
 			Output::quit();
 	}
 	
+	// Clear stored free energies
+	_freeCacheAtoms.length(0);
+	_freeCacheEnergy.length(0);
+	_freeCacheVolume.length(0);
+	_freeCacheValue.length(0);
+	_freeCacheUnstable.length(0);
+	
 	// Setup GA metrics
 	_ga.metricToOptimize(metToOptNumber);
 	_ga.numMetrics(_metrics.length());
@@ -380,6 +388,10 @@ void GAPredict::run(ISO& iso, Random& random, bool restartable,
 			}
 			Output::quietOff();
 			
+			// Add vibrational free energies if needed
+			if ((metToOpt == GAPM_POTENTIAL) && (_freeEnergyNum > 0))
+				addFreeEnergies(metToOptNumber);
+			
 			// Output
 			Output::decrease();
 			
@@ -499,17 +511,108 @@ void GAPredict::mutateBasis(ISOSymmetryPair& pair, Random& random) {
 
 /**
  * Mutate the positions of atoms in a structure
+ * 
+ * If more than one trial is requested and the energy is computed with a local potential, the displacement
+ *  of each orbit is picked from several random trials using the energy change of the moved atoms only.
  * @param pair [in/out] ISO and symmetry describing a structure. Will be mutated
  * @param random [in/out] Random number generator
  */
 void GAPredict::mutatePositions(ISOSymmetryPair& pair, Random& random) {
 	Output::quietOn();
-	RandomStructure::perturbAtoms(pair.iso(), pair.symmetry(), .1, .5, random);
+	if ((_posTrials > 1) && (_potential) && (_potential->local()))
+		perturbOrbits(pair, *_potential->local(), .1, .5, random);
+	else
+		RandomStructure::perturbAtoms(pair.iso(), pair.symmetry(), .1, .5, random);
 	Output::quietOff();
 }
 
 
 
+/**
+ * Perturb atoms while preserving symmetry, keeping the lowest energy of several trial displacements of each orbit
+ * 
+ * Each trial is a local move of the atoms in one orbit, so its energy is found from the interactions of those
+ *  atoms with the reference saved by the potential. The reference is saved again after each accepted move
+ *  since the structure revision changes.
+ * @param pair [in/out] ISO and symmetry describing a structure. Will be mutated
+ * @param local [in] Potential used to compute energy changes
+ * @param min [in] Minimum displacement (Ang)
+ * @param max [in] Maximum displacement (Ang)
+ * @param random [in/out] Random number generator
+ */
+void GAPredict::perturbOrbits(ISOSymmetryPair& pair, const LocalPotential& local, double min, double max, \
+		Random& random) {
+	
+	// Loop over orbits
+	int i, j, k;
+	double mag;
+	double norm;
+	double delta;
+	double bestDelta;
+	bool found;
+	Vector3D vector;
+	Vector3D position;
+	Vector3D bestPosition;
+	for (i = 0; i < pair.symmetry().orbits().length(); ++i) {
+		const Orbit& orbit = pair.symmetry().orbits()[i];
+		
+		// Stop if any atom in orbit is fixed
+		if (orbit.anyAtomsFixed())
+			break;
+		
+		// Loop over trial displacements
+		found = false;
+		bestDelta = 0;
+		for (j = 0; j < _posTrials; ++j) {
+			
+			// Random direction constrained by site symmetry with a random magnitude
+			mag = (min == max) ? min : random.decimal(min, max);
+			for (k = 0; k < 3; ++k)
+				vector[k] = random.decimal(-1, 1);
+			vector *= orbit.specialPositions()[0].rotation();
+			pair.iso().basis().toCartesian(vector);
+			norm = vector.magnitude();
+			if (!norm)
+				continue;
+			vector *= mag / norm;
+			position = orbit.atoms()[0]->cartesian() + vector;
+			pair.iso().basis().toFractional(position);
+			
+			// Save trial if it has the lowest energy
+			delta = local.deltaEnergy(pair.iso(), orbitMove(pair.iso(), orbit, position));
+			if ((!found) || (delta < bestDelta)) {
+				found = true;
+				bestDelta = delta;
+				bestPosition = position;
+			}
+		}
+		
+		// Apply the best trial
+		if (found)
+			orbitMove(pair.iso(), orbit, bestPosition).apply(pair.iso());
+	}
+}
+
+
+
+/**
+ * Build a local move that places the first atom of an orbit at a position and equivalent atoms at their images
+ * @param iso [in] Structure that contains the orbit
+ * @param orbit [in] Orbit to move
+ * @param position [in] New fractional position of the first atom in the orbit
+ * @return Move of every atom in the orbit
+ */
+LocalMove GAPredict::orbitMove(const ISO& iso, const Orbit& orbit, const Vector3D& position) {
+	LocalMove move(iso);
+	move.displace(orbit.atoms()[0]->atomNumber(), position);
+	for (int i = 1; i < orbit.atoms().length(); ++i)
+		move.displace(orbit.atoms()[i]->atomNumber(), orbit.generators()[i].rotation() * position + \
+			orbit.generators()[i].translations()[0]);
+	return move;
+}
+
+
+
 /**
  * Mutate which Wyckoff positions are occupied
  * @param pair [in/out] ISO and symmetry describing a structure. Will be mutated
@@ -1040,7 +1143,153 @@ void GAPredict::recurseOrbits(Linked<List<int> >& allowedGroups, const List<int>
 
 
 
+/**
+ * Add harmonic vibrational free energies to the static energies of the best candidates in the population
+ * 
+ * Only the lowest energy candidates are evaluated. All others receive the largest vibrational contribution
+ * found among those so that they are never favored by a missing term. Candidates with imaginary modes are
+ * dynamically unstable and have no harmonic free energy, so they are ranked after every other candidate
+ * in order of their static energy.
+ * @param metricNumber [in] Index of the energy in the fitness values
+ */
+void GAPredict::addFreeEnergies(int metricNumber) {
+	
+	// Order candidates by static energy
+	int i, j;
+	List<double>& values = _ga.fitness().values()[metricNumber];
+	List<int> order(values.length());
+	for (i = 0; i < order.length(); ++i) {
+		for (j = i; (j > 0) && (values[order[j-1]] > values[i]); --j)
+			order[j] = order[j-1];
+		order[j] = i;
+	}
+	
+	// Output
+	int numToEval = Num<int>::min(_freeEnergyNum, order.length());
+	Output::newline();
+	Output::print("Calculating vibrational free energies of ");
+	Output::print(numToEval);
+	Output::print(" lowest energy structure");
+	if (numToEval != 1)
+		Output::print("s");
+	Output::increase();
+	
+	// Get free energies of best structures
+	bool found = false;
+	bool curUnstable;
+	double curFree;
+	double maxFree = 0;
+	List<bool> unstable(order.length());
+	unstable.fill(false);
+	for (i = 0; i < numToEval; ++i) {
+		curFree = vibrationalFreeEnergy(_ga.population()[order[i]], values[order[i]], curUnstable);
+		
+		// Structure is dynamically unstable
+		Output::newline();
+		Output::print("Structure ");
+		Output::print(order[i] + 1);
+		if (curUnstable) {
+			unstable[i] = true;
+			Output::print(": Unstable (imaginary modes), ranked after all stable structures");
+			continue;
+		}
+		
+		// Save value
+		if ((!found) || (curFree > maxFree))
+			maxFree = curFree;
+		found = true;
+		values[order[i]] += curFree;
+		
+		// Print value
+		Output::print(": Free energy of ");
+		Output::print(values[order[i]]);
+		Output::print(" eV (vibrational contribution of ");
+		Output::print(curFree);
+		Output::print(" eV)");
+	}
+	
+	// Set remaining structures
+	for (i = numToEval; i < order.length(); ++i)
+		values[order[i]] += maxFree;
+	
+	// Place unstable structures after the worst stable structure, keeping their order by static energy
+	double worst = 0;
+	double lowestUnstable = 0;
+	bool foundStable = false;
+	bool foundUnstable = false;
+	for (i = 0; i < order.length(); ++i) {
+		if (unstable[i]) {
+			if (!foundUnstable)
+				lowestUnstable = values[order[i]];
+			foundUnstable = true;
+		}
+		else if ((!foundStable) || (values[order[i]] > worst)) {
+			worst = values[order[i]];
+			foundStable = true;
+		}
+	}
+	for (i = 0; (foundStable) && (i < order.length()); ++i) {
+		if (unstable[i])
+			values[order[i]] += worst - lowestUnstable + _energyTolerance * _ga.population()[order[i]].iso().numAtoms();
+	}
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/**
+ * Get the harmonic vibrational free energy of a structure
+ * 
+ * Structures that survive between generations are matched against previous results by their number of atoms,
+ * static energy, and volume so that their force constants are only calculated once.
+ * @param pair [in/out] Structure to evaluate
+ * @param energy [in] Static energy of the structure
+ * @param unstable [out] Whether the structure has imaginary modes (the returned value is then meaningless)
+ * @return Vibrational free energy (eV)
+ */
+double GAPredict::vibrationalFreeEnergy(ISOSymmetryPair& pair, double energy, bool& unstable) {
+	
+	// Check if structure has already been evaluated
+	int i;
+	double volume = pair.iso().basis().volume();
+	for (i = 0; i < _freeCacheValue.length(); ++i) {
+		if (_freeCacheAtoms[i] != pair.iso().numAtoms())
+			continue;
+		if (Num<double>::abs(_freeCacheEnergy[i] - energy) > 1e-6 * pair.iso().numAtoms())
+			continue;
+		if (Num<double>::abs(_freeCacheVolume[i] - volume) > 1e-5 * volume)
+			continue;
+		unstable = _freeCacheUnstable[i];
+		return _freeCacheValue[i];
+	}
+	
+	// Calculate force constants from symmetry reduced displacements and get free energy on coarse mesh
+	Output::quietOn();
+	Phonons phonons;
+	phonons.writeForceConstantsFile(false);
+	phonons.generateForceConstants(pair.iso(), pair.symmetry(), *_potential, Word());
+	int numImaginary;
+	double value = phonons.freeEnergy(_freeEnergyTemp, _freeEnergyMesh, &pair.symmetry(), &numImaginary);
+	unstable = (numImaginary > 0);
+	Output::quietOff();
+	
+	// Save result
+	_freeCacheAtoms += pair.iso().numAtoms();
+	_freeCacheEnergy += energy;
+	_freeCacheVolume += volume;
+	_freeCacheValue += value;
+	_freeCacheUnstable += unstable;
+	return value;
+}
+
+
+
 /* Return the static value of the current screening function
+ *
+ * Local potentials are evaluated at screening precision, since the child that is kept is relaxed at full
+ *	precision when the fitness of the population is computed
  */
 
 double GAPredict::screen(ISOSymmetryPair& pair)
@@ -1048,7 +1297,15 @@ double GAPredict::screen(ISOSymmetryPair& pair)
 	Output::quietOn(true);
 	double value = 0;
 	if (_screenMetric == GAPM_POTENTIAL)
+	{
+		LocalPotential* local = _potential->local();
+		LocalPrecision origPrecision = (local) ? local->precision() : LP_FULL;
+		if (local)
+			local->precision(LP_SCREENING);
 		_potential->single(pair.iso(), pair.symmetry(), &value, 0, false, true);
+		if (local)
+			local->precision(origPrecision);
+	}
 	else if (_screenMetric == GAPM_DIFFRACTION)
 		value = _diffraction->set(pair.iso(), pair.symmetry(), _refDiffraction, _userietveld, true);
 	Output::quietOff();
@@ -29,6 +29,7 @@
 #include "iso.h"
 #include "symmetry.h"
 #include "potential.h"
+#include "locPotential.h"
 #include "diffraction.h"
 #include "random.h"
 #include "text.h"
@@ -74,10 +75,14 @@ class GAPredict
 	double _cellMutationProb;
 	double _posMutationProb;
 	double _wyckMutationProb;
+	int _posTrials; // Number of trial displacements of each orbit in position mutations
 	double _energyTolerance;
 	double _diffractionTolerance;
 	bool _userietveld;
 	bool _saveAllResults; // Whether to print out each candidate structure
+	int _freeEnergyNum; // Number of best candidates ranked by free energy (0 to use static energy)
+	double _freeEnergyTemp;
+	int _freeEnergyMesh;
 	GAPredictMetric _optMetric;
 	GAPredictMetric _screenMetric;
 	
@@ -85,6 +90,13 @@ class GAPredict
 	GeneticAlgorithm<ISOSymmetryPair, GAPredict> _ga;
 	List<GAPredictMetric> _metrics;
 	
+	// Free energies of structures that have already been evaluated
+	List<int> _freeCacheAtoms;
+	List<double> _freeCacheEnergy;
+	List<double> _freeCacheVolume;
+	List<double> _freeCacheValue;
+	List<bool> _freeCacheUnstable;
+	
 	// Storage
 	Potential* _potential;
 	CalculatedPattern* _diffraction;
@@ -96,6 +108,8 @@ class GAPredict
 	// Mutation functions
 	void mutateBasis(ISOSymmetryPair& pair, Random& random);
 	void mutatePositions(ISOSymmetryPair& pair, Random& random);
+	void perturbOrbits(ISOSymmetryPair& pair, const LocalPotential& local, double min, double max, Random& random);
+	static LocalMove orbitMove(const ISO& iso, const Orbit& orbit, const Vector3D& position);
 	void mutateWyckoff(ISOSymmetryPair& pair, Random& random);
 	
 	// Crossover functions
@@ -111,6 +125,10 @@ class GAPredict
 	
 	void saveResult(int entry);
 	
+	// Free energy functions
+	void addFreeEnergies(int metricNumber);
+	double vibrationalFreeEnergy(ISOSymmetryPair& pair, double energy, bool& unstable);
+	
 public:
 	
 	// Constructor
@@ -125,6 +143,7 @@ public:
 	void cellMutationProbability(double input)		{ _cellMutationProb = input; }
 	void positionMutationProbability(double input)	{ _posMutationProb = input; }
 	void wyckoffMutationProbability(double input)	{ _wyckMutationProb = input; }
+	void positionTrials(int input)					{ _posTrials = input; }
 	void metricToOptimize(GAPredictMetric input)	{ _optMetric = input; }
 	void metricToScreen(GAPredictMetric input)		{ _screenMetric = input; }
 	void energyTolerance(double input)				{ _energyTolerance = input; }
@@ -135,6 +154,13 @@ public:
      * @param input Desired setting
      */
 	void setSaveAllResults(bool input)				{ _saveAllResults = input; }
+	/**
+	 * Set number of best candidates in each generation that are ranked by their harmonic free energy
+	 * @param input Number of candidates (0 to rank by static energy only)
+	 */
+	void freeEnergyNumber(int input)				{ _freeEnergyNum = input; }
+	void freeEnergyTemperature(double input)		{ _freeEnergyTemp = input; }
+	void freeEnergyMesh(int input)					{ _freeEnergyMesh = input; }
 	
 	// GA settings functions
 	void populationSize(int input)	{ _ga.populationSize(input); }
@@ -173,11 +199,18 @@ inline GAPredict::GAPredict() {
 	_cellMutationProb = 0.1;
 	_posMutationProb = 0.1;
 	_wyckMutationProb = 0.1;
+	_posTrials = 1;
 	_optMetric = GAPM_UNKNOWN;
 	_screenMetric = GAPM_UNKNOWN;
 	_energyTolerance = 1e-3;
 	_diffractionTolerance = 1e-4;
 	_saveAllResults = false;
+	_freeEnergyNum = 0;
+	_freeEnergyTemp = 300;
+	_freeEnergyMesh = 2;
+	_potential = 0;
+	_diffraction = 0;
+	_refDiffraction = 0;
 }
 
 
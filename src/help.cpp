@@ -223,6 +223,8 @@ void Help::functions()
 	Output::newline(); Output::print("    -interstitial   Generate interstitial sites in the structure");
 	Output::newline(); Output::print("          -energy   Calculate energy of the structure under supplied potential");
 	Output::newline(); Output::print("          -forces   Calculate forces on all atoms under supplied potential");
+	Output::newline(); Output::print("              -md   Run molecular dynamics under supplied potential");
+	Output::newline(); Output::print("             -fit   Fit pair potential parameters to a training set");
 	Output::newline(); Output::print("     -diffraction   Calculate diffraction patterns and R factors");
 	Output::newline(); Output::print("        -optimize   Global optimization of the structure to minimize energy");
 	Output::newline(); Output::print("         -compare   Compare two structures to determine if they are similar");
@@ -835,6 +837,65 @@ void Help::functions()
 	Output::newline();
 	Output::newline();
 	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" -md");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Run molecular dynamics on a structure under a supplied internal");
+	Output::newline(); Output::print("    potential. Equations of motion are integrated with velocity Verlet and the");
+	Output::newline(); Output::print("    temperature is controlled by a Langevin or Nose-Hoover thermostat, or the");
+	Output::newline(); Output::print("    simulation is run in the NVE ensemble. If two temperatures are passed then");
+	Output::newline(); Output::print("    the target temperature is ramped linearly between them, which can be used");
+	Output::newline(); Output::print("    for simulated annealing. The final structure is printed after the run. The");
+	Output::newline(); Output::print("    number of steps, time step, damping time, and print frequencies are set");
+	Output::newline(); Output::print("    with the md settings (see -help settings).");
+	Output::newline();
+	Output::newline(); Output::print("Arguments:");
+	Output::newline(); Output::print("    One or two numbers to set the start and end temperatures (in K)");
+	Output::newline(); Output::print("    \"langevin\", \"nose-hoover\" (or \"nvt\"), or \"nve\" to set the thermostat");
+	Output::newline(); Output::print("    One of the formats in \"-print\" to write the trajectory to file");
+	Output::newline();
+	Output::newline(); Output::print("Default: Langevin thermostat at 300 K without a trajectory file");
+	Output::newline();
+	Output::newline(); Output::print("Examples:");
+	Output::newline(); Output::print("    \"mint str pot -md\"             run at 300 K with a Langevin thermostat");
+	Output::newline(); Output::print("    \"mint str pot -md 1000 nvt\"    run at 1000 K with a Nose-Hoover thermostat");
+	Output::newline(); Output::print("    \"mint str pot -md 2000 300\"    anneal from 2000 K to 300 K");
+	Output::newline(); Output::print("    \"mint str pot -md nve vasp\"    run in the NVE ensemble, write vasp trajectory");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" -fit");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Fit the parameters of the pair potentials in a supplied internal");
+	Output::newline(); Output::print("    potential to a training set of energies, forces and stresses. All pair");
+	Output::newline(); Output::print("    potentials with free parameters are fit with the Levenberg-Marquardt");
+	Output::newline(); Output::print("    algorithm, while the remaining potentials are held fixed. The fitted");
+	Output::newline(); Output::print("    potentials are printed in the format of a potential file.");
+	Output::newline();
+	Output::newline(); Output::print("    The training set file contains the following lines:");
+	Output::newline(); Output::print("        weights <energy> <force> [stress]   weights of each type of error");
+	Output::newline(); Output::print("        tolerance <value>                   convergence of the fit");
+	Output::newline(); Output::print("        structure <file> energy <value> [forces <file>] [stress <6 values>]");
+	Output::newline(); Output::print("            [weight <value>]                one training structure");
+	Output::newline(); Output::print("    A forces file has one line per atom with the three cartesian components");
+	Output::newline(); Output::print("    of the force (in eV/Ang) in the order of atoms in the structure file.");
+	Output::newline(); Output::print("    Stresses are in eV/Ang^3 in the order xx yy zz yz xz xy.");
+	Output::newline();
+	Output::newline(); Output::print("Arguments:");
+	Output::newline(); Output::print("    Name of the training set file (required)");
+	Output::newline(); Output::print("    Name of the file to write the fitted potentials to");
+	Output::newline();
+	Output::newline(); Output::print("Default: Fitted potentials are printed to standard output");
+	Output::newline();
+	Output::newline(); Output::print("Examples:");
+	Output::newline(); Output::print("    \"mint pot -fit train\"          fit pot to the training set in train");
+	Output::newline(); Output::print("    \"mint pot -fit train pot.fit\"  write the fitted potentials to pot.fit");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
 	Output::newline(); Output::print(" -diffraction");
 	Output::newline(); Output::print("================================================================================");
 	Output::newline();
@@ -1037,6 +1098,7 @@ void Help::settings()
 	Output::newline(); Output::print("     addextension   Add a file extension when printing a structure to file");
 	Output::newline(); Output::print("  randstrmaxloops   Maximum number of loops when generating a random structure");
 	Output::newline(); Output::print("   randstrminbond   Minimum random bond length");
+	Output::newline(); Output::print("    randompackage   Random number generator used in the calculation");
 	Output::newline(); Output::print("      gaoptnumsim   Number of unique runs during GA optimization");
 	Output::newline(); Output::print("     gaoptpopsize   Number of structure in GA optimization");
 	Output::newline(); Output::print(" gaoptcellmutprob   Probability of cell mutation in GA optimization");
@@ -1051,11 +1113,20 @@ void Help::settings()
 	Output::newline(); Output::print("     gaoptdifftol   Tolerance for an r-factor to be a new best during GA");
 	Output::newline(); Output::print("gaoptscreenmethod   Screening method used during GA optimization");
 	Output::newline(); Output::print("   gaoptscreennum   Number of trial structures to screen during GA");
+	Output::newline(); Output::print("     gaoptfreenum   Number of structures ranked by free energy during GA");
+	Output::newline(); Output::print("    gaoptfreetemp   Temperature of free energies during GA");
+	Output::newline(); Output::print("    gaoptfreemesh   Size of q-point mesh for free energies during GA");
+	Output::newline(); Output::print("   gaoptpostrials   Trial displacements per orbit in GA position mutations");
 	Output::newline(); Output::print("      wyckoffbias   Biasing level for choosing random Wyckoff positions");
 	Output::newline(); Output::print("      minimagedis   Minimum image distance when generating supercells");
 	Output::newline(); Output::print("  maxjumpdistance   Maximum jump distance when generating jumps between sites");
 	Output::newline(); Output::print("  kmcjumpsperatom   Number of jumps in a KMC simulation per atom");
 	Output::newline(); Output::print("      kmcconverge   Convergence for a KMC simulation to be complete");
+	Output::newline(); Output::print("          mdsteps   Number of steps in a molecular dynamics simulation");
+	Output::newline(); Output::print("       mdtimestep   Time step of a molecular dynamics simulation");
+	Output::newline(); Output::print("        mddamping   Damping time of molecular dynamics thermostats");
+	Output::newline(); Output::print("      mdprintfreq   Number of molecular dynamics steps between printing");
+	Output::newline(); Output::print("       mdtrajfreq   Number of molecular dynamics steps between trajectory frames");
 	Output::newline();
 	Output::newline();
 	Output::newline();
@@ -1302,6 +1373,22 @@ void Help::settings()
 	Output::newline();
 	Output::newline();
 	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" randompackage");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Set the random number generator used for random structures, GA");
+	Output::newline(); Output::print("    optimization, kinetic Monte Carlo, and molecular dynamics. The Mersenne");
+	Output::newline(); Output::print("    twister is the standard generator. Philox is a counter-based generator");
+	Output::newline(); Output::print("    (Philox4x32-10) that fills lists of random numbers in blocks and can jump");
+	Output::newline(); Output::print("    ahead in its sequence without generating the values in between.");
+	Output::newline();
+	Output::newline(); Output::print("Values: mersenne or philox");
+	Output::newline();
+	Output::newline(); Output::print("Default: mersenne");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
 	Output::newline(); Output::print(" gaoptnumsim");
 	Output::newline(); Output::print("================================================================================");
 	Output::newline();
@@ -1520,6 +1607,10 @@ void Help::settings()
 	Output::newline(); Output::print("    gaoptscreenmethod is accepted as the child. The selected children are");
 	Output::newline(); Output::print("    relaxed locally using whichever metric is being optimized in the simulation.");
 	Output::newline();
+	Output::newline(); Output::print("    When screening by energy with a local potential, candidates are evaluated");
+	Output::newline(); Output::print("    at a reduced precision (tabulated pair energies and a looser Ewald");
+	Output::newline(); Output::print("    accuracy). The selected children are still relaxed at full precision.");
+	Output::newline();
 	Output::newline(); Output::print("    In order for a screen to be applied, gaoptscreenmethod must be set and");
 	Output::newline(); Output::print("    gaoptscreennum must have a non-zero value. If one or neither of these are");
 	Output::newline(); Output::print("    true, then a screen is not used.");
@@ -1547,6 +1638,71 @@ void Help::settings()
 	Output::newline();
 	Output::newline();
 	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" gaoptfreenum");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of structures in each generation of a GA-based structure");
+	Output::newline(); Output::print("    prediction whose fitness is the harmonic free energy instead of the static");
+	Output::newline(); Output::print("    energy. After relaxation, the gaoptfreenum lowest energy structures are");
+	Output::newline(); Output::print("    evaluated using force constants from symmetry-reduced displacements and a");
+	Output::newline(); Output::print("    q-point mesh reduced by symmetry. Structures that survive from one");
+	Output::newline(); Output::print("    generation to the next are not recalculated. All other structures receive");
+	Output::newline(); Output::print("    the largest vibrational contribution found in the generation. Structures");
+	Output::newline(); Output::print("    with imaginary modes are dynamically unstable and are ranked after all");
+	Output::newline(); Output::print("    other structures. Only used when the energy is optimized. See also");
+	Output::newline(); Output::print("    gaoptfreetemp and gaoptfreemesh.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any integer number");
+	Output::newline();
+	Output::newline(); Output::print("Default: 0 (structures are ranked by static energy)");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" gaoptfreetemp");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Temperature at which vibrational free energies are calculated when");
+	Output::newline(); Output::print("    gaoptfreenum is non-zero. A value of zero includes only the zero point");
+	Output::newline(); Output::print("    energy.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any floating point number (in units of K)");
+	Output::newline();
+	Output::newline(); Output::print("Default: 300");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" gaoptfreemesh");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of q-points along each reciprocal lattice vector in the");
+	Output::newline(); Output::print("    gamma-centered mesh used to calculate vibrational free energies when");
+	Output::newline(); Output::print("    gaoptfreenum is non-zero.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any positive integer number");
+	Output::newline();
+	Output::newline(); Output::print("Default: 2");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" gaoptpostrials");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of random displacements tried for each set of equivalent");
+	Output::newline(); Output::print("    atoms when positions are mutated during a GA-based structure prediction.");
+	Output::newline(); Output::print("    When greater than one and the energy is calculated with an internal");
+	Output::newline(); Output::print("    potential, the displacement that lowers the energy the most is kept. The");
+	Output::newline(); Output::print("    energy change of each trial is found from the moved atoms only.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any positive integer number");
+	Output::newline();
+	Output::newline(); Output::print("Default: 1 (a single random displacement)");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
 	Output::newline(); Output::print(" wyckoffbias");
 	Output::newline(); Output::print("================================================================================");
 	Output::newline();
@@ -1631,6 +1787,73 @@ void Help::settings()
 	Output::newline(); Output::print("Values: Any floating point number (in units of percent)");
 	Output::newline();
 	Output::newline(); Output::print("Default: 0.5");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" mdsteps");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of steps to run in a molecular dynamics simulation.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any positive integer");
+	Output::newline();
+	Output::newline(); Output::print("Default: 1000");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" mdtimestep");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Time step used to integrate the equations of motion in a molecular");
+	Output::newline(); Output::print("    dynamics simulation.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any positive floating point number (in units of fs)");
+	Output::newline();
+	Output::newline(); Output::print("Default: 1.0");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" mddamping");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Damping time of the thermostat in a molecular dynamics simulation. This");
+	Output::newline(); Output::print("    is the velocity relaxation time of the Langevin thermostat and the period of");
+	Output::newline(); Output::print("    the Nose-Hoover thermostat. It is not used in NVE simulations.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any positive floating point number (in units of fs)");
+	Output::newline();
+	Output::newline(); Output::print("Default: 100.0");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" mdprintfreq");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of steps between printing energies and temperatures during a");
+	Output::newline(); Output::print("    molecular dynamics simulation. Values less than one turn off printing.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any integer number");
+	Output::newline();
+	Output::newline(); Output::print("Default: 100");
+	Output::newline();
+	Output::newline();
+	Output::newline();
+	Output::newline(); Output::print("================================================================================");
+	Output::newline(); Output::print(" mdtrajfreq");
+	Output::newline(); Output::print("================================================================================");
+	Output::newline();
+	Output::newline(); Output::print("General: Number of steps between frames written to the trajectory file during a");
+	Output::newline(); Output::print("    molecular dynamics simulation. Values less than one turn off the trajectory");
+	Output::newline(); Output::print("    unless a structure format is passed to -md, in which case mdprintfreq is");
+	Output::newline(); Output::print("    used.");
+	Output::newline();
+	Output::newline(); Output::print("Values: Any integer number");
+	Output::newline();
+	Output::newline(); Output::print("Default: 0");
 	
 	// Reset output method
 	Output::method(origMethod);
@@ -26,6 +26,11 @@
 
 
 
+// Last revision number given to any basis
+unsigned long int Basis::_lastRevision = 0;
+
+
+
 /* Basis& Basis::operator= (const Basis& rhs)
  *
  * Copy Basis object
@@ -50,7 +55,9 @@ Basis& Basis::operator= (const Basis& rhs)
 		_unitToReduced = rhs._unitToReduced;
 		_reducedPointToUnit = rhs._reducedPointToUnit;
 		_unitPointToReduced = rhs._unitPointToReduced;
+		_orthogonal = rhs._orthogonal;
 		_latticeSystem = rhs._latticeSystem;
+		touch();
 		for (int i = 0; i < 3; ++i)
 		{
 			_lengthFixed[i] = rhs._lengthFixed[i];
@@ -362,6 +369,12 @@ void Basis::finishSetup(bool showOutput)
 	_reducedPointToUnit = _unitToReduced.transpose();
 	_unitPointToReduced = _reducedPointToUnit.inverse();
 	
+	// Check if the reduced cell is orthogonal, in which case each direction of the nearest image can be found
+	// independently by rounding
+	double diagTol = 1e-12 * (_reducedMetric(0, 0) + _reducedMetric(1, 1) + _reducedMetric(2, 2));
+	_orthogonal = (Num<double>::abs(_reducedMetric(0, 1)) < diagTol) && \
+		(Num<double>::abs(_reducedMetric(0, 2)) < diagTol) && (Num<double>::abs(_reducedMetric(1, 2)) < diagTol);
+	
 	// Print volume
 	Output::newline();
 	Output::print("Volume: ");
@@ -448,6 +461,9 @@ void Basis::finishSetup(bool showOutput)
 	// Output
 	Output::decrease();
 	
+	// Structure has changed
+	touch();
+	
 	// Reset output
 	if (!showOutput)
 		Output::quietOff();
@@ -471,6 +487,22 @@ double Basis::distance(const Vector3D& pos1, CoordinateType type1, const Vector3
 	
     // Get the difference between points in fractional coordinates
 	_redDif = _unitPointToReduced * (_frac2 - _frac1);
+	
+	// Reduced cell is orthogonal so round each direction into (-1/2, 1/2]
+	if (_orthogonal)
+	{
+		for (_i = 0; _i < 3; ++_i)
+		{
+			_minCell[_i] = -Num<double>::ceil(_redDif[_i] - 0.5);
+			_curVec[_i] = _redDif[_i] + _minCell[_i];
+		}
+		_minDis = _reducedMetric(0, 0) * _curVec[0] * _curVec[0] + \
+				  _reducedMetric(1, 1) * _curVec[1] * _curVec[1] + \
+				  _reducedMetric(2, 2) * _curVec[2] * _curVec[2];
+		if (cell)
+			*cell = _reducedPointToUnit * _minCell;
+		return sqrt(_minDis);
+	}
 
 	// Set which cells should be searched
 	for (_i = 0; _i < 3; ++_i)
@@ -501,7 +533,7 @@ double Basis::distance(const Vector3D& pos1, CoordinateType type1, const Vector3
 				_curVec[0]  = _redDif[0] + _cellsToSearch[0][_i];
 				_curVec[1]  = _redDif[1] + _cellsToSearch[1][_j];
 				_curVec[2]  = _redDif[2] + _cellsToSearch[2][_k];
-				_curDis  = _curVec * (_reducedMetric * _curVec);
+				_curDis  = _reducedMetric.quadratic(_curVec);
 				
 				// Found a new minimum
 				if ((_first) || (_curDis < _minDis))
@@ -558,7 +590,7 @@ double Basis::secondDistance(const Vector3D& pos1, CoordinateType type1, const V
 				_curVec[0]  = _redDif[0] + _i;
 				_curVec[1]  = _redDif[1] + _j;
 				_curVec[2]  = _redDif[2] + _k;
-				_curDis  = _curVec * (_reducedMetric * _curVec);
+				_curDis  = _reducedMetric.quadratic(_curVec);
 				
 				// This is the first cell
 				if (_first)
@@ -641,6 +673,9 @@ Matrix3D Basis::reduced(const Matrix3D& vectors, Matrix3D* transformation)
 Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 {
 	
+	// Initialize transformation matrix to identity matrix
+	IMatrix3D transformation = IMatrix3D::identity();
+	
 	// Set the initial parameters
 	double A;
 	double B;
@@ -648,7 +683,8 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 	double ksi;
 	double eta;
 	double zeta;
-	NiggliParams(vectors, A, B, C, ksi, eta, zeta);
+	Matrix3D metric = vectors * vectors.transpose();
+	NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
 
 	// Minimum reduction variables
 	bool firstMinRedTest = true;
@@ -661,10 +697,6 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
     // Set initial tolerance
 	double eps = (1e-5) * pow(vectors.volume(), 1.0/3.0);
 
-    // Initialize transformation matrix to identity matrix
-	Matrix3D transformation;
-	transformation.makeIdentity();
-	
 	// Variables to control reduction
 	int maxLoops = 2500;
 	
@@ -680,7 +712,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 			((Num<double>::eq(A, B, eps)) && (Num<double>::gt(Num<double>::abs(ksi), Num<double>::abs(eta), eps))))
         {	
             updateTransformation(transformation, 0, -1, 0, -1, 0, 0, 0, 0, -1);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
         }
 
 		// Test 2
@@ -688,7 +720,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 			((Num<double>::eq(B, C, eps)) && (Num<double>::gt(Num<double>::abs(eta), Num<double>::abs(zeta), eps))))
         {
             updateTransformation(transformation, -1, 0, 0, 0, 0, -1, 0, -1, 0);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
             continue;
         }
 		
@@ -709,7 +741,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 		if (plusMin[0]*plusMin[1]*plusMin[2] == 1)
 		{
             updateTransformation(transformation, plusMin[0], 0, 0, 0, plusMin[1], 0, 0, 0, plusMin[2]);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
         }
 		
 		// Test 4
@@ -743,7 +775,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 					val[2] = -1;
 			}
             updateTransformation(transformation, val[0], 0, 0, 0, val[1], 0, 0, 0, val[2]);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
 
 			// Check minimum reduction
 			if (!firstMinRedTest)
@@ -771,7 +803,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
             ((Num<double>::eq(ksi, -B, eps)) && (Num<double>::lt(zeta, 0, eps))))
         {
             updateTransformation(transformation, 1, 0, 0, 0, 1, -Num<double>::sign(ksi), 0, 0, 1);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
             continue;
         }
 
@@ -781,7 +813,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
             ((Num<double>::eq(eta, -A, eps)) && (Num<double>::lt(zeta, 0, eps))))
 		{
             updateTransformation(transformation, 1, 0, -Num<double>::sign(eta), 0, 1, 0, 0, 0, 1);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
             continue;
         }
 
@@ -791,7 +823,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
             ((Num<double>::eq(zeta, -A, eps)) && (Num<double>::lt(eta, 0, eps))))
         {
             updateTransformation(transformation, 1, -Num<double>::sign(zeta), 0, 0, 1, 0, 0, 0, 1);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
             continue;
         }
 
@@ -800,7 +832,7 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 			((Num<double>::eq(ksi + eta + zeta + A + B, 0, eps)) && (Num<double>::gt(2*(A + eta) + zeta, 0, eps))))
         {
             updateTransformation(transformation, 1, 0, 1, 0, 1, 1, 0, 0, 1);
-			NiggliParams(transformation.transpose() * vectors, A, B, C, ksi, eta, zeta);
+			NiggliParams(metric, transformation, A, B, C, ksi, eta, zeta);
             continue;
         }
 
@@ -821,57 +853,49 @@ Matrix3D Basis::reducedTransformation(const Matrix3D& vectors)
 	}
 	
     // Save result as transpose of transformation matrix
-	return transformation.transpose();
+	return transformation.transpose().toDouble();
 }
 
 
 
-/* void Basis::NiggliParams(const Matrix3D& vectors, double& A, double& B, double& C, double& ksi,
- *		double& eta, double& zeta)
+/* void Basis::NiggliParams(const Matrix3D& metric, const IMatrix3D& transformation, double& A, double& B,
+ *		double& C, double& ksi, double& eta, double& zeta)
  *
- * Set the metrics used in Niggli reduction
+ * Set the metrics used in Niggli reduction from the metric of the original cell and the current integer
+ * transformation, which avoids the roundoff of recomputing lengths and angles from the vectors
  */
 
-void Basis::NiggliParams(const Matrix3D& vectors, double& A, double& B, double& C, double& ksi, \
-	double& eta, double& zeta)
+void Basis::NiggliParams(const Matrix3D& metric, const IMatrix3D& transformation, double& A, double& B, \
+	double& C, double& ksi, double& eta, double& zeta)
 {
 	
-	// Basis lengths
-	double a = sqrt(vectors(0, 0)*vectors(0, 0) + vectors(0, 1)*vectors(0, 1) + vectors(0, 2)*vectors(0, 2));
-    double b = sqrt(vectors(1, 0)*vectors(1, 0) + vectors(1, 1)*vectors(1, 1) + vectors(1, 2)*vectors(1, 2));
-    double c = sqrt(vectors(2, 0)*vectors(2, 0) + vectors(2, 1)*vectors(2, 1) + vectors(2, 2)*vectors(2, 2));
-
-	// Basis angles
-	Vector3D vec0(vectors(0, 0), vectors(0, 1), vectors(0, 2));
-	Vector3D vec1(vectors(1, 0), vectors(1, 1), vectors(1, 2));
-	Vector3D vec2(vectors(2, 0), vectors(2, 1), vectors(2, 2));
-	double alpha = vec1.angle(vec2);
-    double beta  = vec0.angle(vec2);
-    double gamma = vec0.angle(vec1);
+	// Get the metric of the current cell
+	Matrix3D trans = transformation.toDouble();
+	Matrix3D curMetric = trans.transpose() * metric * trans;
     
     // Set the main variables
-    A = a * a;
-    B = b * b;
-    C = c * c;
-    ksi =  2 * b * c * cos(alpha);
-    eta =  2 * a * c * cos(beta);
-    zeta = 2 * a * b * cos(gamma);
+    A = curMetric(0, 0);
+    B = curMetric(1, 1);
+    C = curMetric(2, 2);
+    ksi =  2 * curMetric(1, 2);
+    eta =  2 * curMetric(0, 2);
+    zeta = 2 * curMetric(0, 1);
 }
 
 
 
-/* void Basis::updateTransformation(Matrix3D& transformation, int m00, int m01, int m02, int m10, int m11,
+/* void Basis::updateTransformation(IMatrix3D& transformation, int m00, int m01, int m02, int m10, int m11,
  *		int m12, int m20, int m21, int m22)
  *
  * Update the transformation matrix during Niggli reduction
  */
 
-void Basis::updateTransformation(Matrix3D& transformation, int m00, int m01, int m02, int m10, int m11, \
+void Basis::updateTransformation(IMatrix3D& transformation, int m00, int m01, int m02, int m10, int m11, \
 	int m12, int m20, int m21, int m22)
 {
 	
 	// Form the transformation matrix
-	Matrix3D updateMatrix(m00, m01, m02, m10, m11, m12, m20, m21, m22);
+	IMatrix3D updateMatrix(m00, m01, m02, m10, m11, m12, m20, m21, m22);
 	if (updateMatrix.determinant() < 0)
 	{
 		Output::newline(ERROR);
@@ -1297,7 +1321,12 @@ void ISO::clear()
 	_comment.clear();
 	_atoms.clear();
 	_numAtoms = 0;
+	_atomElement.clear();
+	_atomIndex.clear();
+	_editing = false;
+	_editRemove.clear();
 	_spaceGroup.clear();
+	_basis.touch();
 }
 
 
@@ -1335,6 +1364,12 @@ ISO& ISO::operator= (const ISO& rhs)
 				_atoms[i][j].basis(&_basis);
 			}
 		}
+		
+		// Save atom locations and any pending edits
+		_atomElement = rhs._atomElement;
+		_atomIndex = rhs._atomIndex;
+		_editing = rhs._editing;
+		_editRemove = rhs._editRemove;
 	}
 	
 	// Return result
@@ -1817,14 +1852,15 @@ Atoms ISO::expand(const Matrix3D& transformation)
 	Atoms newAtoms(_atoms.length());
 	
 	// Loop over atoms in the orginal cell
-	int k, m;
-	bool found;
+	int k;
 	int pos;
 	Vector3D newPos;
+	PositionHash positions;
 	for (i = 0; i < _atoms.length(); ++i)
 	{
 		pos = 0;
 		newAtoms[i].length(points.length() * _atoms[i].length());
+		positions.set(_basis, 1e-4, newAtoms[i].length());
 		for (j = 0; j < _atoms[i].length(); ++j)
 		{
 			
@@ -1838,20 +1874,11 @@ Atoms ISO::expand(const Matrix3D& transformation)
 				newAtoms[i][pos].fractional(newPos);
 				
 				// Check if atom is already known
-				found = false;
-				for (m = 0; m < pos; ++m)
-				{
-					if (_basis.distance(newAtoms[i][pos].fractional(), FRACTIONAL, newAtoms[i][m].fractional(), \
-						FRACTIONAL) < 1e-4)
-					{
-						found = true;
-						break;
-					}
-				}
-				if (found)
+				if (positions.find(newAtoms[i][pos].fractional()) >= 0)
 					continue;
 				
 				// Go to next atom
+				positions.add(newAtoms[i][pos].fractional());
 				++pos;
 			}
 		}
@@ -1887,18 +1914,15 @@ Atoms ISO::contract(const Matrix3D& transformation, double tol)
 	// Variable to store results
 	Atoms newAtoms (_atoms.length());
 	List<int>::D2 timesFound (_atoms.length());
-	List<double>::D2 newDis (_atoms.length());
 	
 	// Loop over atoms in original cell
 	int i, j, k, m;
-	bool isNew;
 	int curAtom;
 	int numAtoms;
-	double curDis;
 	Vector3D nearCell;
 	Vector3D newPos;
 	Vector3D newMagMom;
-	Vector3D origin(0.0);
+	PositionHash positions;
 	for (i = 0; i < _atoms.length(); ++i)
 	{
 		
@@ -1906,28 +1930,21 @@ Atoms ISO::contract(const Matrix3D& transformation, double tol)
 		curAtom = 0;
 		numAtoms = (int) Num<double>::round(_atoms[i].length() * numCells, 1);
 		newAtoms[i].length(numAtoms);
-		newDis[i].length(numAtoms);
 		timesFound[i].length(numAtoms);
 		timesFound[i].fill(0);
+		positions.set(_basis, tol, numAtoms);
 		for (j = 0; j < _atoms[i].length(); ++j)
 		{
 			
 			// Get new position
 			newPos = conversion * _atoms[i][j].fractional();
 			ISO::moveIntoCell(newPos);
-			curDis = _basis.distance(newPos, FRACTIONAL, origin, FRACTIONAL);
 
-			// Loop over atoms of current element
-			isNew = true;
-			for (k = 0; k < curAtom; ++k)
+			// Check if an atom of the current element is already at the position
+			k = positions.find(newPos, &nearCell);
+			if (k >= 0)
 			{
 				
-				// Check if positions are the same
-				if (Num<double>::abs(curDis - newDis[i][k]) > tol)
-					continue;
-				if (_basis.distance(newAtoms[i][k].fractional(), FRACTIONAL, newPos, FRACTIONAL, &nearCell) > tol)
-					continue;
-				
 				// Positions are the same but magnetic moments are different
 				if (_basis.absoluteDistance(_atoms[i][j].magneticMoment(), CARTESIAN, \
 					newAtoms[i][k].magneticMoment(), CARTESIAN) > tol)
@@ -1951,21 +1968,14 @@ Atoms ISO::contract(const Matrix3D& transformation, double tol)
 				newAtoms[i][k].fractional(newPos);
 				newAtoms[i][k].magneticMoment(newMagMom);
 				timesFound[i][k]++;
-				newDis[i][k] = _basis.distance(newAtoms[i][k].fractional(), FRACTIONAL, origin, FRACTIONAL);
+				positions.move(k, newAtoms[i][k].fractional());
 				for (m = 0; m < 3; ++m)
 				{
 					if (_atoms[i][j].fixed()[m])
 						newAtoms[i][k].fixed(m, true);
 				}
-
-				// Break since atom was found
-				isNew = false;
-				break;
-			}
-
-			// Atom was already known
-			if (!isNew)
 				continue;
+			}
 				
 			// An error occured if at this point
 			if (curAtom >= numAtoms)
@@ -1979,14 +1989,14 @@ Atoms ISO::contract(const Matrix3D& transformation, double tol)
 			newAtoms[i][curAtom] = _atoms[i][j];
 			newAtoms[i][curAtom].fractional(newPos);
 			timesFound[i][curAtom] = 1;
-			newDis[i][curAtom] = curDis;
+			positions.add(newPos);
 			curAtom++;
 		}
 		
 		// Make sure that the number of atoms is not too small
 		if (curAtom < numAtoms)
 		{
-			int n, p;
+			int n;
 			for (j = -1; j <= 1; ++j)
 			{
 				for (k = -1; k <= 1; ++k)
@@ -2009,26 +2019,14 @@ Atoms ISO::contract(const Matrix3D& transformation, double tol)
 							newPos[2] += m;
 							newPos *= conversion;
 							ISO::moveIntoCell(newPos);
-							curDis = _basis.distance(newPos, FRACTIONAL, origin, FRACTIONAL);
-						
-							// Check if this is a new position
-							for (p = 0; p < curAtom; ++p)
-							{
-								if (Num<double>::abs(curDis - newDis[i][p]) < tol)
-								{
-									if (_basis.distance(newAtoms[i][p].fractional(), FRACTIONAL, newPos, \
-										FRACTIONAL) < tol)
-										break;
-								}
-							}
 						
 							// Found a new atom
-							if (p >= curAtom)
+							if (positions.find(newPos) < 0)
 							{
 								newAtoms[i][curAtom] = _atoms[i][n];
 								newAtoms[i][curAtom].fractional(newPos);
 								timesFound[i][curAtom] = 1;
-								newDis[i][curAtom] = curDis;
+								positions.add(newPos);
 								if (++curAtom == numAtoms)
 									break;
 							}
@@ -2188,8 +2186,16 @@ Atom* ISO::addAtom(const Element& element) {
 		newAtom = &(_atoms.last().last());
 	}
 	
+	// Save location of the new atom if the map is current
+	if (_atomElement.length() == _numAtoms)
+	{
+		_atomElement += i;
+		_atomIndex += (isNewElement) ? 0 : _atoms[i].length() - 1;
+	}
+	
 	// Save that number of atoms increased
 	++_numAtoms;
+	_basis.touch();
 	
 	// Return pointer to added atom
 	return newAtom;
@@ -2225,35 +2231,16 @@ Atom* ISO::addAtom(const Atom& atom)
 
 /* void ISO::removeAtom(int index, bool showOutput)
  *
- * Remove atom from the structure
+ * Remove atom from the structure. When editing, the atom stays in place until
+ * commitEdit is called and atom numbers are not changed until then.
  */
 
 void ISO::removeAtom(int index, bool showOutput)
 {
 	
 	// Look for atom in structure
-	int i, j;
-	bool found = false;
-	int elemIndex = 0;
-	int atomIndex = 0;
-	for (i = 0; i < _atoms.length(); ++i)
-	{
-		for (j = 0; j < _atoms[i].length(); ++j)
-		{
-			if (_atoms[i][j].atomNumber() == index)
-			{
-				elemIndex = i;
-				atomIndex = j;
-				found = true;
-				break;
-			}
-		}
-		if (found)
-			break;
-	}
-	
-	// Atom is out of range
-	if (!found)
+	int elemIndex, atomIndex;
+	if (!locateAtom(index, elemIndex, atomIndex))
 	{
 		Output::newline(WARNING);
 		Output::print("Atom ");
@@ -2272,23 +2259,13 @@ void ISO::removeAtom(int index, bool showOutput)
 	Output::print(index + 1);
 	Output::print(" from the structure");
 	
-	// Remove atom
-	_atoms[elemIndex].remove(atomIndex);
-	--_numAtoms;
-	
-	// Reset atom numbers
-	for (i = 0; i < _atoms.length(); ++i)
-	{
-		for (j = 0; j < _atoms[i].length(); ++j)
-		{
-			if (_atoms[i][j].atomNumber() > index)
-				_atoms[i][j].atomNumber(_atoms[i][j].atomNumber() - 1);
-		}
-	}
-	
-	// No elements left of type
-	if (!_atoms[elemIndex].length())
-		_atoms.remove(elemIndex);
+	// Save atom to remove and apply now if not editing
+	bool applyNow = !_editing;
+	if (applyNow)
+		beginEdit();
+	_editRemove += index;
+	if (applyNow)
+		commitEdit();
 	
 	// Output
 	if (!showOutput)
@@ -2299,35 +2276,17 @@ void ISO::removeAtom(int index, bool showOutput)
 
 /* void ISO::setElement(int index, const Element& element, bool showOutput)
  *
- * Set the element of an atom
+ * Set the element of an atom. When editing, the old slot is left behind without
+ * an atom number and is cleaned up by commitEdit.
  */
 
 void ISO::setElement(int index, const Element& element, bool showOutput)
 {
 	
 	// Look for atom in structure
-	int i, j;
-	bool found = false;
-	int elemIndex = 0;
-	int atomIndex = 0;
-	for (i = 0; i < _atoms.length(); ++i)
-	{
-		for (j = 0; j < _atoms[i].length(); ++j)
-		{
-			if (_atoms[i][j].atomNumber() == index)
-			{
-				elemIndex = i;
-				atomIndex = j;
-				found = true;
-				break;
-			}
-		}
-		if (found)
-			break;
-	}
-	
-	// Atom is out of range
-	if (!found)
+	int i;
+	int elemIndex, atomIndex;
+	if (!locateAtom(index, elemIndex, atomIndex))
 	{
 		Output::newline(WARNING);
 		Output::print("Atom ");
@@ -2349,7 +2308,11 @@ void ISO::setElement(int index, const Element& element, bool showOutput)
 	
 	// Atom is already of current element
 	if (element == _atoms[elemIndex][atomIndex].element())
+	{
+		if (!showOutput)
+			Output::quietOff();
 		return;
+	}
 	
 	// Check if new element is already in the system
 	int newElementNumber = -1;
@@ -2370,14 +2333,17 @@ void ISO::setElement(int index, const Element& element, bool showOutput)
 	}
 	
 	// Save element
+	bool applyNow = !_editing;
+	if (applyNow)
+		beginEdit();
 	_atoms[newElementNumber].add();
 	_atoms[newElementNumber].last() = _atoms[elemIndex][atomIndex];
 	_atoms[newElementNumber].last().element(element);
-	_atoms[elemIndex].remove(atomIndex);
-	
-	// No elements left of type
-	if (!_atoms[elemIndex].length())
-		_atoms.remove(elemIndex);
+	_atoms[elemIndex][atomIndex].atomNumber(-1);
+	_atomElement[index] = newElementNumber;
+	_atomIndex[index] = _atoms[newElementNumber].length() - 1;
+	if (applyNow)
+		commitEdit();
 	
 	// Output
 	if (!showOutput)
@@ -2386,6 +2352,184 @@ void ISO::setElement(int index, const Element& element, bool showOutput)
 
 
 
+/* void ISO::beginEdit()
+ *
+ * Start a set of atom changes. Until commitEdit is called, removed atoms stay
+ * in the structure, atoms whose element was changed leave an unused slot behind,
+ * and atom numbers refer to the structure as it was when the edit started. New
+ * atoms and changes to elements are available immediately through atom(int).
+ */
+
+void ISO::beginEdit()
+{
+	if (_editing)
+		return;
+	_editRemove.length(0);
+	_editing = true;
+}
+
+
+
+/* void ISO::commitEdit()
+ *
+ * Apply all pending atom changes with a single compaction and renumbering pass
+ */
+
+void ISO::commitEdit()
+{
+	
+	// Return if not editing
+	if (!_editing)
+		return;
+	_editing = false;
+	
+	// Flag atoms that are being removed
+	int i, j;
+	List<int> newNumber(_numAtoms);
+	newNumber.fill(0);
+	for (i = 0; i < _editRemove.length(); ++i)
+	{
+		if ((_editRemove[i] >= 0) && (_editRemove[i] < _numAtoms))
+			newNumber[_editRemove[i]] = -1;
+	}
+	_editRemove.length(0);
+	
+	// Keep atoms that have not been removed or left behind by a change of element
+	int number;
+	int numKept;
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		numKept = 0;
+		for (j = 0; j < _atoms[i].length(); ++j)
+		{
+			number = _atoms[i][j].atomNumber();
+			if ((number < 0) || ((number < _numAtoms) && (newNumber[number] == -1)))
+				continue;
+			if (numKept != j)
+				_atoms[i].swap(numKept, j);
+			++numKept;
+		}
+		for (j = _atoms[i].length() - 1; j >= numKept; --j)
+			_atoms[i].remove(j);
+	}
+	
+	// Remove elements that no longer have any atoms
+	for (i = _atoms.length() - 1; i >= 0; --i)
+	{
+		if (!_atoms[i].length())
+			_atoms.remove(i);
+	}
+	
+	// Get the new number of each remaining atom
+	int numRemoved = 0;
+	for (i = 0; i < _numAtoms; ++i)
+	{
+		if (newNumber[i] == -1)
+			++numRemoved;
+		else
+			newNumber[i] = i - numRemoved;
+	}
+	_numAtoms -= numRemoved;
+	
+	// Renumber atoms and save their locations
+	_atomElement.length(_numAtoms);
+	_atomIndex.length(_numAtoms);
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		for (j = 0; j < _atoms[i].length(); ++j)
+		{
+			number = _atoms[i][j].atomNumber();
+			if ((number < 0) || (number >= newNumber.length()))
+				continue;
+			number = newNumber[number];
+			_atoms[i][j].atomNumber(number);
+			_atomElement[number] = i;
+			_atomIndex[number] = j;
+		}
+	}
+	_basis.touch();
+}
+
+
+
+/* void ISO::updateAtomMap() const
+ *
+ * Save the location of every atom number in the atom list
+ */
+
+void ISO::updateAtomMap() const
+{
+	int i, j;
+	int number;
+	_atomElement.length(_numAtoms);
+	_atomIndex.length(_numAtoms);
+	_atomElement.fill(-1);
+	_atomIndex.fill(-1);
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		for (j = 0; j < _atoms[i].length(); ++j)
+		{
+			number = _atoms[i][j].atomNumber();
+			if ((number >= 0) && (number < _numAtoms))
+			{
+				_atomElement[number] = i;
+				_atomIndex[number] = j;
+			}
+		}
+	}
+}
+
+
+
+/* bool ISO::locateAtom(int number, int& elemIndex, int& atomIndex) const
+ *
+ * Get the element and index in element of an atom number. The saved map is
+ * rebuilt if it is out of date.
+ */
+
+bool ISO::locateAtom(int number, int& elemIndex, int& atomIndex) const
+{
+	
+	// Atom numbers within range are found through the map
+	int i, j;
+	if ((number >= 0) && (number < _numAtoms))
+	{
+		for (i = 0; i < 2; ++i)
+		{
+			if (number < _atomElement.length())
+			{
+				elemIndex = _atomElement[number];
+				atomIndex = _atomIndex[number];
+				if ((elemIndex >= 0) && (elemIndex < _atoms.length()) && (atomIndex >= 0) && \
+					(atomIndex < _atoms[elemIndex].length()) && \
+					(_atoms[elemIndex][atomIndex].atomNumber() == number))
+					return true;
+			}
+			if (i)
+				break;
+			updateAtomMap();
+		}
+		return false;
+	}
+	
+	// Look for any other number directly
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		for (j = 0; j < _atoms[i].length(); ++j)
+		{
+			if (_atoms[i][j].atomNumber() == number)
+			{
+				elemIndex = i;
+				atomIndex = j;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+
 /* List<Atom*> ISO::coordination(const Atom* atom, double fracTol) const
  *
  * Get the coordination for the atoms
@@ -2449,91 +2593,119 @@ List<Atom*> ISO::coordination(const Atom* atom, double fracTol) const
 
 
 
+/* List<Atom*> ISO::coordination(const Atom* atom, const NeighborList& neighbors, double fracTol) const
+ *
+ * Get the coordination for an atom from a neighbor list, ordered by atom number. Falls back to searching
+ *	all atoms if the nearest neighbor is too far away for the coordination shell to fit within the cutoff.
+ */
+
+List<Atom*> ISO::coordination(const Atom* atom, const NeighborList& neighbors, double fracTol) const
+{
+	
+	// Get all neighbors sorted by distance
+	List<int> atomNumbers;
+	List<double> distances;
+	neighbors.near(atom->fractional(), atomNumbers, distances, 0, true);
+	
+	// Search all atoms if the shell does not fit in the cutoff
+	if ((!distances.length()) || (distances[0]*(1 + fracTol) > neighbors.cutoff()))
+		return coordination(atom, fracTol);
+	
+	// Get the number of atoms in the shell
+	int i, j;
+	int num;
+	double maxDis = distances[0]*(1 + fracTol);
+	for (num = 0; (num < distances.length()) && (distances[num] <= maxDis); ++num) {}
+	
+	// Order atoms by number
+	for (i = 1; i < num; ++i)
+	{
+		for (j = i; (j > 0) && (atomNumbers[j] < atomNumbers[j - 1]); --j)
+			atomNumbers.swap(j, j - 1);
+	}
+	
+	// Return result
+	List<Atom*> res(num);
+	for (i = 0; i < num; ++i)
+		res[i] = neighbors.atom(atomNumbers[i]);
+	return res;
+}
+
+
+
 /* OList<Atom>::D2 ISO::shells(const Atom* atom, double maxDistance, double tol) const
  *
- * Get a list of atoms within set range and group into shells
+ * Get nearest neighbor shells around an atom out to a distance
  */
 
 OList<Atom>::D2 ISO::shells(const Atom* atom, double maxDistance, double tol) const
+{
+	NeighborList neighbors;
+	neighbors.set(*this, maxDistance, false);
+	return shells(atom, neighbors, tol);
+}
+
+
+
+/* OList<Atom>::D2 ISO::shells(const Atom* atom, const NeighborList& neighbors, double tol) const
+ *
+ * Get nearest neighbor shells around an atom out to the cutoff of a neighbor list. Neighbors are sorted by
+ *	distance and a new shell is started whenever the gap to the previous distance is larger than tol. Atoms
+ *	in each shell are ordered by atom number.
+ */
+
+OList<Atom>::D2 ISO::shells(const Atom* atom, const NeighborList& neighbors, double tol) const
 {
 	
 	// Output
 	Output::newline();
 	Output::print("Calculating nearest neighbor shells out to ");
-	Output::print(maxDistance);
+	Output::print(neighbors.cutoff());
 	Output::print(" Ang for atom ");
 	Output::print(atom->atomNumber() + 1);
 	Output::increase();
 	
-	// Variable to store result
-	OList<Atom>::D2 res;
-	List<double>::D2 distances;
+	// Get all neighbors sorted by distance
+	List<int> atomNumbers;
+	List<double> distances;
+	List<Vector3D> cartVectors;
+	neighbors.near(atom->fractional(), atomNumbers, distances, &cartVectors, true);
 	
-	// Loop over atoms in the structure
-	int i, j, k, m;
-	double dis;
-	ImageIterator images(_basis, maxDistance);
-	for (i = 0; i < _atoms.length(); ++i)
+	// Loop over shells
+	int i, j;
+	int end;
+	int start;
+	Vector3D fracVector;
+	OList<Atom>::D2 res;
+	for (start = 0; start < distances.length(); start = end)
 	{
-		for (j = 0; j < _atoms[i].length(); ++j)
+		
+		// Find the end of the shell
+		for (end = start + 1; end < distances.length(); ++end)
 		{
-			
-			// Loop over periodic images of current atom
-			images.reset(atom->fractional(), _atoms[i][j].fractional());
-			while (!images.finished())
+			if (!Num<double>::eq(distances[end], distances[end - 1], tol))
+				break;
+		}
+		
+		// Order atoms in shell by number
+		for (i = start + 1; i < end; ++i)
+		{
+			for (j = i; (j > start) && (atomNumbers[j] < atomNumbers[j - 1]); --j)
 			{
-				
-				// Get current distance
-				dis = ++images;
-				if (dis < 1e-8)
-					continue;
-				
-				// Loop over shells that are already saved and check if atom belongs in existing shell
-				for (k = 0; k < distances.length(); ++k)
-				{
-					for (m = 0; m < distances[k].length(); ++m)
-					{
-						
-						// Atom belongs in current shell
-						if (Num<double>::eq(dis, distances[k][m], tol))
-						{
-							res[k] += _atoms[i][j];
-							res[k].last().fractional(images.fracVector() + atom->fractional(), false);
-							distances[k] += dis;
-							break;
-						}
-					}
-					if (m < distances[k].length())
-						break;
-				}
-				
-				// Atom belongs in a new shell
-				if (k >= distances.length())
-				{
-					
-					// Find inseration point
-					for (k = 0; k < distances.length(); ++k)
-					{
-						if (dis < distances[k][0])
-							break;
-					}
-					res.add();
-					distances.add();
-					
-					// Move new shell to correct position
-					for (m = distances.length() - 1; m > k; --m)
-					{
-						res.swap(m, m-1);
-						distances.swap(m, m-1);
-					}
-					
-					// Save atom and properties
-					res[k] += _atoms[i][j];
-					res[k].last().fractional(images.fracVector() + atom->fractional(), false);
-					distances[k] += dis;
-				}
+				atomNumbers.swap(j, j - 1);
+				cartVectors.swap(j, j - 1);
 			}
 		}
+		
+		// Save atoms at the positions of their images
+		res.add();
+		res.last().length(end - start);
+		for (i = start; i < end; ++i)
+		{
+			res.last()[i - start] = *neighbors.atom(atomNumbers[i]);
+			fracVector = _basis.getFractional(cartVectors[i]);
+			res.last()[i - start].fractional(fracVector + atom->fractional(), false);
+		}
 	}
 	
 	// Output
@@ -3171,6 +3343,11 @@ LatticePoints ISO::getLatticePoints(const Matrix3D& transformationToNewCell)
 	// Tolerance used in this section
 	double tol = 1e-6;
 	
+	// Points can be generated exactly if the transformation is integer
+	IMatrix3D intTrans;
+	if ((intTrans.set(transformationToNewCell, tol)) && (intTrans.determinant() != 0))
+		return getLatticePoints(intTrans);
+	
 	// Get the inverse transpose of the transformation
 	Matrix3D transpose (transformationToNewCell.transpose());
 	Matrix3D invTrans (transpose.inverse());
@@ -3278,14 +3455,91 @@ LatticePoints ISO::getLatticePoints(const Matrix3D& transformationToNewCell)
 
 
 
-/* Word ISO::system(LatticeSystem input)
+/* LatticePoints ISO::getLatticePoints(const IMatrix3D& transformationToNewCell)
  *
- * Return the name of a lattice system
+ * Get the lattice points of an original basis in a new basis obtained from an integer transformation
+ * Points are identified exactly by their coset in the Hermite normal form of the new lattice and are generated in
+ * the same order as for a general transformation
  */
 
-Word ISO::system(LatticeSystem input)
+LatticePoints ISO::getLatticePoints(const IMatrix3D& transformationToNewCell)
 {
-	switch (input)
+	
+	// Get the number of points and the matrices used to identify and place them
+	long det = transformationToNewCell.determinant();
+	long numPoints = Num<long>::abs(det);
+	IMatrix3D hermite = transformationToNewCell.hermite();
+	IMatrix3D adjugate = transformationToNewCell.adjugate();
+	if (det < 0)
+		adjugate *= IMatrix3D(-1, 0, 0, 0, -1, 0, 0, 0, -1);
+	
+	// Get the number of multiples of each lattice direction before points are repeated
+	int i, j, k;
+	long order[3];
+	long vec[3];
+	for (i = 0; i < 3; ++i)
+	{
+		for (order[i] = 1; ; ++order[i])
+		{
+			vec[0] = vec[1] = vec[2] = 0;
+			vec[i] = order[i];
+			if (hermite.cosetIndex(vec) == 0)
+				break;
+		}
+	}
+	
+	// Loop over permutations of lattice directions
+	int m, n;
+	long frac[3];
+	List<bool> found(numPoints, false);
+	LatticePoints res;
+	for (i = 0; (i < order[0]) && (res.length() < numPoints); ++i)
+	{
+		for (j = 0; (j < order[1]) && (res.length() < numPoints); ++j)
+		{
+			for (k = 0; (k < order[2]) && (res.length() < numPoints); ++k)
+			{
+				
+				// Skip if point is already known
+				vec[0] = i;
+				vec[1] = j;
+				vec[2] = k;
+				n = hermite.cosetIndex(vec);
+				if (found[n])
+					continue;
+				found[n] = true;
+				
+				// Get fractional coordinates in the new cell times the number of points
+				for (m = 0; m < 3; ++m)
+				{
+					frac[m] = (i*adjugate(0, m) + j*adjugate(1, m) + k*adjugate(2, m)) % numPoints;
+					if (frac[m] < 0)
+						frac[m] += numPoints;
+				}
+				
+				// Save point in the original cell
+				res.add();
+				for (m = 0; m < 3; ++m)
+					res.last()[m] = (double) (frac[0]*transformationToNewCell(0, m) + \
+						frac[1]*transformationToNewCell(1, m) + frac[2]*transformationToNewCell(2, m)) / numPoints;
+			}
+		}
+	}
+	
+	// Return result
+	return res;
+}
+
+
+
+/* Word ISO::system(LatticeSystem input)
+ *
+ * Return the name of a lattice system
+ */
+
+Word ISO::system(LatticeSystem input)
+{
+	switch (input)
 	{
 		case LS_TRICLINIC:
 			return "Triclinic";
@@ -3363,3 +3617,652 @@ LatticeSystem ISO::system(const Word& input)
 		return LS_CUBIC;
 	return LS_UNKNOWN;
 }
+
+
+
+/* void NeighborList::set(const ISO& iso, double cutoff, bool buildList)
+ *
+ * Bin the atoms of a structure and build the neighbor list of every atom
+ */
+
+void NeighborList::set(const ISO& iso, double cutoff, bool buildList)
+{
+	
+	// Save cutoff and basis (candidates from an earlier update are no longer valid)
+	_cutoff = cutoff;
+	_skin = 0;
+	_basis = iso.basis();
+	_images.setCell(_basis, _cutoff);
+	
+	// Save atoms by number
+	int i, j;
+	_atoms.length(iso.numAtoms());
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+			_atoms[iso.atoms()[i][j].atomNumber()] = &iso.atoms()[i][j];
+	}
+	
+	// Get the number of bins along each direction from the spacing between lattice planes
+	_useBins = (_cutoff > 0);
+	for (i = 0; i < 3; ++i)
+	{
+		_numBins[i] = 0;
+		if (_useBins)
+		{
+			Vector3D recip(_basis.inverse()(0, i), _basis.inverse()(1, i), _basis.inverse()(2, i));
+			_numBins[i] = (int) Num<double>::floor(1.0 / (recip.magnitude() * _cutoff));
+			if (_numBins[i] < 3)
+				_useBins = false;
+		}
+	}
+	if (_useBins)
+		setBins();
+	
+	// Build list
+	_numPairs = 0;
+	_start.length(_atoms.length() + 1);
+	if (buildList)
+	{
+		List<int> curAtoms;
+		List<double> curDistances;
+		List<Vector3D> curVectors;
+		for (i = 0; i < _atoms.length(); ++i)
+		{
+			_start[i] = _numPairs;
+			near(_atoms[i]->fractional(), curAtoms, curDistances, &curVectors);
+			for (j = 0; j < curAtoms.length(); ++j)
+				addNeighbor(curAtoms[j], curDistances[j], curVectors[j]);
+		}
+	}
+	else
+		_start.fill(0);
+	_start[_atoms.length()] = _numPairs;
+	
+	// Set final lengths (storage is kept for the next build)
+	_neighbors.length(_numPairs);
+	_distances.length(_numPairs);
+	_cartVectors.length(_numPairs);
+}
+
+
+
+/* void NeighborList::setBins()
+ *
+ * Sort atoms into a grid of bins that are at least as wide as the cutoff
+ */
+
+void NeighborList::setBins()
+{
+	
+	// Get the bin of each atom
+	int i, j;
+	int bin[3];
+	int totalBins = _numBins[0] * _numBins[1] * _numBins[2];
+	List<int> atomBins(_atoms.length());
+	_binStart.length(totalBins + 1);
+	_binStart.fill(0);
+	Vector3D frac;
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		frac = _atoms[i]->fractional();
+		ISO::moveIntoCell(frac);
+		for (j = 0; j < 3; ++j)
+		{
+			bin[j] = (int) (frac[j] * _numBins[j]);
+			if (bin[j] >= _numBins[j])
+				bin[j] = _numBins[j] - 1;
+		}
+		atomBins[i] = (bin[0] * _numBins[1] + bin[1]) * _numBins[2] + bin[2];
+		++_binStart[atomBins[i] + 1];
+	}
+	
+	// Sort atoms by bin
+	for (i = 0; i < totalBins; ++i)
+		_binStart[i + 1] += _binStart[i];
+	List<int> binFill(_binStart);
+	_binAtoms.length(_atoms.length());
+	for (i = 0; i < _atoms.length(); ++i)
+		_binAtoms[binFill[atomBins[i]]++] = i;
+}
+
+
+
+/* void NeighborList::near(const Vector3D& fractional, List<int>& atomNumbers, List<double>& distances,
+ *		List<Vector3D>* cartVectors, bool sorted) const
+ *
+ * Get every image of every atom within the cutoff of a point (images at the point itself are skipped),
+ *	optionally sorted by distance and then atom number
+ */
+
+void NeighborList::near(const Vector3D& fractional, List<int>& atomNumbers, List<double>& distances, \
+	List<Vector3D>* cartVectors, bool sorted) const
+{
+	
+	// Clear lists
+	int num = 0;
+	atomNumbers.length(0);
+	distances.length(0);
+	if (cartVectors)
+		cartVectors->length(0);
+	
+	// Cell is too small for bins so loop over all atoms
+	int i, j, k;
+	if (!_useBins)
+	{
+		for (i = 0; i < _atoms.length(); ++i)
+		{
+			_images.reset(fractional, _atoms[i]->fractional());
+			while (!_images.finished())
+			{
+				if (++_images > 1e-8)
+				{
+					atomNumbers.length(++num);
+					atomNumbers[num - 1] = i;
+					distances.length(num);
+					distances[num - 1] = _images.distance();
+					if (cartVectors)
+					{
+						cartVectors->length(num);
+						(*cartVectors)[num - 1] = _images.cartVector();
+					}
+				}
+			}
+		}
+		if (sorted)
+			sortByDistance(atomNumbers, distances, cartVectors);
+		return;
+	}
+	
+	// Get the bin of the point
+	int bin[3];
+	Vector3D origin = fractional;
+	ISO::moveIntoCell(origin);
+	for (i = 0; i < 3; ++i)
+	{
+		bin[i] = (int) (origin[i] * _numBins[i]);
+		if (bin[i] >= _numBins[i])
+			bin[i] = _numBins[i] - 1;
+	}
+	
+	// Loop over the 27 bins surrounding the current bin
+	int curBin;
+	int shift[3];
+	int neighborBin[3];
+	double curDisSquared;
+	double cutoffSquared = _cutoff * _cutoff;
+	Vector3D fracVector;
+	Vector3D cartVector;
+	for (i = 0; i < 27; ++i)
+	{
+		
+		// Get the neighboring bin and the cell that it is in
+		neighborBin[0] = bin[0] + i / 9 - 1;
+		neighborBin[1] = bin[1] + (i / 3) % 3 - 1;
+		neighborBin[2] = bin[2] + i % 3 - 1;
+		for (j = 0; j < 3; ++j)
+		{
+			shift[j] = 0;
+			if (neighborBin[j] < 0)
+			{
+				shift[j] = -1;
+				neighborBin[j] += _numBins[j];
+			}
+			else if (neighborBin[j] >= _numBins[j])
+			{
+				shift[j] = 1;
+				neighborBin[j] -= _numBins[j];
+			}
+		}
+		curBin = (neighborBin[0] * _numBins[1] + neighborBin[1]) * _numBins[2] + neighborBin[2];
+		
+		// Loop over atoms in the bin
+		for (j = _binStart[curBin]; j < _binStart[curBin + 1]; ++j)
+		{
+			
+			// Get vector to image
+			fracVector = _atoms[_binAtoms[j]]->fractional();
+			ISO::moveIntoCell(fracVector);
+			for (k = 0; k < 3; ++k)
+				fracVector[k] += shift[k] - origin[k];
+			cartVector = _basis.getCartesian(fracVector);
+			
+			// Save if in range
+			curDisSquared = cartVector * cartVector;
+			if ((curDisSquared <= cutoffSquared) && (curDisSquared > 1e-16))
+			{
+				atomNumbers.length(++num);
+				atomNumbers[num - 1] = _binAtoms[j];
+				distances.length(num);
+				distances[num - 1] = sqrt(curDisSquared);
+				if (cartVectors)
+				{
+					cartVectors->length(num);
+					(*cartVectors)[num - 1] = cartVector;
+				}
+			}
+		}
+	}
+	
+	// Sort if needed
+	if (sorted)
+		sortByDistance(atomNumbers, distances, cartVectors);
+}
+
+
+
+/* void NeighborList::sortByDistance(List<int>& atomNumbers, List<double>& distances, List<Vector3D>* cartVectors)
+ *
+ * Sort neighbors in place by distance and then by atom number using heap sort
+ */
+
+void NeighborList::sortByDistance(List<int>& atomNumbers, List<double>& distances, List<Vector3D>* cartVectors)
+{
+	
+	// Loop over steps of the sort: first build the heap, then move the largest value to the end each time
+	int i;
+	int end;
+	int root;
+	int child;
+	int length = distances.length();
+	for (i = length / 2 - 1 + length - 1; i >= 0; --i)
+	{
+		
+		// Get the range of the heap and the value to sift down
+		if (i >= length - 1)
+		{
+			end = length;
+			root = i - (length - 1);
+		}
+		else
+		{
+			end = i + 1;
+			root = 0;
+			atomNumbers.swap(0, end);
+			distances.swap(0, end);
+			if (cartVectors)
+				cartVectors->swap(0, end);
+		}
+		
+		// Sift value down the heap
+		while ((child = 2*root + 1) < end)
+		{
+			if ((child + 1 < end) && ((distances[child + 1] > distances[child]) || \
+				((distances[child + 1] == distances[child]) && (atomNumbers[child + 1] > atomNumbers[child]))))
+				++child;
+			if ((distances[root] > distances[child]) || \
+				((distances[root] == distances[child]) && (atomNumbers[root] >= atomNumbers[child])))
+				break;
+			atomNumbers.swap(root, child);
+			distances.swap(root, child);
+			if (cartVectors)
+				cartVectors->swap(root, child);
+			root = child;
+		}
+	}
+}
+
+
+
+/* void NeighborList::addNeighbor(int atomNumber, double distance, const Vector3D& cartVector)
+ *
+ * Add neighbor to the end of the list, growing storage geometrically
+ */
+
+void NeighborList::addNeighbor(int atomNumber, double distance, const Vector3D& cartVector)
+{
+	if (_numPairs >= _distances.length())
+	{
+		int newLength = 2 * _numPairs + 64;
+		_neighbors.length(newLength);
+		_distances.length(newLength);
+		_cartVectors.length(newLength);
+	}
+	_neighbors[_numPairs] = atomNumber;
+	_distances[_numPairs] = distance;
+	_cartVectors[_numPairs] = cartVector;
+	++_numPairs;
+}
+
+
+
+/* bool NeighborList::update(const ISO& iso, double cutoff, double skin)
+ *
+ * Build the list using a skin, or only recompute distances over the saved candidate pairs if no atom has moved
+ *		by more than half of the skin since the last build (returns whether the list was rebuilt)
+ */
+
+bool NeighborList::update(const ISO& iso, double cutoff, double skin)
+{
+	
+	// Build normally if not using a skin
+	if (skin <= 0)
+	{
+		set(iso, cutoff);
+		return true;
+	}
+	
+	// Reuse candidates if possible
+	if (canReuse(iso, cutoff, skin))
+	{
+		refresh(true);
+		return false;
+	}
+	
+	// Build list out to the cutoff plus the skin and save every pair as a candidate
+	int i;
+	set(iso, cutoff + skin);
+	_skin = skin;
+	_candidateStart = _start;
+	_candidates = _neighbors;
+	_candidateVectors.length(_numPairs);
+	for (i = 0; i < _numPairs; ++i)
+		_candidateVectors[i] = _basis.getFractional(_cartVectors[i]);
+	_refPositions.length(_atoms.length());
+	for (i = 0; i < _atoms.length(); ++i)
+		_refPositions[i] = _atoms[i]->fractional();
+	
+	// Keep pairs that are within the cutoff
+	_cutoff = cutoff;
+	_images.setCell(_basis, _cutoff);
+	_displacements.length(_atoms.length());
+	_displacements.fill(Vector3D(0.0));
+	refresh(false);
+	return true;
+}
+
+
+
+/* bool NeighborList::canReuse(const ISO& iso, double cutoff, double skin)
+ *
+ * Check whether the candidate pairs are still valid and save the displacement of each atom since the last build
+ */
+
+bool NeighborList::canReuse(const ISO& iso, double cutoff, double skin)
+{
+	
+	// Settings or number of atoms changed
+	if ((_skin <= 0) || (skin != _skin) || (cutoff != _cutoff) || (iso.numAtoms() != _atoms.length()))
+		return false;
+	
+	// Cell changed
+	int i, j;
+	for (i = 0; i < 3; ++i)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			if (iso.basis().vectors()(i, j) != _basis.vectors()(i, j))
+				return false;
+		}
+	}
+	
+	// Atoms changed
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+		{
+			if (_atoms[iso.atoms()[i][j].atomNumber()] != &iso.atoms()[i][j])
+				return false;
+		}
+	}
+	
+	// Get displacement of each atom (nearest image of its reference position) and check distance moved
+	Vector3D cartDisplacement;
+	double maxDisSquared = skin * skin / 4;
+	_displacements.length(_atoms.length());
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			_displacements[i][j] = _atoms[i]->fractional()[j] - _refPositions[i][j];
+			_displacements[i][j] -= Num<double>::floor(_displacements[i][j] + 0.5);
+		}
+		cartDisplacement = _basis.getCartesian(_displacements[i]);
+		if (cartDisplacement * cartDisplacement > maxDisSquared)
+			return false;
+	}
+	
+	// List can be reused
+	return true;
+}
+
+
+
+/* void NeighborList::refresh(bool rebin)
+ *
+ * Set the neighbors of each atom from the candidate pairs and the current displacements
+ */
+
+void NeighborList::refresh(bool rebin)
+{
+	
+	// Loop over candidates of each atom
+	int i, j;
+	double curDisSquared;
+	double cutoffSquared = _cutoff * _cutoff;
+	Vector3D fracVector;
+	Vector3D cartVector;
+	_numPairs = 0;
+	for (i = 0; i < _atoms.length(); ++i)
+	{
+		_start[i] = _numPairs;
+		for (j = _candidateStart[i]; j < _candidateStart[i + 1]; ++j)
+		{
+			fracVector = _candidateVectors[j];
+			fracVector += _displacements[_candidates[j]];
+			fracVector -= _displacements[i];
+			cartVector = _basis.getCartesian(fracVector);
+			curDisSquared = cartVector * cartVector;
+			if (curDisSquared <= cutoffSquared)
+				addNeighbor(_candidates[j], sqrt(curDisSquared), cartVector);
+		}
+	}
+	_start[_atoms.length()] = _numPairs;
+	
+	// Set final lengths
+	_neighbors.length(_numPairs);
+	_distances.length(_numPairs);
+	_cartVectors.length(_numPairs);
+	
+	// Atoms may have moved between bins
+	if ((rebin) && (_useBins))
+		setBins();
+}
+
+
+
+/* void PositionHash::set(const Basis& basis, double tol, int expectedLength)
+ *
+ * Set the cell and tolerance and remove all points
+ */
+
+void PositionHash::set(const Basis& basis, double tol, int expectedLength)
+{
+	
+	// Save properties
+	_tol = tol;
+	_basis = basis;
+	
+	// Get the number of bins along each direction from the spacing between lattice planes
+	int i;
+	for (i = 0; i < 3; ++i)
+	{
+		Vector3D recip(_basis.inverse()(0, i), _basis.inverse()(1, i), _basis.inverse()(2, i));
+		_numBins[i] = (_tol > 0) ? (int) Num<double>::min(1.0 / (recip.magnitude() * _tol), 1e4) : 1;
+		if (_numBins[i] < 1)
+			_numBins[i] = 1;
+	}
+	
+	// Limit the total number of bins
+	int maxIndex;
+	int maxBins = (expectedLength < 2) ? 8 : 4 * expectedLength;
+	while ((double) _numBins[0] * _numBins[1] * _numBins[2] > maxBins)
+	{
+		maxIndex = 0;
+		for (i = 1; i < 3; ++i)
+		{
+			if (_numBins[i] > _numBins[maxIndex])
+				maxIndex = i;
+		}
+		_numBins[maxIndex] = (_numBins[maxIndex] + 1) / 2;
+	}
+	
+	// Clear points
+	clear();
+}
+
+
+
+/* void PositionHash::clear()
+ *
+ * Remove all points
+ */
+
+void PositionHash::clear()
+{
+	_bins.length(_numBins[0] * _numBins[1] * _numBins[2]);
+	for (int i = 0; i < _bins.length(); ++i)
+		_bins[i].length(0);
+	_pointBins.length(0);
+	_points.length(0);
+}
+
+
+
+/* int PositionHash::bin(const Vector3D& fractional) const
+ *
+ * Get the bin of a point that is in the cell
+ */
+
+int PositionHash::bin(const Vector3D& fractional) const
+{
+	int cur[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		cur[i] = (int) (fractional[i] * _numBins[i]);
+		if (cur[i] >= _numBins[i])
+			cur[i] = _numBins[i] - 1;
+	}
+	return (cur[0] * _numBins[1] + cur[1]) * _numBins[2] + cur[2];
+}
+
+
+
+/* int PositionHash::add(const Vector3D& fractional)
+ *
+ * Add a point and return its index
+ */
+
+int PositionHash::add(const Vector3D& fractional)
+{
+	int index = _points.length();
+	_points.add();
+	_points[index] = fractional;
+	ISO::moveIntoCell(_points[index]);
+	_pointBins.add();
+	_pointBins[index] = bin(_points[index]);
+	_bins[_pointBins[index]] += index;
+	return index;
+}
+
+
+
+/* void PositionHash::move(int index, const Vector3D& fractional)
+ *
+ * Change the position of a point
+ */
+
+void PositionHash::move(int index, const Vector3D& fractional)
+{
+	
+	// Save new position
+	_points[index] = fractional;
+	ISO::moveIntoCell(_points[index]);
+	int newBin = bin(_points[index]);
+	if (newBin == _pointBins[index])
+		return;
+	
+	// Move point to new bin
+	int i;
+	List<int>& oldList = _bins[_pointBins[index]];
+	for (i = 0; i < oldList.length(); ++i)
+	{
+		if (oldList[i] == index)
+		{
+			oldList.remove(i);
+			break;
+		}
+	}
+	_pointBins[index] = newBin;
+	_bins[newBin] += index;
+}
+
+
+
+/* int PositionHash::find(const Vector3D& fractional, Vector3D* cell) const
+ *
+ * Return the first point added that is within the tolerance of a position, or -1 if there is none. If cell is
+ *		set then it stores the cell of the position that is nearest to the point
+ */
+
+int PositionHash::find(const Vector3D& fractional, Vector3D* cell) const
+{
+	
+	// Get the bin of the position
+	int i, j;
+	int center[3];
+	Vector3D origin = fractional;
+	ISO::moveIntoCell(origin);
+	for (i = 0; i < 3; ++i)
+	{
+		center[i] = (int) (origin[i] * _numBins[i]);
+		if (center[i] >= _numBins[i])
+			center[i] = _numBins[i] - 1;
+	}
+	
+	// Get the bins to search along each direction (all bins if there are fewer than three)
+	int numSearch[3];
+	int search[3][3];
+	for (i = 0; i < 3; ++i)
+	{
+		numSearch[i] = (_numBins[i] < 3) ? _numBins[i] : 3;
+		for (j = 0; j < numSearch[i]; ++j)
+			search[i][j] = (_numBins[i] < 3) ? j : (center[i] + j - 1 + _numBins[i]) % _numBins[i];
+	}
+	
+	// Loop over surrounding bins
+	int a, b, c;
+	int res = -1;
+	Vector3D curCell;
+	for (a = 0; a < numSearch[0]; ++a)
+	{
+		for (b = 0; b < numSearch[1]; ++b)
+		{
+			for (c = 0; c < numSearch[2]; ++c)
+			{
+				
+				// Loop over points in bin
+				const List<int>& curList = _bins[(search[0][a] * _numBins[1] + search[1][b]) * _numBins[2] + \
+					search[2][c]];
+				for (i = 0; i < curList.length(); ++i)
+				{
+					
+					// Skip if an earlier point was already found
+					if ((res >= 0) && (curList[i] > res))
+						continue;
+					
+					// Save if in range
+					if (_basis.distance(_points[curList[i]], FRACTIONAL, fractional, FRACTIONAL, &curCell) <= _tol)
+					{
+						res = curList[i];
+						if (cell)
+							*cell = curCell;
+					}
+				}
+			}
+		}
+	}
+	
+	// Return result
+	return res;
+}
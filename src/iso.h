@@ -69,6 +69,10 @@ class Basis
 	mutable bool _lengthFixed[3];
 	mutable bool _angleFixed[3];
 	
+	// Revision of the basis and the atoms that use it
+	mutable unsigned long int _revision;
+	static unsigned long int _lastRevision;
+	
 	// Reduced cell variables
 	Matrix3D _reduced;
 	Matrix3D _reducedTranspose;
@@ -77,6 +81,7 @@ class Basis
 	Matrix3D _unitToReduced;
 	Matrix3D _reducedPointToUnit;
 	Matrix3D _unitPointToReduced;
+	bool _orthogonal; // Reduced cell vectors are orthogonal so nearest image is found by rounding
 	
 	// Helper variables
 	mutable bool _first;
@@ -101,9 +106,9 @@ class Basis
 	void finishSetup(bool showOutput);
 	
 	// Reduction functions
-	static void NiggliParams(const Matrix3D& vectors, double& A, double& B, double& C, double& ksi, \
-		double& eta, double& zeta);
-	static void updateTransformation(Matrix3D& transformation, int m00, int m01, int m02, int m10, \
+	static void NiggliParams(const Matrix3D& metric, const IMatrix3D& transformation, double& A, double& B, \
+		double& C, double& ksi, double& eta, double& zeta);
+	static void updateTransformation(IMatrix3D& transformation, int m00, int m01, int m02, int m10, \
 		int m11, int m12, int m20, int m21, int m22);
 	
 	// Helper function for lattice symmetry
@@ -129,10 +134,13 @@ public:
 		{ _lengthFixed[0] = input[0]; _lengthFixed[1] = input[1]; _lengthFixed[2] = input[2]; }
 	void angleFixed(const bool* input) const
 		{ _angleFixed[0] = input[0]; _angleFixed[1] = input[1]; _angleFixed[2] = input[2]; }
+	void touch() const;
 	
 	// Conversion functions
 	void toFractional(Vector3D& input) const 					{ input *= _inverseTranspose; }
 	void toCartesian(Vector3D& input) const  					{ input *= _vectorsTranspose; }
+	void toFractional(OList<Vector3D>& input) const				{ _inverseTranspose.transform(input); }
+	void toCartesian(OList<Vector3D>& input) const				{ _vectorsTranspose.transform(input); }
 	Vector3D getFractional(const Vector3D& input) const			{ return _inverseTranspose * input; }
 	Vector3D getCartesian(const Vector3D& input) const			{ return _vectorsTranspose * input; }
 	
@@ -155,6 +163,7 @@ public:
 	LatticeSystem latticeSystem() const				{ return _latticeSystem; }
 	const bool* lengthFixed() const					{ return _lengthFixed; }
 	const bool* angleFixed() const					{ return _angleFixed; }
+	unsigned long int revision() const				{ return _revision; }
 	
 	// Access functions for reduced cell
 	const Matrix3D& reduced() const					{ return _reduced; }
@@ -269,6 +278,7 @@ public:
 // Types used in ISO class
 typedef OList<Atom>::D2 Atoms;
 typedef OList<Vector3D > LatticePoints;
+class NeighborList;
 
 
 
@@ -286,6 +296,14 @@ class ISO
 	int _numAtoms;
 	Atoms _atoms;
 	
+	// Location of each atom number in atom list as [element index, index in element]
+	mutable List<int> _atomElement;
+	mutable List<int> _atomIndex;
+	
+	// Pending changes when editing atoms in bulk
+	bool _editing;
+	List<int> _editRemove;
+	
 	// Space group when generating structure randomly
 	Word _spaceGroup;
 	
@@ -297,10 +315,14 @@ class ISO
 	static void fillRotations(Linked<Matrix3D>& rotations, Linked<Matrix3D>& origRotations);
 	static void addRotation(Linked<Matrix3D>& rotations, const Matrix3D& curRotation);
 	
+	// Atom lookup functions
+	void updateAtomMap() const;
+	bool locateAtom(int number, int& elemIndex, int& atomIndex) const;
+	
 public:
 	
 	// Constructors
-	ISO()					{ _numAtoms = 0; }
+	ISO()					{ _numAtoms = 0; _editing = false; }
 	ISO(const ISO& copy)	{ *this = copy; }
 	
 	// General functions
@@ -335,12 +357,19 @@ public:
 	void moveAtomToFirst(const Atom* atom);
 	void moveAtomToLast(const Atom* atom);
 	void setAtomInElement(int atomNumber, int index);
-	void clearAtoms()	{ _atoms.clear(); _numAtoms = 0; }
+	void clearAtoms()	{ _atoms.clear(); _numAtoms = 0; _basis.touch(); }
 	void orderAtomNumbers();
 	
+	// Apply many atom changes at once
+	void beginEdit();
+	void commitEdit();
+	bool editing() const	{ return _editing; }
+	
 	// Get information about the structure
 	List<Atom*> coordination(const Atom* atom, double fracTol = 0.1) const;
+	List<Atom*> coordination(const Atom* atom, const NeighborList& neighbors, double fracTol = 0.1) const;
 	OList<Atom>::D2 shells(const Atom* atom, double maxDistance, double tol = 1e-4) const;
+	OList<Atom>::D2 shells(const Atom* atom, const NeighborList& neighbors, double tol = 1e-4) const;
 	
 	// Compare to another structure
 	bool equivalent(const ISO& compISO, double tol, bool matchVolume = false, bool matchCellParams = true) const;
@@ -358,6 +387,7 @@ public:
 	const Atoms& atoms() const		{ return _atoms; }
 	const Word& spaceGroup() const	{ return _spaceGroup; }
 	int numAtoms() const			{ return _numAtoms; }
+	unsigned long int revision() const	{ return _basis.revision(); }
 	bool anyFixed() const;
 	bool anyUnset() const;
 	bool anyPartiallyOccupied() const;
@@ -374,6 +404,7 @@ public:
 	static bool areSitesEqual(const Basis& basis, const Atoms& origAtoms, const Atoms& newAtoms, double tol, \
 		Vector3D* vector = 0, List<double>::D2* origDistances = 0);
 	static LatticePoints getLatticePoints(const Matrix3D& transformationToNewCell);
+	static LatticePoints getLatticePoints(const IMatrix3D& transformationToNewCell);
 	static Word system(LatticeSystem input);
 	static Word centering(LatticeCentering input);
 	static LatticeSystem system(const Word& input);
@@ -424,8 +455,8 @@ class ImageIterator
 public:
 	
 	// Constructor
-	ImageIterator()											{}
-	ImageIterator(const Basis& basis, double maxDistance)	{ setCell(basis, maxDistance); }
+	ImageIterator()											{ _maxDistanceSquared = -1; }
+	ImageIterator(const Basis& basis, double maxDistance)	{ _maxDistanceSquared = -1; setCell(basis, maxDistance); }
 	
 	// Functions
 	void setCell(const Basis& basis, double maxDistance);
@@ -443,6 +474,131 @@ public:
 
 
 
+/**
+ * Full periodic neighbor list of all atoms in a structure within a cutoff
+ *
+ * Atoms are binned into a grid of cells whose widths are at least the cutoff
+ *	so that building the list scales linearly with the number of atoms. If the
+ *	cell is too small for a grid of at least three bins along each direction,
+ *	the list falls back to an ImageIterator over every pair of atoms.
+ *
+ * Every pair appears in the lists of both atoms and every periodic image of
+ *	an atom with itself is included. Lists are indexed by atom number. The bins
+ *	are kept after the list is built so that atoms near any point in the cell
+ *	can be found with near() until the structure changes.
+ *
+ * When the list is built by update() with a skin, candidate pairs are saved out
+ *	to the cutoff plus the skin. Later calls to update() only recompute distances
+ *	over the candidates until an atom moves by more than half of the skin, the
+ *	cell changes, or the atoms change, which avoids rebuilding the list on every
+ *	step of a dynamics run.
+ */
+class NeighborList
+{
+
+	// Variables
+	bool _useBins;
+	int _numPairs;
+	int _numBins[3];
+	double _cutoff;
+	double _skin;
+	Basis _basis;
+	List<Atom*> _atoms;
+	List<int> _binStart;
+	List<int> _binAtoms;
+	List<int> _start;
+	List<int> _neighbors;
+	List<double> _distances;
+	List<Vector3D> _cartVectors;
+	List<int> _candidateStart;
+	List<int> _candidates;
+	List<Vector3D> _candidateVectors;
+	List<Vector3D> _refPositions;
+	List<Vector3D> _displacements;
+	mutable ImageIterator _images;
+
+	// Functions
+	void setBins();
+	void addNeighbor(int atomNumber, double distance, const Vector3D& cartVector);
+	bool canReuse(const ISO& iso, double cutoff, double skin);
+	void refresh(bool rebin);
+	static void sortByDistance(List<int>& atomNumbers, List<double>& distances, List<Vector3D>* cartVectors);
+
+public:
+
+	// Constructor
+	NeighborList()									{ _cutoff = 0; _skin = 0; _numPairs = 0; _useBins = false; }
+	NeighborList(const ISO& iso, double cutoff)		{ _skin = 0; _numPairs = 0; set(iso, cutoff); }
+
+	// Setup
+	void set(const ISO& iso, double cutoff, bool buildList = true);
+	bool update(const ISO& iso, double cutoff, double skin);
+
+	// Find atoms near a point
+	void near(const Vector3D& fractional, List<int>& atomNumbers, List<double>& distances, \
+		List<Vector3D>* cartVectors = 0, bool sorted = false) const;
+
+	// Access functions
+	double cutoff() const							{ return _cutoff; }
+	int numAtoms() const							{ return _atoms.length(); }
+	Atom* atom(int atomNumber) const				{ return _atoms[atomNumber]; }
+	int numNeighbors(int atomNumber) const			{ return _start[atomNumber + 1] - _start[atomNumber]; }
+	Atom* neighbor(int atomNumber, int index) const
+		{ return _atoms[_neighbors[_start[atomNumber] + index]]; }
+	double distance(int atomNumber, int index) const
+		{ return _distances[_start[atomNumber] + index]; }
+	const Vector3D& cartVector(int atomNumber, int index) const
+		{ return _cartVectors[_start[atomNumber] + index]; }
+};
+
+
+
+/**
+ * Periodic hash grid of points in the fractional coordinates of a cell, used to
+ *	find whether a new point is within a tolerance of any point already stored
+ *
+ * Bins are at least as wide as the tolerance so only the bins surrounding a
+ *	point need to be searched, which makes each lookup constant time on average.
+ *	The number of bins is limited by the expected number of points so that a
+ *	very small tolerance does not create a large empty grid. When several stored
+ *	points are within the tolerance, find() returns the one that was added first.
+ */
+class PositionHash
+{
+	
+	// Variables
+	int _numBins[3];
+	double _tol;
+	Basis _basis;
+	List<int>::D2 _bins;
+	List<int> _pointBins;
+	OList<Vector3D> _points;
+	
+	// Functions
+	int bin(const Vector3D& fractional) const;
+	
+public:
+	
+	// Constructor
+	PositionHash()													{ _tol = 0; }
+	PositionHash(const Basis& basis, double tol, int expectedLength)	{ set(basis, tol, expectedLength); }
+	
+	// Setup
+	void set(const Basis& basis, double tol, int expectedLength);
+	void clear();
+	
+	// Functions
+	int add(const Vector3D& fractional);
+	void move(int index, const Vector3D& fractional);
+	int find(const Vector3D& fractional, Vector3D* cell = 0) const;
+	
+	// Access functions
+	int length() const									{ return _points.length(); }
+	const Vector3D& operator[] (int index) const		{ return _points[index]; }
+};
+
+
+
 // =====================================================================================================================
 // Basis
 // =====================================================================================================================
@@ -454,6 +610,7 @@ public:
 
 inline void Basis::init()
 {
+	_revision = 0;
 	for (int i = 0; i < 3; ++i)
 	{
 		_lengthFixed[i] = false;
@@ -487,6 +644,22 @@ inline Basis::Basis()
 	_unitToReduced = 0.0;
 	_reducedPointToUnit = 0.0;
 	_unitPointToReduced = 0.0;
+	_orthogonal = false;
+}
+
+
+
+/* inline void Basis::touch() const
+ *
+ * Give the basis and its atoms a new revision number, which is unique over all structures, after any change
+ */
+
+inline void Basis::touch() const
+{
+	#ifdef MINT_OPENMP
+	#pragma omp atomic capture
+	#endif
+	_revision = ++_lastRevision;
 }
 
 
@@ -507,7 +680,7 @@ inline double Basis::absoluteDistance(const Vector3D& pos1, CoordinateType type1
 	
 	// Return distance
 	_curVec -= _frac1;
-	return sqrt(_curVec * (_metric * _curVec));
+	return sqrt(_metric.quadratic(_curVec));
 }
 
 
@@ -528,7 +701,10 @@ inline void Atom::fractional(const double* input, bool moveIntoCell)
 	if (moveIntoCell)
 		ISO::moveIntoCell(_fractional);
 	if (_basis)
+	{
 		_cartesian = _basis->getCartesian(_fractional);
+		_basis->touch();
+	}
 }
 
 
@@ -545,7 +721,10 @@ inline void Atom::fractional(const Vector3D& input, bool moveIntoCell)
 	if (moveIntoCell)
 		ISO::moveIntoCell(_fractional);
 	if (_basis)
+	{
 		_cartesian = _basis->getCartesian(_fractional);
+		_basis->touch();
+	}
 }
 
 
@@ -576,6 +755,7 @@ inline void Atom::cartesian(const double* input, bool moveIntoCell)
 		if (moveIntoCell)
 			ISO::moveIntoCell(_fractional);
 		_cartesian = _basis->getCartesian(_fractional);
+		_basis->touch();
 	}
 }
 
@@ -596,6 +776,7 @@ inline void Atom::cartesian(const Vector3D& input, bool moveIntoCell)
 		if (moveIntoCell)
 			ISO::moveIntoCell(_fractional);
 		_cartesian = _basis->getCartesian(_fractional);
+		_basis->touch();
 	}
 }
 
@@ -635,6 +816,7 @@ inline void ISO::moveAtomToFirst(const Atom* atom)
 				{
 					for (; j >= 1; --j)
 						_atoms[i].swap(j, j-1);
+					_basis.touch();
 					return;
 				}
 			}
@@ -662,6 +844,7 @@ inline void ISO::moveAtomToLast(const Atom* atom)
 				{
 					for (; j < _atoms[i].length() - 1; ++j)
 						_atoms[i].swap(j, j+1);
+					_basis.touch();
 					return;
 				}
 			}
@@ -688,6 +871,7 @@ inline void ISO::setAtomInElement(int atomNumber, int index)
 				int step = Num<int>::sign(index - j);
 				for (; j != index; j += step)
 					_atoms[i].swap(j, j+step);
+				_basis.touch();
 				return;
 			}
 		}
@@ -710,6 +894,7 @@ inline void ISO::orderAtomNumbers()
 		for (j = 0; j < _atoms[i].length(); ++j)
 			_atoms[i][j].atomNumber(number++);
 	}
+	_basis.touch();
 }
 
 
@@ -721,15 +906,9 @@ inline void ISO::orderAtomNumbers()
 
 inline Atom* ISO::atom(int index) const
 {
-	int i, j;
-	for (i = 0; i < _atoms.length(); ++i)
-	{
-		for (j = 0; j < _atoms[i].length(); ++j)
-		{
-			if (_atoms[i][j].atomNumber() == index)
-				return &_atoms[i][j];
-		}
-	}
+	int elemIndex, atomIndex;
+	if (locateAtom(index, elemIndex, atomIndex))
+		return &_atoms[elemIndex][atomIndex];
 	return 0;
 }
 
@@ -894,7 +1073,7 @@ inline bool ISO::anyPartiallyOccupied() const
 // Image iterator
 // =====================================================================================================================
 
-/* inline void ImageIterator::sesetCelltup(const Basis& basis, double maxDistance)
+/* inline void ImageIterator::setCell(const Basis& basis, double maxDistance)
  *
  * Setup image iterator
  */
@@ -902,6 +1081,26 @@ inline bool ISO::anyPartiallyOccupied() const
 inline void ImageIterator::setCell(const Basis& basis, double maxDistance)
 {
 	
+	// Nothing to do if the cell and distance are unchanged
+	if (maxDistance*maxDistance == _maxDistanceSquared)
+	{
+		int i, j;
+		bool same = true;
+		for (i = 0; (same) && (i < 3); ++i)
+		{
+			for (j = 0; j < 3; ++j)
+			{
+				if (basis.vectors()(i, j) != _unitBasis.vectors()(i, j))
+				{
+					same = false;
+					break;
+				}
+			}
+		}
+		if (same)
+			return;
+	}
+	
 	// Save basis
 	_unitBasis = basis;
 	_redBasis.set(basis.reduced(), false);
@@ -200,8 +200,10 @@ void KMC::generateJumps(const ISO& iso, const Element& element, bool useIntersti
 			}
 			
 			// Remove atoms
+			tempISO.beginEdit();
 			for (j = 0; j < atomsToRemove.length(); ++j)
 				tempISO.removeAtom(atomsToRemove[j]->atomNumber(), false);
+			tempISO.commitEdit();
 		}
 		
 		// Create directory
@@ -217,6 +219,7 @@ void KMC::generateJumps(const ISO& iso, const Element& element, bool useIntersti
 	ISO idealCopy = ideal;
 	if (useInterstitials)
 	{
+		idealCopy.beginEdit();
 		for (i = idealCopy.atoms().length() - 1; i >= 0; --i)
 		{
 			for (j = idealCopy.atoms()[i].length() - 1; j >= 0; --j)
@@ -225,6 +228,7 @@ void KMC::generateJumps(const ISO& iso, const Element& element, bool useIntersti
 					idealCopy.removeAtom(idealCopy.atoms()[i][j].atomNumber(), false);
 			}
 		}
+		idealCopy.commitEdit();
 	}
 	Directory::create("supercell", true);
 	StructureIO::write(Directory::makePath("supercell", "structure"), idealCopy, format, FRACTIONAL);
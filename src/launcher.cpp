@@ -344,6 +344,19 @@ void Launcher::start(int argc, char** argv)
 				print = false;
 				break;
 			
+			// Molecular dynamics
+			case KEY_MD:
+				generateStructure(data);
+				md(data, functions[i]);
+				print = true;
+				break;
+			
+			// Fit potential parameters
+			case KEY_FIT:
+				fit(data, functions[i]);
+				print = false;
+				break;
+			
 			// KMC simulation
 			case KEY_KMC:
 				generateStructure(data);
@@ -622,6 +635,14 @@ Keyword Launcher::getKeyword(const Word& argument)
 	if (argument.equal("-phonons", false, 5))
 		return KEY_PHONONS;
 	
+	// Molecular dynamics
+	if (argument.equal("-md", false, 3))
+		return KEY_MD;
+	
+	// Fit potential
+	if (argument.equal("-fit", false, 4))
+		return KEY_FIT;
+	
 	// KMC
 	if (argument.equal("-kmc", false, 4))
 		return KEY_KMC;
@@ -959,6 +980,10 @@ void Launcher::runSetup(Storage& data, Functions& functions, bool& keepFree)
 	RandomStructure::maxTrialLoops(Settings::value<int>(RANDSTR_MAXLOOPS));
 	RandomStructure::minBondFraction(Settings::value<double>(RANDSTR_MINBOND));
 	
+	// Set random number generator
+	if (Settings::value<RandomPackage>(RANDOM_PACKAGE) != RP_MERSENNE)
+		data.random().set(Settings::value<RandomPackage>(RANDOM_PACKAGE));
+	
 	// Output
 	Output::decrease();
 }
@@ -1189,8 +1214,10 @@ void Launcher::removeAtoms(Storage& data, const Function& function) {
 		List<Atom*> atoms = getAtoms(data.iso()[i], function, true, false);
 		
 		// Remove atoms
+		data.iso()[i].beginEdit();
 		for (j = atoms.length() - 1; j >= 0; --j)
 			data.iso()[i].removeAtom(atoms[j]->atomNumber());
+		data.iso()[i].commitEdit();
 		
 		// Add change to comment
 		data.history()[i] += " > removed atoms";
@@ -3578,6 +3605,10 @@ void Launcher::optimize(Storage& data, const Function& function)
 	ga.diffractionTolerance(Settings::value<double>(GAOPT_DIFFRACTIONTOL));
 	ga.useRietveld(Settings::value<bool>(GAOPT_USERIETVELD) == 1);
 	ga.setSaveAllResults(Settings::value<bool>(GAOPT_SAVEALLRESULTS));
+	ga.freeEnergyNumber(Settings::value<int>(GAOPT_FREENUM));
+	ga.freeEnergyTemperature(Settings::value<double>(GAOPT_FREETEMP));
+	ga.freeEnergyMesh(Settings::value<int>(GAOPT_FREEMESH));
+	ga.positionTrials(Settings::value<int>(GAOPT_POSTRIALS));
 	
 	// Determine whether to write restart information, allow restarting
 	bool allow_restarts = Settings::value<bool>(GAOPT_ALLOWRESTART);
@@ -3751,6 +3782,212 @@ void Launcher::phonons(Storage& data, const Function& function)
 
 
 
+/* void Launcher::md(Storage& data, const Function& function)
+ *
+ * Run molecular dynamics on the structures
+ */
+
+void Launcher::md(Storage& data, const Function& function)
+{
+	
+	// Output
+	Output::newline();
+	Output::print("Running molecular dynamics");
+	Output::increase();
+	
+	// Molecular dynamics needs forces from an internal potential
+	if (!data.potential().local())
+	{
+		Output::newline(ERROR);
+		Output::print("Molecular dynamics requires an internal potential");
+		Output::quit();
+	}
+	
+	// Initialize the trajectory format
+	StructureFormat format = StructureIO::structureFormat(function.arguments());
+	bool printTrajectory = (format != SF_UNKNOWN);
+	if (format == SF_UNKNOWN)
+		format = Settings::value<StructureFormat>(STRUCTURE_FORMAT);
+	
+	// Loop over function arguments to get settings
+	int i;
+	int numTemperatures = 0;
+	double temperatures[2] = {300, 300};
+	MDThermostat thermostat = MDT_LANGEVIN;
+	MDThermostat tempThermostat;
+	for (i = 0; i < function.arguments().length(); ++i)
+	{
+		
+		// Found a temperature
+		if (Language::isNumber(function.arguments()[i]))
+		{
+			if (numTemperatures == 2)
+			{
+				Output::newline(ERROR);
+				Output::print("Cannot pass more than two temperatures to molecular dynamics function");
+				Output::quit();
+			}
+			temperatures[numTemperatures++] = atof(function.arguments()[i].array());
+			continue;
+		}
+		
+		// Found a thermostat
+		tempThermostat = MD::thermostatType(function.arguments()[i]);
+		if (tempThermostat != MDT_UNKNOWN)
+		{
+			thermostat = tempThermostat;
+			continue;
+		}
+		
+		// Found a structure format
+		if (StructureIO::structureFormat(Words(function.arguments()[i])) != SF_UNKNOWN)
+			continue;
+		
+		// Did not recognize argument
+		Output::newline(ERROR);
+		Output::print("Did not recognize molecular dynamics argument: ");
+		Output::print(function.arguments()[i]);
+		Output::quit();
+	}
+	if (numTemperatures == 1)
+		temperatures[1] = temperatures[0];
+	
+	// Make sure that temperatures are valid
+	if ((temperatures[0] < 0) || (temperatures[1] < 0))
+	{
+		Output::newline(ERROR);
+		Output::print("Molecular dynamics temperatures cannot be negative");
+		Output::quit();
+	}
+	
+	// Make sure that settings are valid
+	if ((Settings::value<int>(MD_NUMSTEPS) <= 0) || (Settings::value<double>(MD_TIMESTEP) <= 0) || \
+		(Settings::value<double>(MD_DAMPING) <= 0))
+	{
+		Output::newline(ERROR);
+		Output::print("Molecular dynamics steps, time step, and damping time must be positive");
+		Output::quit();
+	}
+	
+	// Set trajectory frequency
+	int trajectoryFrequency = Settings::value<int>(MD_TRAJFREQ);
+	if ((printTrajectory) && (trajectoryFrequency <= 0))
+		trajectoryFrequency = Settings::value<int>(MD_PRINTFREQ);
+	
+	// Set the run properties
+	MD settings;
+	settings.numSteps(Settings::value<int>(MD_NUMSTEPS));
+	settings.timeStep(Settings::value<double>(MD_TIMESTEP));
+	settings.damping(Settings::value<double>(MD_DAMPING));
+	settings.printFrequency(Settings::value<int>(MD_PRINTFREQ));
+	settings.temperature(temperatures[0], temperatures[1]);
+	settings.thermostat(thermostat);
+	
+	// Loop over structures
+	Word file;
+	StructureFormat curFormat;
+	for (i = 0; i < data.iso().length(); ++i)
+	{
+		
+		// Output if there is more than one structure
+		if (data.iso().length() > 1)
+		{
+			Output::newline();
+			Output::print("Running molecular dynamics on structure ");
+			Output::print(data.id()[i]);
+			Output::increase();
+		}
+		
+		// Set the trajectory file
+		MD md = settings;
+		if (trajectoryFrequency > 0)
+		{
+			file = "trajectory";
+			if (data.iso().length() > 1)
+			{
+				file += "_";
+				file += Language::numberToWord(data.id()[i]);
+			}
+			curFormat = (format == SF_AUTO) ? data.format()[i] : format;
+			if ((curFormat == SF_AUTO) || (curFormat == SF_UNKNOWN))
+				curFormat = SF_VASP5;
+			md.trajectory(file, curFormat, trajectoryFrequency);
+		}
+		
+		// Run simulation
+		md.run(data.iso()[i], *data.potential().local(), data.random());
+		
+		// Add change to comment
+		data.history()[i] += " > md";
+		
+		// Output if there is more than one structure
+		if (data.iso().length() > 1)
+			Output::decrease();
+	}
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/* void Launcher::fit(Storage& data, const Function& function)
+ *
+ * Fit parameters of the internal potential to a training set
+ */
+
+void Launcher::fit(Storage& data, const Function& function)
+{
+	
+	// Output
+	Output::newline();
+	Output::print("Fitting potential parameters");
+	Output::increase();
+	
+	// Fitting needs an internal potential
+	if (!data.potential().local())
+	{
+		Output::newline(ERROR);
+		Output::print("Potential fitting requires an internal potential");
+		Output::quit();
+	}
+	
+	// Get the training set file and the output file
+	if (function.arguments().length() == 0)
+	{
+		Output::newline(ERROR);
+		Output::print("Must pass a training set file to fit function");
+		Output::quit();
+	}
+	Word outFile = "stdout";
+	if (function.arguments().length() > 1)
+		outFile = function.arguments()[1];
+	
+	// Read training set
+	PotentialFit potentialFit;
+	potentialFit.set(Read::text(function.arguments()[0]));
+	
+	// Run the fit
+	potentialFit.fit(*data.potential().local());
+	
+	// Print the fitted potentials
+	Output::decrease();
+	Output::newline();
+	Output::print("Fitted potentials");
+	if (outFile != "stdout")
+	{
+		Output::print(" written to ");
+		Output::print(outFile);
+	}
+	Output::increase();
+	potentialFit.write(outFile);
+	
+	// Output
+	Output::decrease();
+}
+
+
+
 /* void Launcher::kmc(Storage& data, const Function& function)
  *
  * Run KMC simulation
@@ -3890,13 +4127,9 @@ void Launcher::neighbors(Storage& data, const Function& function)
 	Output::print("Calculating nearest neighbor distances");
 	Output::increase();
 	
-	// Loop over structures to calculate distances
+	// Loop over structures to get atoms
 	int i, j, k, m;
-	int index;
 	List<Atom*>::D2 atoms(data.iso().length());
-	List<double>::D3 distances(data.iso().length());
-	List<Word>::D3 elements(data.iso().length());
-	OList<Vector3D >::D3 cells(data.iso().length());
 	for (i = 0; i < data.iso().length(); ++i)
 	{
 		
@@ -3912,33 +4145,6 @@ void Launcher::neighbors(Storage& data, const Function& function)
 		// Get atoms
 		atoms[i] = getAtoms(data.iso()[i], function);
 		
-		// Loop over atoms and calculate distances
-		cells[i].length(atoms[i].length());
-		distances[i].length(atoms[i].length());
-		elements[i].length(atoms[i].length());
-		for (j = 0; j < atoms[i].length(); ++j)
-		{
-			
-			// Loop over atoms in the structure and calculate distances
-			cells[i][j].length(data.iso()[i].numAtoms());
-			distances[i][j].length(data.iso()[i].numAtoms());
-			elements[i][j].length(data.iso()[i].numAtoms());
-			for (k = 0; k < data.iso()[i].atoms().length(); ++k)
-			{
-				for (m = 0; m < data.iso()[i].atoms()[k].length(); ++m)
-				{
-					index = data.iso()[i].atoms()[k][m].atomNumber();
-					elements[i][j][index] = data.iso()[i].atoms()[k][m].element().symbol();
-					if (index == atoms[i][j]->atomNumber())
-						distances[i][j][index] = data.iso()[i].basis().secondDistance(atoms[i][j]->fractional(), \
-							FRACTIONAL, atoms[i][j]->fractional(), FRACTIONAL, &cells[i][j][index]);
-					else
-						distances[i][j][index] = data.iso()[i].basis().distance(atoms[i][j]->fractional(), \
-							FRACTIONAL, data.iso()[i].atoms()[k][m].fractional(), FRACTIONAL, &cells[i][j][index]);
-				}
-			}
-		}
-		
 		// Output if there is more than one structure
 		if (data.iso().length() > 1)
 			Output::decrease();
@@ -3949,9 +4155,12 @@ void Launcher::neighbors(Storage& data, const Function& function)
 	message.addSpaces(false);
 	List<PrintAlign> align(12, RIGHT);
 	
-	// Print neighbors lists
+	// Print neighbors lists (distances are calculated for one atom at a time)
 	int minIndex;
-	double minDistance;
+	double minDistance = 0;
+	Atom* curAtom;
+	List<double> distances;
+	OList<Vector3D> cells;
 	PrintMethod origMethod = Output::method();
 	for (i = 0; i < data.iso().length(); ++i)
 	{
@@ -3961,36 +4170,44 @@ void Launcher::neighbors(Storage& data, const Function& function)
 		Output::method(STANDARD);
 		
 		// Loop over atoms
+		distances.length(data.iso()[i].numAtoms());
+		cells.length(data.iso()[i].numAtoms());
 		for (j = 0; j < atoms[i].length(); ++j)
 		{
 			
-			// Find the nearest atom
+			// Get distances to all atoms and find the nearest
 			minIndex = 0;
-			minDistance = distances[i][j][0];
-			for (k = 1; k < distances[i][j].length(); ++k)
+			for (k = 0; k < distances.length(); ++k)
 			{
-				if (distances[i][j][k] < minDistance)
+				curAtom = data.iso()[i].atom(k);
+				if (curAtom == atoms[i][j])
+					distances[k] = data.iso()[i].basis().secondDistance(atoms[i][j]->fractional(), FRACTIONAL, \
+						atoms[i][j]->fractional(), FRACTIONAL, &cells[k]);
+				else
+					distances[k] = data.iso()[i].basis().distance(atoms[i][j]->fractional(), FRACTIONAL, \
+						curAtom->fractional(), FRACTIONAL, &cells[k]);
+				if ((k == 0) || (distances[k] < minDistance))
 				{
 					minIndex = k;
-					minDistance = distances[i][j][k];
+					minDistance = distances[k];
 				}
 			}
 			
 			// Save distances as a message
 			message.clear();
-			message.addLines(distances[i][j].length() + 1);
-			for (k = 0; k < distances[i][j].length(); ++k)
+			message.addLines(distances.length() + 1);
+			for (k = 0; k < distances.length(); ++k)
 			{
 				message.addLine();
 				message.addWords(12);
 				message.add("    ");
 				message.add(Word("Atom ") + Language::numberToWord(k+1));
-				message.add(Word(" (") + elements[i][j][k] + "): ");
-				message.add(distances[i][j][k], 4);
+				message.add(Word(" (") + data.iso()[i].atom(k)->element().symbol() + "): ");
+				message.add(distances[k], 4);
 				message.add(" (");
 				for (m = 0; m < 3; ++m)
 				{
-					message.add((int)cells[i][j][k][m]);
+					message.add((int)cells[k][m]);
 					if (m != 2)
 						message.add(", ");
 				}
@@ -4046,6 +4263,7 @@ void Launcher::shells(Storage& data, const Function& function)
 	
 	// Loop over structures to calculate distances
 	int j;
+	NeighborList neighbors;
 	List<Atom*>::D2 atoms(data.iso().length());
 	OList<Atom>::D4 shells(data.iso().length());
 	for (i = 0; i < data.iso().length(); ++i)
@@ -4063,10 +4281,11 @@ void Launcher::shells(Storage& data, const Function& function)
 		// Get atoms
 		atoms[i] = getAtoms(data.iso()[i], function, false);
 		
-		// Calculate shells
+		// Calculate shells from a neighbor list out to the maximum distance
+		neighbors.set(data.iso()[i], maxDistance, false);
 		shells[i].length(atoms[i].length());
 		for (j = 0; j < atoms[i].length(); ++j)
-			shells[i][j] = data.iso()[i].shells(atoms[i][j], maxDistance, Settings::value<double>(TOLERANCE));
+			shells[i][j] = data.iso()[i].shells(atoms[i][j], neighbors, Settings::value<double>(TOLERANCE));
 		
 		// Output if there is more than one structure
 		if (data.iso().length() > 1)
@@ -4212,6 +4431,8 @@ void Launcher::coordination(Storage& data, const Function& function)
 	
 	// Loop over structures
 	int i, j;
+	double cutoff;
+	NeighborList neighbors;
 	List<Atom*>::D2 atoms(data.iso().length());
 	List<Atom*>::D3 coordinations(data.iso().length());
 	for (i = 0; i < data.iso().length(); ++i)
@@ -4229,10 +4450,17 @@ void Launcher::coordination(Storage& data, const Function& function)
 		// Get atoms
 		atoms[i] = getAtoms(data.iso()[i], function);
 		
+		// Build neighbor list out to twice the average spacing between atoms (atoms whose nearest neighbor is
+		// farther away than this are searched directly)
+		cutoff = 0;
+		if (data.iso()[i].numAtoms())
+			cutoff = 2 * pow(data.iso()[i].basis().volume() / data.iso()[i].numAtoms(), 1.0/3.0);
+		neighbors.set(data.iso()[i], cutoff, false);
+		
 		// Loop over atoms to calculate
 		coordinations[i].length(atoms[i].length());
 		for (j = 0; j < atoms[i].length(); ++j)
-			coordinations[i][j] = data.iso()[i].coordination(atoms[i][j]);
+			coordinations[i][j] = data.iso()[i].coordination(atoms[i][j], neighbors);
 		
 		// Output if there is more than one structure
 		if (data.iso().length() > 1)
@@ -31,6 +31,8 @@
 #include "potential.h"
 #include "phonons.h"
 #include "kmc.h"
+#include "md.h"
+#include "potentialFit.h"
 #include "diffraction.h"
 #include "random.h"
 #include "text.h"
@@ -42,8 +44,8 @@
 enum Keyword {KEY_NONE, KEY_SETTINGS, KEY_HELP, KEY_NUMPROCS, KEY_OUTPUT, KEY_TIME, KEY_TOLERANCE, KEY_PRINT, \
 	KEY_NAME, KEY_FIX, KEY_REMOVE, KEY_NEIGHBORS, KEY_SHELLS, KEY_COORDINATION, KEY_REDUCED, KEY_PRIMITIVE, \
 	KEY_CONVENTIONAL, KEY_IDEAL, KEY_SHIFT, KEY_TRANSFORM, KEY_ROTATE, KEY_SYMMETRY, KEY_UNIQUE, KEY_EQUIVALENT, \
-	KEY_ABOUT, KEY_POINTGROUP, KEY_SPACEGROUP, KEY_REFINE, KEY_ENERGY, KEY_FORCES, KEY_PHONONS, KEY_KMC, \
-	KEY_DIFFRACTION, KEY_PERTURB, KEY_RELAX, KEY_OPT, KEY_INTERSTITIAL, KEY_COMPARE};
+	KEY_ABOUT, KEY_POINTGROUP, KEY_SPACEGROUP, KEY_REFINE, KEY_ENERGY, KEY_FORCES, KEY_PHONONS, KEY_MD, KEY_FIT, \
+	KEY_KMC, KEY_DIFFRACTION, KEY_PERTURB, KEY_RELAX, KEY_OPT, KEY_INTERSTITIAL, KEY_COMPARE};
 
 
 
@@ -182,6 +184,8 @@ class Launcher
 	static void energy(Storage& data);
 	static void forces(Storage& data);
 	static void phonons(Storage& data, const Function& function);
+	static void md(Storage& data, const Function& function);
+	static void fit(Storage& data, const Function& function);
 	
 	// Diffusion functions
 	static void kmc(Storage& data, const Function& function);
@@ -26,6 +26,8 @@
 #include "relax.h"
 #include "output.h"
 #include "electrostatic.h"
+#include "wolf.h"
+#include "eam.h"
 
 
 
@@ -50,6 +52,80 @@ void SingleLocalPotential::readError(const OList<Word>& line)
 
 
 
+/* double SingleLocalPotential::deltaEnergy(const ISO& iso, const LocalMove& move) const
+ *
+ * Return the change in energy from applying a local move to a structure by evaluating the full energy
+ *	before and after the move (used by potentials that do not have an incremental evaluation)
+ */
+
+double SingleLocalPotential::deltaEnergy(const ISO& iso, const LocalMove& move) const
+{
+	double before = 0;
+	evaluate(iso, &before);
+	ISO moved(iso);
+	move.apply(moved);
+	double after = 0;
+	evaluate(moved, &after);
+	return after - before;
+}
+
+
+
+/* double SingleLocalPotential::localPairEnergy(const ISO& iso, const NeighborList& reference,
+ *		const LocalMove& move, bool after) const
+ *
+ * Return the pairwise energy of all interactions that involve atoms changed by a move, either before or
+ *	after the move. Interactions with unchanged atoms are found with the reference neighbor list, and
+ *	interactions between changed atoms (including their own images) are weighted by one half since each
+ *	pair is visited twice.
+ */
+
+double SingleLocalPotential::localPairEnergy(const ISO& iso, const NeighborList& reference, \
+	const LocalMove& move, bool after) const
+{
+	
+	// Loop over changed atoms
+	int i, j;
+	double res = 0;
+	List<int> nearAtoms;
+	List<double> nearDistances;
+	ImageIterator images(iso.basis(), reference.cutoff());
+	for (i = 0; i < move.length(); ++i)
+	{
+		
+		// Skip if atom is not in the structure
+		if (!move.present(i, after))
+			continue;
+		
+		// Add interactions with atoms that are not changed
+		reference.near(move.fractional(i, after), nearAtoms, nearDistances);
+		for (j = 0; j < nearAtoms.length(); ++j)
+		{
+			if (!move.contains(nearAtoms[j]))
+				res += interaction(move.element(i, after), reference.atom(nearAtoms[j])->element(), \
+					nearDistances[j]);
+		}
+		
+		// Add interactions with changed atoms
+		for (j = 0; j < move.length(); ++j)
+		{
+			if (!move.present(j, after))
+				continue;
+			images.reset(move.fractional(i, after), move.fractional(j, after));
+			while (!images.finished())
+			{
+				if (++images > 1e-8)
+					res += interaction(move.element(i, after), move.element(j, after), images.distance()) / 2;
+			}
+		}
+	}
+	
+	// Return energy
+	return res;
+}
+
+
+
 /* void LocalPotential::add(const Text& input, PotentialType type)
  *
  * Add potential to local potential list
@@ -65,6 +141,14 @@ void LocalPotential::add(const Text& input, PotentialType type)
 	// Electrostatic (PEGS) potential
 	else if (type == PT_ELECTROSTATIC)
 		_potentials += new Electrostatic;
+	
+	// Damped-shifted-force (Wolf) potential
+	else if (type == PT_WOLF)
+		_potentials += new Wolf;
+	
+	// Embedded-atom method potential
+	else if (type == PT_EAM)
+		_potentials += new EAM;
 		
 	// Lennard-Jones potential
 	else if (type == PT_LENNARDJONES)
@@ -96,6 +180,8 @@ void LocalPotential::add(const Text& input, PotentialType type)
 	
 	// Add data for potential
 	_potentials.last()->set(input);
+	_potentials.last()->neighborSkin(_skin);
+	_potentials.last()->precision(_precision);
 }
 
 
@@ -103,7 +189,7 @@ void LocalPotential::add(const Text& input, PotentialType type)
 /* void LocalPotential::relax(ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces, bool restart,
  *		bool reduce) const
  *
- * Relax structure
+ * Relax structure (when screening, the relaxation is finished at full precision)
  */
 
 void LocalPotential::relax(ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces, bool restart, \
@@ -112,8 +198,15 @@ void LocalPotential::relax(ISO& iso, double* totalEnergy, OList<Vector3D >* tota
 	initialize(iso, totalEnergy, totalForces);
 	Relax relax;
 	relax.structure(iso, *this);
+	if (_precision == LP_SCREENING)
+	{
+		polish(true);
+		relax.structure(iso, *this);
+	}
 	if ((totalEnergy) || (totalForces))
 		single(iso, totalEnergy, totalForces);
+	if (_precision == LP_SCREENING)
+		polish(false);
 }
 
 
@@ -121,7 +214,7 @@ void LocalPotential::relax(ISO& iso, double* totalEnergy, OList<Vector3D >* tota
 /* void LocalPotential::relax(ISO& iso, const Symmetry& symmetry, double* totalEnergy, OList<Vector3D >* totalForces,
  *		bool restart, bool reduce) const
  *
- * Relax structure
+ * Relax structure (when screening, the relaxation is finished at full precision)
  */
 
 void LocalPotential::relax(ISO& iso, const Symmetry& symmetry, double* totalEnergy, OList<Vector3D >* totalForces, \
@@ -130,6 +223,261 @@ void LocalPotential::relax(ISO& iso, const Symmetry& symmetry, double* totalEner
 	initialize(iso, totalEnergy, totalForces);
 	Relax relax;
 	relax.structure(iso, *this, symmetry);
+	if (_precision == LP_SCREENING)
+	{
+		polish(true);
+		relax.structure(iso, *this, symmetry);
+	}
 	if ((totalEnergy) || (totalForces))
 		single(iso, symmetry, totalEnergy, totalForces);
+	if (_precision == LP_SCREENING)
+		polish(false);
+}
+
+
+
+/* void LocalPotential::polish(bool start) const
+ *
+ * Switch potentials to full precision for the final steps of a screening relaxation (start is true) or back
+ *	to screening precision (start is false)
+ */
+
+void LocalPotential::polish(bool start) const
+{
+	for (int i = 0; i < _potentials.length(); ++i)
+		_potentials[i]->precision((start) ? LP_FULL : _precision);
+}
+
+
+
+/* void LocalMove::clear()
+ *
+ * Clear all changes
+ */
+
+void LocalMove::clear()
+{
+	_atomNumbers.length(0);
+	for (int i = 0; i < 2; ++i)
+	{
+		_present[i].length(0);
+		_elements[i].length(0);
+		_positions[i].length(0);
+	}
+}
+
+
+
+/* int LocalMove::index(int atomNumber)
+ *
+ * Return the index of an atom in the move, adding it in its current state if it has not been changed yet
+ */
+
+int LocalMove::index(int atomNumber)
+{
+	
+	// Atom has already been changed
+	int i;
+	for (i = 0; i < _atomNumbers.length(); ++i)
+	{
+		if (_atomNumbers[i] == atomNumber)
+			return i;
+	}
+	
+	// Atom is not in the structure
+	Atom* atom = _iso->atom(atomNumber);
+	if (!atom)
+	{
+		Output::newline(ERROR);
+		Output::print("Atom ");
+		Output::print(atomNumber + 1);
+		Output::print(" is out of range so it cannot be changed in a local move");
+		Output::quit();
+	}
+	
+	// Save current state
+	_atomNumbers += atomNumber;
+	for (i = 0; i < 2; ++i)
+	{
+		_present[i] += true;
+		_elements[i] += atom->element();
+		_positions[i] += atom->fractional();
+	}
+	return _atomNumbers.length() - 1;
+}
+
+
+
+/* void LocalMove::displace(int atomNumber, const Vector3D& fractional)
+ *
+ * Move an atom to a new position
+ */
+
+void LocalMove::displace(int atomNumber, const Vector3D& fractional)
+{
+	Vector3D position = fractional;
+	ISO::moveIntoCell(position);
+	_positions[1][index(atomNumber)] = position;
+}
+
+
+
+/* void LocalMove::setElement(int atomNumber, const Element& element)
+ *
+ * Change the element of an atom
+ */
+
+void LocalMove::setElement(int atomNumber, const Element& element)
+{
+	_elements[1][index(atomNumber)] = element;
+}
+
+
+
+/* void LocalMove::swap(int atomNumber1, int atomNumber2)
+ *
+ * Swap the elements of two atoms
+ */
+
+void LocalMove::swap(int atomNumber1, int atomNumber2)
+{
+	int index1 = index(atomNumber1);
+	int index2 = index(atomNumber2);
+	Element element1 = _elements[1][index1];
+	_elements[1][index1] = _elements[1][index2];
+	_elements[1][index2] = element1;
+}
+
+
+
+/* void LocalMove::add(const Element& element, const Vector3D& fractional)
+ *
+ * Add an atom to the structure
+ */
+
+void LocalMove::add(const Element& element, const Vector3D& fractional)
+{
+	Vector3D position = fractional;
+	ISO::moveIntoCell(position);
+	_atomNumbers += -1;
+	_present[0] += false;
+	_present[1] += true;
+	for (int i = 0; i < 2; ++i)
+	{
+		_elements[i] += element;
+		_positions[i] += position;
+	}
+}
+
+
+
+/* void LocalMove::remove(int atomNumber)
+ *
+ * Remove an atom from the structure
+ */
+
+void LocalMove::remove(int atomNumber)
+{
+	_present[1][index(atomNumber)] = false;
+}
+
+
+
+/* bool LocalMove::contains(int atomNumber) const
+ *
+ * Return whether an atom in the structure is changed by the move
+ */
+
+bool LocalMove::contains(int atomNumber) const
+{
+	for (int i = 0; i < _atomNumbers.length(); ++i)
+	{
+		if (_atomNumbers[i] == atomNumber)
+			return true;
+	}
+	return false;
+}
+
+
+
+/* bool LocalMove::changesComposition() const
+ *
+ * Return whether the number of atoms of any element is changed by the move
+ */
+
+bool LocalMove::changesComposition() const
+{
+	
+	// Get the change in the number of each element
+	int i, j;
+	OList<Element> elements;
+	List<int> changes;
+	for (i = 0; i < _atomNumbers.length(); ++i)
+	{
+		for (int after = 0; after < 2; ++after)
+		{
+			if (!_present[after][i])
+				continue;
+			for (j = 0; j < elements.length(); ++j)
+			{
+				if (elements[j] == _elements[after][i])
+					break;
+			}
+			if (j == elements.length())
+			{
+				elements += _elements[after][i];
+				changes += 0;
+			}
+			changes[j] += (after) ? 1 : -1;
+		}
+	}
+	
+	// Check if any number changed
+	for (i = 0; i < changes.length(); ++i)
+	{
+		if (changes[i])
+			return true;
+	}
+	return false;
+}
+
+
+
+/* void LocalMove::apply(ISO& iso) const
+ *
+ * Apply the move to a structure
+ */
+
+void LocalMove::apply(ISO& iso) const
+{
+	
+	// Update atoms that stay in the structure and save atoms to remove
+	int i;
+	List<int> removed;
+	iso.beginEdit();
+	for (i = 0; i < _atomNumbers.length(); ++i)
+	{
+		if (_atomNumbers[i] < 0)
+			continue;
+		if (!_present[1][i])
+		{
+			removed += _atomNumbers[i];
+			continue;
+		}
+		if (iso.atom(_atomNumbers[i])->element() != _elements[1][i])
+			iso.setElement(_atomNumbers[i], _elements[1][i], false);
+		iso.atom(_atomNumbers[i])->fractional(_positions[1][i]);
+	}
+	
+	// Add new atoms
+	for (i = 0; i < _atomNumbers.length(); ++i)
+	{
+		if ((_atomNumbers[i] < 0) && (_present[1][i]))
+			iso.addAtom(_elements[1][i])->fractional(_positions[1][i]);
+	}
+	
+	// Remove atoms and renumber once
+	for (i = 0; i < removed.length(); ++i)
+		iso.removeAtom(removed[i], false);
+	iso.commitEdit();
 }
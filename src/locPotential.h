@@ -34,22 +34,103 @@
 
 
 
+// Precision of local potential evaluations (screening is faster but approximate)
+enum LocalPrecision {LP_FULL, LP_SCREENING};
+
+
+
+/**
+ * Change to a small number of atoms in a structure, used to get energy differences for local moves
+ *
+ * The state of each atom before the move is taken from the structure when the atom is first
+ *	added to the move. Atoms that are added to the structure have an atom number of -1.
+ */
+class LocalMove
+{
+	
+	// Variables
+	const ISO* _iso;
+	List<int> _atomNumbers;
+	List<bool> _present[2];
+	OList<Element> _elements[2];
+	OList<Vector3D > _positions[2];
+	
+	// Functions
+	int index(int atomNumber);
+	
+public:
+	
+	// Constructor
+	LocalMove(const ISO& iso)	{ _iso = &iso; }
+	
+	// Setup functions
+	void clear();
+	void displace(int atomNumber, const Vector3D& fractional);
+	void setElement(int atomNumber, const Element& element);
+	void swap(int atomNumber1, int atomNumber2);
+	void add(const Element& element, const Vector3D& fractional);
+	void remove(int atomNumber);
+	
+	// Apply move to structure
+	void apply(ISO& iso) const;
+	
+	// Access functions (after is false for the state before the move and true for the state after it)
+	int length() const									{ return _atomNumbers.length(); }
+	int atomNumber(int index) const						{ return _atomNumbers[index]; }
+	bool present(int index, bool after) const			{ return _present[after][index]; }
+	const Element& element(int index, bool after) const	{ return _elements[after][index]; }
+	const Vector3D& fractional(int index, bool after) const	{ return _positions[after][index]; }
+	bool contains(int atomNumber) const;
+	bool changesComposition() const;
+};
+
+
+
 // Single local potential
 class SingleLocalPotential
 {
 protected:
 	
+	// Variables
+	double _skin;
+	LocalPrecision _precision;
+	mutable const ISO* _committedISO;
+	mutable unsigned long int _committed;
+	
 	// Functions
+	bool committed(const ISO& iso) const
+		{ return ((_committed) && (_committedISO == &iso) && (_committed == iso.revision())); }
+	void markCommitted(const ISO& iso) const	{ _committedISO = &iso; _committed = iso.revision(); }
 	void readError(const OList<Word>& line);
+	double localPairEnergy(const ISO& iso, const NeighborList& reference, const LocalMove& move, bool after) const;
+	
+	/** Pairwise interaction used by localPairEnergy (must be zero beyond the cutoff of the reference list) */
+	virtual double interaction(const Element& elem1, const Element& elem2, double distance) const	{ return 0; }
 	
 public:
 	
+	// Constructor
+	SingleLocalPotential()	{ _skin = 0; _precision = LP_FULL; _committedISO = 0; _committed = 0; }
+	
 	// Virtual functions
 	virtual ~SingleLocalPotential() {}
 	virtual void set(const Text& input) = 0;
 	virtual void evaluate(const ISO& iso, double* energy = 0, OList<Vector3D >* forces = 0) const = 0;
 	virtual void evaluate(const ISO& iso, const Symmetry& symmetry, double* energy = 0, \
 		OList<Vector3D >* forces = 0) const = 0;
+	
+	// Energy changes for local moves (reference is saved again if the structure changed since commit)
+	virtual void commit(const ISO& iso) const	{ markCommitted(iso); }
+	virtual double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+	
+	/** Skin used by neighbor lists that are reused between evaluations (zero to rebuild every evaluation) */
+	void neighborSkin(double input)	{ _skin = input; }
+	
+	/** Precision of later evaluations */
+	virtual void precision(LocalPrecision input)	{ _precision = input; }
+	LocalPrecision precision() const				{ return _precision; }
+	/** Estimate of the absolute error of each term of the energy at the current precision (eV) */
+	virtual double errorEstimate() const			{ return 0; }
 };
 
 
@@ -59,14 +140,18 @@ class LocalPotential : public IPO
 {
 	
 	// Variables
+	double _skin;
+	LocalPrecision _precision;
 	List<SingleLocalPotential*> _potentials;
 	
 	// Functions
 	void initialize(const ISO& iso, double* energy, OList<Vector3D >* forces) const;
+	void polish(bool start) const;
 	
 public:
 	
-	// Destructor
+	// Constructor and destructor
+	LocalPotential()	{ _skin = 0; _precision = LP_FULL; }
 	~LocalPotential();
 	
 	// Setup from file
@@ -87,6 +172,23 @@ public:
 	// NEB
 	void neb(OList<ISO>& isos, double* tsEnergy = 0, ISO* tsISO = 0) const;
 	
+	// Energy changes for local moves
+	void commit(const ISO& iso) const;
+	double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+	
+	// Neighbor list reuse between evaluations of a moving structure
+	void neighborSkin(double input);
+	double neighborSkin() const	{ return _skin; }
+	
+	// Precision of evaluations (relaxations always finish at full precision)
+	void precision(LocalPrecision input);
+	LocalPrecision precision() const	{ return _precision; }
+	double errorEstimate() const;
+	
+	// Access functions
+	int numPotentials() const							{ return _potentials.length(); }
+	SingleLocalPotential* potential(int index) const	{ return _potentials[index]; }
+	
 	// Other functions
 	bool usesSymmetry() const	{ return true;  }
 	bool supportsNEB()  const	{ return false; }
@@ -157,6 +259,77 @@ inline void LocalPotential::single(const ISO& iso, const Symmetry& symmetry, dou
 
 
 
+/* inline void LocalPotential::neighborSkin(double input)
+ *
+ * Set the skin of neighbor lists that are reused between evaluations
+ */
+
+inline void LocalPotential::neighborSkin(double input)
+{
+	_skin = input;
+	for (int i = 0; i < _potentials.length(); ++i)
+		_potentials[i]->neighborSkin(input);
+}
+
+
+
+/* inline void LocalPotential::precision(LocalPrecision input)
+ *
+ * Set the precision of later evaluations
+ */
+
+inline void LocalPotential::precision(LocalPrecision input)
+{
+	_precision = input;
+	for (int i = 0; i < _potentials.length(); ++i)
+		_potentials[i]->precision(input);
+}
+
+
+
+/* inline double LocalPotential::errorEstimate() const
+ *
+ * Return the sum of the estimated errors of each term of the energy over all potentials
+ */
+
+inline double LocalPotential::errorEstimate() const
+{
+	double res = 0;
+	for (int i = 0; i < _potentials.length(); ++i)
+		res += _potentials[i]->errorEstimate();
+	return res;
+}
+
+
+
+/* inline void LocalPotential::commit(const ISO& iso) const
+ *
+ * Save structure as the reference state for energy changes of local moves
+ */
+
+inline void LocalPotential::commit(const ISO& iso) const
+{
+	for (int i = 0; i < _potentials.length(); ++i)
+		_potentials[i]->commit(iso);
+}
+
+
+
+/* inline double LocalPotential::deltaEnergy(const ISO& iso, const LocalMove& move) const
+ *
+ * Return the change in energy from applying a local move to the reference structure
+ */
+
+inline double LocalPotential::deltaEnergy(const ISO& iso, const LocalMove& move) const
+{
+	double res = 0;
+	for (int i = 0; i < _potentials.length(); ++i)
+		res += _potentials[i]->deltaEnergy(iso, move);
+	return res;
+}
+
+
+
 /* inline void LocalPotential::neb(OList<ISO>& isos, double* tsEnergy, ISO* tsISO) const
  *
  * NEB calculation
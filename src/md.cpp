@@ -0,0 +1,421 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "multi.h"
+#include "md.h"
+#include "constants.h"
+#include "output.h"
+#include <cmath>
+
+
+
+/* void MD::run(ISO& iso, LocalPotential& potential, const Random& random)
+ *
+ * Integrate equations of motion with velocity Verlet. Langevin dynamics uses the BAOAB splitting and the
+ *		Nose-Hoover thermostat is applied in half steps around the Verlet step. The target temperature is ramped
+ *		linearly from the start to the end temperature, so the same run can be used for simulated annealing.
+ */
+
+void MD::run(ISO& iso, LocalPotential& potential, const Random& random)
+{
+	
+	// Unknown thermostat
+	if (_thermostat == MDT_UNKNOWN)
+	{
+		Output::newline(ERROR);
+		Output::print("Unknown molecular dynamics thermostat");
+		Output::quit();
+	}
+	
+	// Output
+	Output::newline();
+	Output::print("Running ");
+	Output::print(_numSteps);
+	Output::print(" molecular dynamics step");
+	if (_numSteps != 1)
+		Output::print("s");
+	if (_thermostat == MDT_NVE)
+		Output::print(" in the NVE ensemble");
+	else
+	{
+		Output::print(" using ");
+		Output::print(thermostatType(_thermostat));
+		Output::print(" thermostat");
+	}
+	Output::increase();
+	
+	// Set masses and velocities
+	setMasses(iso);
+	if (_velocities.length() != iso.numAtoms())
+		initializeVelocities(iso, _startTemperature, random);
+	
+	// Reuse neighbor lists between steps
+	double origSkin = potential.neighborSkin();
+	potential.neighborSkin(_skin);
+	
+	// Open trajectory file
+	int origStream = Output::streamID();
+	int trajectoryStream = -1;
+	if ((_trajectoryFrequency > 0) && (_trajectoryFile.length() > 0))
+	{
+		trajectoryStream = Output::addStream(_trajectoryFile);
+		Output::setStream(trajectoryStream);
+		Output::method(STANDARD);
+		Output::setStream(origStream);
+	}
+	
+	// Mass of Nose-Hoover thermostat
+	double maxTemperature = (_startTemperature > _endTemperature) ? _startTemperature : _endTemperature;
+	double thermostatMass = degreesOfFreedom() * Constants::kb * maxTemperature * _damping * _damping;
+	if ((_thermostat == MDT_NOSE_HOOVER) && (thermostatMass <= 0))
+	{
+		Output::newline(ERROR);
+		Output::print("Nose-Hoover thermostat requires a positive temperature and damping time");
+		Output::quit();
+	}
+	
+	// Initial forces
+	_thermostatVelocity = 0;
+	_thermostatEnergy = 0;
+	evaluateForces(iso, potential);
+	printStep(0, _startTemperature);
+	
+	// Loop over steps
+	int step;
+	double curTemperature;
+	for (step = 1; step <= _numSteps; ++step)
+	{
+		
+		// Target temperature
+		curTemperature = _startTemperature + (_endTemperature - _startTemperature) * step / _numSteps;
+		
+		// First half of thermostat
+		if (_thermostat == MDT_NOSE_HOOVER)
+			noseHoover(_timeStep / 2, curTemperature, thermostatMass);
+		
+		// Update velocities and positions
+		kick(_timeStep / 2);
+		if (_thermostat == MDT_LANGEVIN)
+		{
+			drift(iso, _timeStep / 2);
+			langevin(_timeStep, curTemperature, random);
+			drift(iso, _timeStep / 2);
+		}
+		else
+			drift(iso, _timeStep);
+		
+		// Update forces and velocities
+		evaluateForces(iso, potential);
+		kick(_timeStep / 2);
+		
+		// Second half of thermostat
+		if (_thermostat == MDT_NOSE_HOOVER)
+			noseHoover(_timeStep / 2, curTemperature, thermostatMass);
+		
+		// Print step
+		if ((_printFrequency > 0) && ((step % _printFrequency == 0) || (step == _numSteps)))
+			printStep(step, curTemperature);
+		
+		// Save structure to trajectory
+		if ((trajectoryStream >= 0) && (step % _trajectoryFrequency == 0))
+		{
+			Output::setStream(trajectoryStream);
+			StructureIO::write("", iso, _trajectoryFormat);
+			Output::setStream(origStream);
+		}
+	}
+	
+	// Reset settings
+	if (trajectoryStream >= 0)
+		Output::removeStream(trajectoryStream);
+	potential.neighborSkin(origSkin);
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/* void MD::initializeVelocities(const ISO& iso, double temperature, const Random& random)
+ *
+ * Draw velocities from the Maxwell-Boltzmann distribution, remove the motion of the center of mass, and scale to
+ *		the exact temperature
+ */
+
+void MD::initializeVelocities(const ISO& iso, double temperature, const Random& random)
+{
+	
+	// Set masses
+	setMasses(iso);
+	
+	// Draw velocities (random numbers are taken from the root processor so all processors agree)
+	int i;
+	double sigma;
+	double totalMass = 0;
+	Vector3D momentum(0.0);
+	List<double> normal(3 * iso.numAtoms());
+	random.fillNormal(normal, 0, 1);
+	if (normal.length())
+		Multi::broadcast(&normal[0], normal.length(), 0);
+	_velocities.length(iso.numAtoms());
+	for (i = 0; i < _velocities.length(); ++i)
+	{
+		sigma = sqrt(Constants::kb * temperature / _masses[i]) / timeUnit();
+		for (int j = 0; j < 3; ++j)
+			_velocities[i][j] = (sigma > 0) ? sigma * normal[3*i + j] : 0;
+		momentum += _velocities[i] * _masses[i];
+		totalMass += _masses[i];
+	}
+	
+	// Remove motion of the center of mass
+	if (_velocities.length() > 1)
+	{
+		momentum /= totalMass;
+		for (i = 0; i < _velocities.length(); ++i)
+			_velocities[i] -= momentum;
+	}
+	
+	// Scale to temperature
+	double curTemperature = this->temperature();
+	if (curTemperature > 0)
+	{
+		double scale = sqrt(temperature / curTemperature);
+		for (i = 0; i < _velocities.length(); ++i)
+			_velocities[i] *= scale;
+	}
+}
+
+
+
+/* double MD::kineticEnergy() const
+ *
+ * Return the kinetic energy in eV
+ */
+
+double MD::kineticEnergy() const
+{
+	double res = 0;
+	for (int i = 0; i < _velocities.length(); ++i)
+		res += _masses[i] * (_velocities[i] * _velocities[i]);
+	return res * timeUnit() * timeUnit() / 2;
+}
+
+
+
+/* double MD::temperature() const
+ *
+ * Return the instantaneous temperature
+ */
+
+double MD::temperature() const
+{
+	if (!_velocities.length())
+		return 0;
+	return 2 * kineticEnergy() / (degreesOfFreedom() * Constants::kb);
+}
+
+
+
+/* double MD::conservedEnergy() const
+ *
+ * Return the potential plus kinetic energy, including the energy of the Nose-Hoover thermostat if used (the
+ *		work done by the bath is accumulated at the target temperature of each step so the sum is conserved when
+ *		the temperature is ramped)
+ */
+
+double MD::conservedEnergy() const
+{
+	double res = _potentialEnergy + kineticEnergy();
+	if (_thermostat == MDT_NOSE_HOOVER)
+	{
+		double maxTemperature = (_startTemperature > _endTemperature) ? _startTemperature : _endTemperature;
+		double thermostatMass = degreesOfFreedom() * Constants::kb * maxTemperature * _damping * _damping;
+		res += thermostatMass * _thermostatVelocity * _thermostatVelocity / 2;
+		res += _thermostatEnergy;
+	}
+	return res;
+}
+
+
+
+/* void MD::setMasses(const ISO& iso)
+ *
+ * Save the mass of each atom by atom number
+ */
+
+void MD::setMasses(const ISO& iso)
+{
+	int i, j;
+	_masses.length(iso.numAtoms());
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+			_masses[iso.atoms()[i][j].atomNumber()] = iso.atoms()[i][j].element().mass();
+	}
+	for (i = 0; i < _masses.length(); ++i)
+	{
+		if (_masses[i] <= 0)
+		{
+			Output::newline(ERROR);
+			Output::print("Mass is not known for an element in molecular dynamics simulation");
+			Output::quit();
+		}
+	}
+}
+
+
+
+/* void MD::evaluateForces(const ISO& iso, const LocalPotential& potential)
+ *
+ * Get the energy and cartesian forces of the current structure
+ */
+
+void MD::evaluateForces(const ISO& iso, const LocalPotential& potential)
+{
+	potential.single(iso, &_potentialEnergy, &_forces);
+	iso.basis().toCartesian(_forces);
+}
+
+
+
+/* void MD::kick(double time)
+ *
+ * Update velocities from the current forces
+ */
+
+void MD::kick(double time)
+{
+	double scale = time / (timeUnit() * timeUnit());
+	for (int i = 0; i < _velocities.length(); ++i)
+		_velocities[i] += _forces[i] * (scale / _masses[i]);
+}
+
+
+
+/* void MD::drift(ISO& iso, double time)
+ *
+ * Update positions from the current velocities
+ */
+
+void MD::drift(ISO& iso, double time)
+{
+	int i, j;
+	Atom* atom;
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+		{
+			atom = &iso.atoms()[i][j];
+			atom->cartesian(atom->cartesian() + _velocities[atom->atomNumber()] * time);
+		}
+	}
+}
+
+
+
+/* void MD::langevin(double time, double temperature, const Random& random)
+ *
+ * Exact solution of the Ornstein-Uhlenbeck part of Langevin dynamics over a time
+ */
+
+void MD::langevin(double time, double temperature, const Random& random)
+{
+	int i, j;
+	double sigma;
+	double decay = exp(-time / _damping);
+	double noise = sqrt(1 - decay * decay);
+	List<double> normal(3 * _velocities.length());
+	random.fillNormal(normal, 0, 1);
+	if (normal.length())
+		Multi::broadcast(&normal[0], normal.length(), 0);
+	for (i = 0; i < _velocities.length(); ++i)
+	{
+		sigma = noise * sqrt(Constants::kb * temperature / _masses[i]) / timeUnit();
+		_velocities[i] *= decay;
+		if (sigma > 0)
+		{
+			for (j = 0; j < 3; ++j)
+				_velocities[i][j] += sigma * normal[3*i + j];
+		}
+	}
+}
+
+
+
+/* void MD::noseHoover(double time, double temperature, double mass)
+ *
+ * Propagate Nose-Hoover thermostat and scale velocities over a time
+ */
+
+void MD::noseHoover(double time, double temperature, double mass)
+{
+	
+	// Update thermostat velocity over first half
+	double target = degreesOfFreedom() * Constants::kb * temperature;
+	_thermostatVelocity += time * (2 * kineticEnergy() - target) / (2 * mass);
+	
+	// Scale velocities
+	double scale = exp(-_thermostatVelocity * time);
+	for (int i = 0; i < _velocities.length(); ++i)
+		_velocities[i] *= scale;
+	_thermostatEnergy += target * _thermostatVelocity * time;
+	
+	// Update thermostat velocity over second half
+	_thermostatVelocity += time * (2 * kineticEnergy() - target) / (2 * mass);
+}
+
+
+
+/* void MD::printStep(int step, double temperature) const
+ *
+ * Print the state of the simulation
+ */
+
+void MD::printStep(int step, double temperature) const
+{
+	if (_printFrequency <= 0)
+		return;
+	Output::newline();
+	Output::print("Step ");
+	Output::print(step);
+	Output::print(": T = ");
+	Output::print(this->temperature(), 2);
+	Output::print(" K (target ");
+	Output::print(temperature, 2);
+	Output::print(" K), potential energy = ");
+	Output::print(_potentialEnergy, 8);
+	Output::print(" eV, conserved energy = ");
+	Output::print(conservedEnergy(), 8);
+	Output::print(" eV");
+}
+
+
+
+/* double MD::timeUnit()
+ *
+ * Return the time unit of eV, Angstroms and amu in femtoseconds
+ */
+
+double MD::timeUnit()
+{
+	return 1e15 * sqrt(Constants::joule / Constants::kg) / Constants::meter;
+}
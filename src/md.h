@@ -0,0 +1,185 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef MD_H
+#define MD_H
+
+
+
+#include "iso.h"
+#include "locPotential.h"
+#include "structureIO.h"
+#include "random.h"
+#include "text.h"
+#include "num.h"
+#include "list.h"
+
+
+
+// Thermostats
+enum MDThermostat {MDT_UNKNOWN, MDT_NVE, MDT_LANGEVIN, MDT_NOSE_HOOVER};
+
+
+
+// Class to run molecular dynamics with velocity Verlet integration
+class MD
+{
+	
+	// Settings
+	int _numSteps;
+	int _printFrequency;
+	int _trajectoryFrequency;
+	double _timeStep;
+	double _startTemperature;
+	double _endTemperature;
+	double _damping;
+	double _skin;
+	MDThermostat _thermostat;
+	Word _trajectoryFile;
+	StructureFormat _trajectoryFormat;
+	
+	// State of the simulation
+	double _potentialEnergy;
+	double _thermostatVelocity;
+	double _thermostatEnergy;
+	OList<Vector3D > _velocities;
+	
+	// Storage variables
+	List<double> _masses;
+	OList<Vector3D > _forces;
+	
+	// Functions
+	void setMasses(const ISO& iso);
+	void evaluateForces(const ISO& iso, const LocalPotential& potential);
+	void kick(double time);
+	void drift(ISO& iso, double time);
+	void langevin(double time, double temperature, const Random& random);
+	void noseHoover(double time, double temperature, double mass);
+	void printStep(int step, double temperature) const;
+	
+	// Helper functions
+	int degreesOfFreedom() const	{ return (_masses.length() > 1) ? 3 * _masses.length() - 3 : 3; }
+	static double timeUnit();
+
+public:
+	
+	// Constructor
+	MD();
+	
+	// Setup functions
+	void numSteps(int input)							{ _numSteps = input; }
+	void timeStep(double input)							{ _timeStep = input; }
+	void temperature(double input)						{ _startTemperature = _endTemperature = input; }
+	void temperature(double start, double end)			{ _startTemperature = start; _endTemperature = end; }
+	void thermostat(MDThermostat input)					{ _thermostat = input; }
+	void damping(double input)							{ _damping = input; }
+	void neighborSkin(double input)						{ _skin = input; }
+	void printFrequency(int input)						{ _printFrequency = input; }
+	void trajectory(const Word& file, StructureFormat format, int frequency)
+		{ _trajectoryFile = file; _trajectoryFormat = format; _trajectoryFrequency = frequency; }
+	
+	// Velocities
+	void initializeVelocities(const ISO& iso, double temperature, const Random& random);
+	void clearVelocities()								{ _velocities.clear(); }
+	const OList<Vector3D >& velocities() const			{ return _velocities; }
+	
+	// Run functions
+	void run(ISO& iso, LocalPotential& potential, const Random& random);
+	
+	// Access functions
+	double potentialEnergy() const						{ return _potentialEnergy; }
+	double kineticEnergy() const;
+	double temperature() const;
+	double conservedEnergy() const;
+	
+	// Helper functions
+	static MDThermostat thermostatType(const Word& input);
+	static Word thermostatType(MDThermostat input);
+};
+
+
+
+/* inline MD::MD()
+ *
+ * Constructor for MD object
+ */
+
+inline MD::MD()
+{
+	_numSteps = 1000;
+	_printFrequency = 100;
+	_trajectoryFrequency = 0;
+	_timeStep = 1;
+	_startTemperature = 300;
+	_endTemperature = 300;
+	_damping = 100;
+	_skin = 1;
+	_thermostat = MDT_LANGEVIN;
+	_trajectoryFormat = SF_VASP5;
+	_potentialEnergy = 0;
+	_thermostatVelocity = 0;
+	_thermostatEnergy = 0;
+}
+
+
+
+/* inline MDThermostat MD::thermostatType(const Word& input)
+ *
+ * Convert word to thermostat
+ */
+
+inline MDThermostat MD::thermostatType(const Word& input)
+{
+	if ((input.equal("nve", false)) || (input.equal("none", false)))
+		return MDT_NVE;
+	if (input.equal("langevin", false, 4))
+		return MDT_LANGEVIN;
+	if ((input.equal("nose-hoover", false, 4)) || (input.equal("nvt", false)))
+		return MDT_NOSE_HOOVER;
+	return MDT_UNKNOWN;
+}
+
+
+
+/* inline Word MD::thermostatType(MDThermostat input)
+ *
+ * Convert thermostat to word
+ */
+
+inline Word MD::thermostatType(MDThermostat input)
+{
+	switch (input)
+	{
+		case MDT_NVE:
+			return Word("NVE");
+		case MDT_LANGEVIN:
+			return Word("Langevin");
+		case MDT_NOSE_HOOVER:
+			return Word("Nose-Hoover");
+		default:
+			return Word("Unknown");
+	}
+}
+
+
+
+#endif
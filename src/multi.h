@@ -97,6 +97,9 @@ public:
 	static void broadcast(Vector3D& vector, int root);
 	static void broadcast(  Vector& vector, int root);
 	
+	// Combine values that were each set on one processor and sum them independent of the number of processors
+	static double sum(List<double>& values);
+	
 	// Access functions
 	static int rank()		{ return _rank; }
 	static int worldSize()	{ return _worldSize; }
@@ -257,4 +260,21 @@ inline void Multi::broadcast(Vector& vector, int root)
 
 
 
+/* inline double Multi::sum(List<double>& values)
+ *
+ * Add together lists from all processors where each value is non-zero on at most one processor, then return the
+ *		pairwise sum of the values
+ */
+
+inline double Multi::sum(List<double>& values)
+{
+	#ifdef MINT_MPI
+		if ((_worldSize > 1) && (values.length()))
+			MPI_Allreduce(MPI_IN_PLACE, &values[0], values.length(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+	#endif
+	return Num<double>::sum(values.length(), values.array());
+}
+
+
+
 #endif
@@ -32,7 +32,7 @@
 
 
 // Numerical integration methods
-enum IntegrationMethod {GAUSSLEGENDRE};
+enum IntegrationMethod {GAUSSLEGENDRE, GAUSSKRONROD};
 
 // Numerical root finding methods
 enum RootMethod {BRENT, BISECTION};
@@ -63,12 +63,22 @@ struct Complex
 #define DGEEV  dgeev_
 #define DSYEV  dsyev_
 #define DSYEVD dsyevd_
+#define DSYEVR dsyevr_
 #define ZGEEV  zgeev_
 #define ZHEEV  zheev_
 #define ZHEEVD zheevd_
+#define ZHEEVR zheevr_
 #endif // MINT_MKL
 
 
+// Storage class for data that is local to each thread
+#if __cplusplus >= 201103L
+#define MINT_THREAD_LOCAL thread_local
+#else
+#define MINT_THREAD_LOCAL __thread
+#endif
+
+
 // BLAS and LAPACK
 extern "C"
 {
@@ -138,6 +148,70 @@ extern "C"
 	void   ZHEEVD (const char* jobZ, const char* upOrLow, const int* sizeA, Complex* A, const int* ldA, \
 				   double* evals, Complex* work, const int* lenWork, double* rWork, const int* lenRWork, \
 				   int* iWork, const int* lenIWork, int* info);
+	
+	// Subset of eigenvalues/eigenvectors of real symmetric matrix using relatively robust representations
+	void   DSYEVR (const char* jobZ, const char* range, const char* upOrLow, const int* sizeA, double* A, \
+				   const int* ldA, const double* minVal, const double* maxVal, const int* minIndex, \
+				   const int* maxIndex, const double* absTol, int* numFound, double* evals, double* evecs, \
+				   const int* ldEVecs, int* support, double* work, const int* lenWork, int* iWork, \
+				   const int* lenIWork, int* info);
+	
+	// Subset of eigenvalues/eigenvectors of Hermitian matrix using relatively robust representations
+	void   ZHEEVR (const char* jobZ, const char* range, const char* upOrLow, const int* sizeA, Complex* A, \
+				   const int* ldA, const double* minVal, const double* maxVal, const int* minIndex, \
+				   const int* maxIndex, const double* absTol, int* numFound, double* evals, Complex* evecs, \
+				   const int* ldEVecs, int* support, Complex* work, const int* lenWork, double* rWork, \
+				   const int* lenRWork, int* iWork, const int* lenIWork, int* info);
+};
+
+
+
+// Reusable heap work space for LAPACK calls (each thread has its own buffers)
+template <class T>
+class Workspace
+{
+	
+	// Functions
+	static T*& buffer(int slot);
+	static int& length(int slot);
+	
+public:
+	
+	// Number of buffers that can be used at once
+	static const int numSlots = 4;
+	
+	// Get buffer with at least given length
+	static T* get(int inLength, int slot = 0);
+	
+	// Release memory
+	static void clear();
+};
+
+
+
+// Compensated sum of a sequence of values
+class Accumulator
+{
+	
+	// Variables
+	double _sum;
+	double _compensation;
+	
+public:
+	
+	// Constructor
+	Accumulator()	{ clear(); }
+	
+	// Setup functions
+	void clear()	{ _sum = _compensation = 0; }
+	
+	// Add values
+	Accumulator& operator+= (double value);
+	Accumulator& operator-= (double value)	{ return *this += -value; }
+	Accumulator& operator+= (const Accumulator& rhs);
+	
+	// Access functions
+	double value() const	{ return _sum + _compensation; }
 };
 
 
@@ -340,6 +414,8 @@ class Matrix
 	
 	// Functions
 	void initialize();
+	static void symmetricEigen(int size, double* matrix, double* evals, bool getEigenvectors);
+	static void generalEigen(int size, double* matrix, double* evals, double* evecs);
 	
 public:
 	
@@ -379,6 +455,8 @@ public:
 	Matrix  inverse       ()                  const;
 	Vector  solve         (const Vector& rhs) const;
 	Vector  eigenvalues   (Matrix* eigenvectors = 0, bool isSymmetric = false) const;
+	Vector  eigenvalueRange (int first, int last, Matrix* eigenvectors = 0) const;
+	Vector  eigenvaluesInPlace (bool getEigenvectors = false, bool isSymmetric = false);
 	
 	// Reductions
 	Matrix rowEchelon(int* swaps = 0, Matrix* operations = 0, bool integer = false) const;
@@ -411,6 +489,8 @@ class CMatrix
 	
 	// Functions
 	void initialize();
+	static void hermitianEigen(int size, Complex* matrix, CVector& evals, bool getEigenvectors);
+	static void generalEigen(int size, Complex* matrix, CVector& evals, Complex* evecs);
 	
 public:
 	
@@ -437,6 +517,8 @@ public:
 	
 	// Functions
 	CVector eigenvalues(CMatrix* eigenvectors = 0, bool isHermitian = false) const;
+	CVector eigenvalueRange(int first, int last, CMatrix* eigenvectors = 0) const;
+	CVector eigenvaluesInPlace(bool getEigenvectors = false, bool isHermitian = false);
 	
 	// Access functions
 	int            numRows ()                    const	{ return _numRows; }
@@ -490,6 +572,8 @@ public:
 	Matrix3D& operator-=    (const Matrix3D& rhs);
 	Vector3D  operator*     (const double* rhs)          const;
 	Vector3D  operator*     (const Vector3D& rhs)        const;
+	double    quadratic     (const Vector3D& vec)        const;
+	void      transform     (OList<Vector3D>& vectors)   const;
 	Matrix3D  operator*     (double rhs)                 const;
 	Matrix3D  operator*     (const Matrix3D& rhs)        const;
 	Matrix3D& operator*=    (const Matrix3D& rhs);
@@ -518,6 +602,68 @@ public:
 
 
 
+// Class to store a 3D matrix of integers
+class IMatrix3D
+{
+	
+	// Variables
+	long _matrix[9];
+	
+	// Helper functions
+	static long floorDiv (long num, long den);
+	void swapColumns     (int col1, int col2);
+	void addRow          (int row, int source, long mult);
+	void addColumn       (int col, int source, long mult);
+	
+public:
+	
+	// Constructors
+	IMatrix3D();
+	IMatrix3D(long value);
+	IMatrix3D(long val11, long val12, long val13, long val21, long val22, long val23, long val31, long val32, \
+			  long val33);
+	
+	// Setup functions
+	void fill         (long input);
+	void set          (long val11, long val12, long val13, long val21, long val22, long val23, long val31, \
+					   long val32, long val33);
+	bool set          (const Matrix3D& matrix, double tol);
+	void swapRows     (int row1, int row2);
+	void makeIdentity ();
+	
+	// General functions
+	bool operator== (const IMatrix3D& rhs) const;
+	bool operator!= (const IMatrix3D& rhs) const;
+	bool isDiagonal () const;
+	
+	// Math operators
+	long       determinant () const;
+	IMatrix3D  adjugate    () const;
+	IMatrix3D  inverse     () const;
+	IMatrix3D  transpose   () const;
+	IMatrix3D  operator*   (const IMatrix3D& rhs) const;
+	IMatrix3D& operator*=  (const IMatrix3D& rhs);
+	Matrix3D   toDouble    () const;
+	
+	// Reductions
+	IMatrix3D hermite    (IMatrix3D* operations = 0) const;
+	IMatrix3D smith      (IMatrix3D* rowOperations = 0, IMatrix3D* colOperations = 0) const;
+	long      cosetIndex (long* vector) const;
+	
+	// Access functions
+	const long& operator() (int row, int col) const	{ return  _matrix[3*row + col]; }
+	long&       operator() (int row, int col)		{ return  _matrix[3*row + col]; }
+	const long* operator[] (int row)          const	{ return &_matrix[3*row]; }
+	long*       operator[] (int row)				{ return &_matrix[3*row]; }
+	
+	// Static member functions
+	static IMatrix3D identity();
+	static OList<IMatrix3D> sublattices(int index);
+	static bool nextSublattice(int index, IMatrix3D& matrix);
+};
+
+
+
 template <class Tclass>
 class Functor
 {
@@ -532,6 +678,7 @@ class Functor
 	double (Tclass::*_objFunPtrVec)(const Vector&);
 	double (*_funPtrVecArg)(const Vector&, double);
 	double (Tclass::*_objFunPtrVecArg)(const Vector&, double);
+	bool _threadSafe;
 	
 	// Functions
 	void initialize();
@@ -551,6 +698,10 @@ public:
 	double operator() (double arg);
 	double operator() (const Vector& params);
 	double operator() (const Vector& params, double arg);
+	
+	// Whether function can be called from several threads at once
+	void threadSafe(bool input)	{ _threadSafe = input; }
+	bool threadSafe() const		{ return _threadSafe; }
 };
 
 
@@ -565,6 +716,7 @@ class VectorFunctor
 	Tclass* _objPtr;
 	Vector (*_funPtr)            (const Vector&, double);
 	Vector (Tclass::*_objFunPtr) (const Vector&, double);
+	bool _threadSafe;
 	
 	// Functions
 	void initialize();
@@ -578,6 +730,30 @@ public:
 	
 	// Access functions
 	Vector operator() (const Vector& params, double arg);
+	
+	// Whether function can be called from several threads at once
+	void threadSafe(bool input)	{ _threadSafe = input; }
+	bool threadSafe() const		{ return _threadSafe; }
+};
+
+
+
+// Adapter that evaluates a scalar integrand at a batch of points
+template <class Tfun>
+class BatchIntegrand
+{
+	
+	// Variables
+	Tfun* _fun;
+	
+public:
+	
+	// Constructor
+	BatchIntegrand(Tfun& fun)	{ _fun = &fun; }
+	
+	// Evaluate function at each point
+	template <class T>
+	void operator() (int num, const T* args, T* res)	{ for (int i = 0; i < num; ++i) res[i] = (*_fun)(args[i]); }
 };
 
 
@@ -588,8 +764,10 @@ class Num
 {
 	
 	// Integration point methods
-	static void GaussLegendrePoints(T min, T max, Matrix& points);
-	static T Legendre(const Matrix& coeffs, int order, T point);
+	static const int maxRuleOrder = 64;
+	static const double* GaussLegendreRule(int order);
+	template<class Tfun>
+	static T GaussKronrod(Tfun& fun, T min, T max, T* values, T& error);
 	
 public:
 	
@@ -655,9 +833,16 @@ public:
 	static T angle     (const T* vec1, const T* vec2);
 	static T volume    (const T* vec1, const T* vec2, const T* vec3);
 	
+	// Sum in an order that only depends on the number of values
+	static T sum (int length, const T* values);
+	
 	// Integration
-	template<class Tclass>
-	static T integrate(Functor<Tclass>& fun, T min, T max, IntegrationMethod method = GAUSSLEGENDRE);
+	template<class Tfun>
+	static T integrate(Tfun& fun, T min, T max, IntegrationMethod method = GAUSSLEGENDRE, double tol = 1e-4, \
+		T* error = 0);
+	template<class Tfun>
+	static T integrateBatch(Tfun& fun, T min, T max, IntegrationMethod method = GAUSSLEGENDRE, double tol = 1e-4, \
+		T* error = 0);
 };
 
 
@@ -676,15 +861,24 @@ public:
 	
 private:
 	
+	// Evaluate simplex vertices that are independent of each other
+	static void evaluateVertices (Functor<Tclass>& fun, const OList<Vector>& vertices, List<double>& values, \
+								  int start, int mult);
+	
 	// Root finding methods
 	static double brent     (Functor<Tclass>& fun, double target, double convergeArg, double convergeRes, \
 							 double min, double max, double& argRes);
 	static double bisection (Functor<Tclass>& fun, double target, double convergeArg, double convergeRes, \
 							 double min, double max, double& argRes);
 	
-	// Static helpers
-	static Functor<Tclass>* _functorFun;
-	static double NelderHelper(const Vector& args)	{ return (*_functorFun)(args[0]); }
+	// Helper for minimizing a function of one variable
+	struct NelderHelp
+	{
+		Functor<Tclass>* _functor;
+		double value(const Vector& args)	{ return (*_functor)(args[0]); }
+	};
+	static double NelderMead1D (Functor<Tclass>& fun, double convergeRes, double initial, double step, \
+								double& argRes, int mult);
 	
 public:
 	
@@ -731,8 +925,14 @@ class Fit
 	template <class Tclass>
 	static void LMBuildJacobian (const OList<List<double> >& data, VectorFunctor<Tclass>& deriv, Vector& params, \
 								 Matrix& jacobian, Matrix& jacobianTranspose);
+	template <class Tclass>
+	static void LMDiffJacobian  (const OList<List<double> >& data, Functor<Tclass>& fun, Vector& params, \
+								 const Vector& residuals, Matrix& jacobian, Matrix& jacobianTranspose);
 	static void LMSetMatrix     (Matrix& jacobian, Matrix& jacobianTranspose, double damper, Matrix& matrix);
 	template <class Tclass>
+	static Vector LMSolve       (const OList<List<double> >& data, Functor<Tclass>& fun, \
+								 VectorFunctor<Tclass>* deriv, const Vector& initial, double tol);
+	template <class Tclass>
 	static void LMGetResidual   (const OList<List<double> >& data, Functor<Tclass>& fun, Vector& params, \
 								 Vector& residuals);
 	
@@ -754,6 +954,11 @@ public:
 	static Vector LM (const OList<List<double> >& data, Functor<Tclass>& fun, VectorFunctor<Tclass>& deriv, \
 					  const Vector& initial, double tol = 1e-3);
 	
+	// Levenberg–Marquardt with finite difference derivatives
+	template <class Tclass>
+	static Vector LM (const OList<List<double> >& data, Functor<Tclass>& fun, const Vector& initial, \
+					  double tol = 1e-3);
+	
 	// General fit without derivatives using Nelder-Mead minimization method
 	template <class Tclass>
 	static Vector NM (const OList<List<double> >& data, Functor<Tclass>& fun, const Vector& initial, \
@@ -762,6 +967,113 @@ public:
 
 
 
+// =====================================================================================================================
+// Workspace
+// =====================================================================================================================
+
+/* inline T*& Workspace<T>::buffer(int slot)
+ *
+ * Return buffer in slot for the current thread
+ */
+
+template <class T>
+inline T*& Workspace<T>::buffer(int slot)
+{
+	static MINT_THREAD_LOCAL T* buffers[numSlots] = {0, 0, 0, 0};
+	return buffers[slot];
+}
+
+
+
+/* inline int& Workspace<T>::length(int slot)
+ *
+ * Return length of buffer in slot for the current thread
+ */
+
+template <class T>
+inline int& Workspace<T>::length(int slot)
+{
+	static MINT_THREAD_LOCAL int lengths[numSlots] = {0, 0, 0, 0};
+	return lengths[slot];
+}
+
+
+
+/* inline T* Workspace<T>::get(int inLength, int slot)
+ *
+ * Return buffer with at least the given length, contents are not preserved when the buffer grows
+ */
+
+template <class T>
+inline T* Workspace<T>::get(int inLength, int slot)
+{
+	if (inLength < 1)
+		inLength = 1;
+	if (length(slot) < inLength)
+	{
+		delete [] buffer(slot);
+		buffer(slot) = new T [inLength];
+		length(slot) = inLength;
+	}
+	return buffer(slot);
+}
+
+
+
+/* inline void Workspace<T>::clear()
+ *
+ * Release all buffers for the current thread
+ */
+
+template <class T>
+inline void Workspace<T>::clear()
+{
+	for (int i = 0; i < numSlots; ++i)
+	{
+		delete [] buffer(i);
+		buffer(i) = 0;
+		length(i) = 0;
+	}
+}
+
+
+
+// =====================================================================================================================
+// Accumulator
+// =====================================================================================================================
+
+/* inline Accumulator& Accumulator::operator+= (double value)
+ *
+ * Add value to sum and save the rounding error of the addition (Neumaier variant of Kahan summation)
+ */
+
+inline Accumulator& Accumulator::operator+= (double value)
+{
+	double temp = _sum + value;
+	if (fabs(_sum) >= fabs(value))
+		_compensation += (_sum - temp) + value;
+	else
+		_compensation += (value - temp) + _sum;
+	_sum = temp;
+	return *this;
+}
+
+
+
+/* inline Accumulator& Accumulator::operator+= (const Accumulator& rhs)
+ *
+ * Add another compensated sum
+ */
+
+inline Accumulator& Accumulator::operator+= (const Accumulator& rhs)
+{
+	*this += rhs._sum;
+	_compensation += rhs._compensation;
+	return *this;
+}
+
+
+
 // =====================================================================================================================
 // Complex numbers
 // =====================================================================================================================
@@ -1507,7 +1819,9 @@ inline Vector3D::Vector3D(double val1, double val2, double val3)
 
 inline Vector3D::Vector3D(const Vector3D& copy)
 {
-	*this = copy;
+	_vector[0] = copy._vector[0];
+	_vector[1] = copy._vector[1];
+	_vector[2] = copy._vector[2];
 }
 
 
@@ -2681,6 +2995,64 @@ inline Vector Matrix::solve(const Vector& rhs) const
 
 
 
+/* inline void Matrix::symmetricEigen(int size, double* matrix, double* evals, bool getEigenvectors)
+ *
+ * Diagonalize symmetric matrix in place using divide and conquer, eigenvectors overwrite matrix if requested
+ */
+
+inline void Matrix::symmetricEigen(int size, double* matrix, double* evals, bool getEigenvectors)
+{
+	
+	// Set job type
+	int info;
+	char jobZ = getEigenvectors ? 'V' : 'N';
+	char upOrLow = 'U';
+	
+	// Get size of work space
+	int lenWork = -1;
+	int lenIWork = -1;
+	int optIWork;
+	double optWork;
+	DSYEVD(&jobZ, &upOrLow, &size, matrix, &size, evals, &optWork, &lenWork, &optIWork, &lenIWork, &info);
+	lenWork = (int)optWork;
+	lenIWork = optIWork;
+	
+	// Get eigenvalues
+	DSYEVD(&jobZ, &upOrLow, &size, matrix, &size, evals, Workspace<double>::get(lenWork, 1), &lenWork, \
+		Workspace<int>::get(lenIWork), &lenIWork, &info);
+}
+
+
+
+/* inline void Matrix::generalEigen(int size, double* matrix, double* evals, double* evecs)
+ *
+ * Get real part of eigenvalues of general matrix, contents of matrix are destroyed
+ */
+
+inline void Matrix::generalEigen(int size, double* matrix, double* evals, double* evecs)
+{
+	
+	// Set job type
+	int info;
+	int one = 1;
+	char jobVL = 'N';
+	char jobVR = evecs == 0 ? 'N' : 'V';
+	double* imagEVals = Workspace<double>::get(size, 2);
+	
+	// Get size of work space
+	int lenWork = -1;
+	double optWork;
+	DGEEV(&jobVL, &jobVR, &size, matrix, &size, evals, imagEVals, 0, &one, evecs, &size, &optWork, &lenWork, \
+		&info);
+	lenWork = (int)optWork;
+	
+	// Get eigenvalues
+	DGEEV(&jobVL, &jobVR, &size, matrix, &size, evals, imagEVals, 0, &one, evecs, &size, \
+		Workspace<double>::get(lenWork, 1), &lenWork, &info);
+}
+
+
+
 /* inline Vector Matrix::eigenvalues(Matrix* eigenvectors, bool isSymmetric) const
  *
  * Get eigenvalues for real matrix
@@ -2693,63 +3065,137 @@ inline Vector Matrix::eigenvalues(Matrix* eigenvectors, bool isSymmetric) const
 	if (_numRows != _numCols)
 		return Vector(0);
 	
-	// Common variables
-	int info;
-	Matrix matCopy(*this);
-	
 	// Variable to store eigenvalues
+	int one = 1;
 	Vector res(_numRows);
 	
+	// Matrix is symmetric and eigenvectors are needed so diagonalize them directly
+	if ((isSymmetric) && (eigenvectors))
+	{
+		*eigenvectors = *this;
+		symmetricEigen(_numRows, eigenvectors->_matrix, res._vector, true);
+		return res;
+	}
+	
+	// Copy matrix to work space
+	double* matCopy = Workspace<double>::get(_length);
+	DCOPY(&_length, _matrix, &one, matCopy, &one);
+	
 	// Matrix is symmetric
 	if (isSymmetric)
+		symmetricEigen(_numRows, matCopy, res._vector, false);
+	
+	// Matrix is not symmetric
+	else
 	{
-		
-		// Work space
-		int lenIWork = eigenvectors == 0 ? 2                  : 2 * (3 + 5*_numRows);
-		int lenWork  = eigenvectors == 0 ? 2 * (_numRows + 1) : 2 * (1 + 6*_numRows + 2*_numRows*_numRows);
-		int    iWork[lenIWork];
-		double  work[lenWork];
-		
-		// Set job type
-		char jobZ = eigenvectors == 0 ? 'N' : 'V';
-		char upOrLow = 'U';
-		
-		// Get eigenvalues
-		DSYEVD(&jobZ, &upOrLow, &_numRows, matCopy._matrix, &_numRows, res._vector, work, &lenWork, iWork, \
-			   &lenIWork, &info);
-		
-		// Save eigenvectors
 		if (eigenvectors)
-			*eigenvectors = matCopy;
+			eigenvectors->size(_numRows);
+		generalEigen(_numRows, matCopy, res._vector, eigenvectors == 0 ? 0 : eigenvectors->_matrix);
+	}
+	
+	// Return eigenvalues
+	return res;
+}
+
+
+
+/* inline Vector Matrix::eigenvalueRange(int first, int last, Matrix* eigenvectors) const
+ *
+ * Get eigenvalues first through last (counting from zero in ascending order) of symmetric matrix
+ */
+
+inline Vector Matrix::eigenvalueRange(int first, int last, Matrix* eigenvectors) const
+{
+	
+	// Matrix is not square or range is empty
+	if (_numRows != _numCols)
+		return Vector(0);
+	first = Num<int>::max(first, 0);
+	last = Num<int>::min(last, _numRows - 1);
+	if (first > last)
+		return Vector(0);
+	
+	// Copy matrix to work space
+	int one = 1;
+	double* matCopy = Workspace<double>::get(_length);
+	DCOPY(&_length, _matrix, &one, matCopy, &one);
+	
+	// Set job type
+	int info;
+	int numFound;
+	int minIndex = first + 1;
+	int maxIndex = last + 1;
+	double minVal = 0;
+	double maxVal = 0;
+	double absTol = 0;
+	char jobZ = eigenvectors == 0 ? 'N' : 'V';
+	char range = 'I';
+	char upOrLow = 'U';
+	double* evals = Workspace<double>::get(_numRows, 2);
+	int* support = Workspace<int>::get(2 * (last - first + 1), 1);
+	
+	// Make sure there is room for eigenvectors
+	double* evecs = 0;
+	if (eigenvectors)
+	{
+		eigenvectors->size(_numRows, last - first + 1);
+		evecs = eigenvectors->_matrix;
 	}
 	
+	// Get size of work space
+	int lenWork = -1;
+	int lenIWork = -1;
+	int optIWork;
+	double optWork;
+	DSYEVR(&jobZ, &range, &upOrLow, &_numRows, matCopy, &_numRows, &minVal, &maxVal, &minIndex, &maxIndex, \
+		&absTol, &numFound, evals, evecs, &_numRows, support, &optWork, &lenWork, &optIWork, &lenIWork, &info);
+	lenWork = (int)optWork;
+	lenIWork = optIWork;
+	
+	// Get eigenvalues
+	DSYEVR(&jobZ, &range, &upOrLow, &_numRows, matCopy, &_numRows, &minVal, &maxVal, &minIndex, &maxIndex, \
+		&absTol, &numFound, evals, evecs, &_numRows, support, Workspace<double>::get(lenWork, 1), &lenWork, \
+		Workspace<int>::get(lenIWork), &lenIWork, &info);
+	
+	// Return eigenvalues
+	Vector res(numFound);
+	DCOPY(&numFound, evals, &one, res._vector, &one);
+	return res;
+}
+
+
+
+/* inline Vector Matrix::eigenvaluesInPlace(bool getEigenvectors, bool isSymmetric)
+ *
+ * Get eigenvalues without copying the matrix, which is replaced by the eigenvectors if they are requested and
+ *		is otherwise left in an undefined state
+ */
+
+inline Vector Matrix::eigenvaluesInPlace(bool getEigenvectors, bool isSymmetric)
+{
+	
+	// Matrix is not square
+	if (_numRows != _numCols)
+		return Vector(0);
+	
+	// Variable to store eigenvalues
+	Vector res(_numRows);
+	
+	// Matrix is symmetric
+	if (isSymmetric)
+		symmetricEigen(_numRows, _matrix, res._vector, getEigenvectors);
+	
 	// Matrix is not symmetric
 	else
 	{
-		
-		// Work space
 		int one = 1;
-		int workSize = 8*_numRows;
-		double work[workSize];
-		double imagEVals[_numRows];
-
-		// Set job type
-		char jobVL = 'N';
-		char jobVR = eigenvectors == 0 ? 'N' : 'V';
-		
-		// Make sure there is room for eigenvectors if needed
-		if (eigenvectors)
-			eigenvectors->size(_numRows);
-		
-		// Dummy variable or pointer to eigenvectors
-		double* evecs = eigenvectors == 0 ? 0 : eigenvectors->_matrix;
-		
-		// Get eigenvalues
-		DGEEV(&jobVL, &jobVR, &_numRows, matCopy._matrix, &_numRows, res._vector, imagEVals, 0, &one, \
-			  evecs, &_numRows, work, &workSize, &info);
+		double* evecs = getEigenvectors ? Workspace<double>::get(_length) : 0;
+		generalEigen(_numRows, _matrix, res._vector, evecs);
+		if (getEigenvectors)
+			DCOPY(&_length, evecs, &one, _matrix, &one);
 	}
 	
-	// Return eigenvectors
+	// Return eigenvalues
 	return res;
 }
 
@@ -3106,85 +3552,227 @@ inline CMatrix& CMatrix::operator= (const CMatrix& rhs)
 
 
 
-/* inline CVector CMatrix::eigenvalues(CMatrix* eigenvectors, bool isHermitian) const
+/* inline void CMatrix::hermitianEigen(int size, Complex* matrix, CVector& evals, bool getEigenvectors)
  *
- * Get eigenvalues of matrix
+ * Diagonalize Hermitian matrix in place using divide and conquer, eigenvectors overwrite matrix if requested
  */
 
-inline CVector CMatrix::eigenvalues(CMatrix* eigenvectors, bool isHermitian) const
+inline void CMatrix::hermitianEigen(int size, Complex* matrix, CVector& evals, bool getEigenvectors)
 {
 	
-	// Matrix is not square
-	if (_numRows != _numCols)
-		return CVector(0);
-	
-	// Common variables
+	// Set job type
 	int info;
-	CMatrix matCopy(*this);
+	char jobZ = getEigenvectors ? 'V' : 'N';
+	char upOrLow = 'U';
+	double* realEVals = Workspace<double>::get(size);
+	
+	// Get size of work space
+	int lenWork = -1;
+	int lenRWork = -1;
+	int lenIWork = -1;
+	int optIWork;
+	double optRWork;
+	Complex optWork;
+	ZHEEVD(&jobZ, &upOrLow, &size, matrix, &size, realEVals, &optWork, &lenWork, &optRWork, &lenRWork, \
+		&optIWork, &lenIWork, &info);
+	lenWork = (int)optWork.real;
+	lenRWork = (int)optRWork;
+	lenIWork = optIWork;
+	
+	// Get eigenvalues
+	ZHEEVD(&jobZ, &upOrLow, &size, matrix, &size, realEVals, Workspace<Complex>::get(lenWork, 1), &lenWork, \
+		Workspace<double>::get(lenRWork, 1), &lenRWork, Workspace<int>::get(lenIWork), &lenIWork, &info);
 	
-	// Variable to store eigenvalues
-	CVector res(_numRows);
-	
-	// Matrix is Hermitian
-	if (isHermitian)
+	// Save eigenvalues
+	for (int i = 0; i < size; ++i)
 	{
-		
-		// Work space
-		int lenIWork = eigenvectors == 0 ? 2                  : 2 * (3 + 5*_numRows);
-		int lenRWork = eigenvectors == 0 ? 2 * _numRows       : 2 * (1 + 5*_numRows + 2*_numRows*_numRows);
-		int lenWork  = eigenvectors == 0 ? 2 * (_numRows + 1) : 2 * (2*_numRows + _numRows*_numRows);
-		int     iWork[lenIWork];
-		double  rWork[lenRWork];
-		Complex work [lenWork];
-		
-		// Set job type
-		char jobZ = eigenvectors == 0 ? 'N' : 'V';
-		char upOrLow = 'U';
-		
-		// Get eigenvalues
-		double evals[_numRows];
-		ZHEEVD(&jobZ, &upOrLow, &_numRows, matCopy._matrix, &_numRows, evals, work, &lenWork, rWork, \
-			   &lenRWork, iWork, &lenIWork, &info);
-		
-		// Save eigenvalues
-		for (int i = 0; i < _numRows; ++i)
-		{
-			res._vector[i].real = evals[i];
-			res._vector[i].imag = 0;
-		}
-		
-		// Save eigenvectors
-		if (eigenvectors)
-			*eigenvectors = matCopy;
+		evals._vector[i].real = realEVals[i];
+		evals._vector[i].imag = 0;
+	}
+}
+
+
+
+/* inline void CMatrix::generalEigen(int size, Complex* matrix, CVector& evals, Complex* evecs)
+ *
+ * Get eigenvalues of general complex matrix, contents of matrix are destroyed
+ */
+
+inline void CMatrix::generalEigen(int size, Complex* matrix, CVector& evals, Complex* evecs)
+{
+	
+	// Set job type
+	int info;
+	int one = 1;
+	char jobVL = 'N';
+	char jobVR = evecs == 0 ? 'N' : 'V';
+	double* rWork = Workspace<double>::get(2*size, 1);
+	
+	// Get size of work space
+	int lenWork = -1;
+	Complex optWork;
+	ZGEEV(&jobVL, &jobVR, &size, matrix, &size, evals._vector, 0, &one, evecs, &size, &optWork, &lenWork, rWork, \
+		&info);
+	lenWork = (int)optWork.real;
+	
+	// Get eigenvalues
+	ZGEEV(&jobVL, &jobVR, &size, matrix, &size, evals._vector, 0, &one, evecs, &size, \
+		Workspace<Complex>::get(lenWork, 1), &lenWork, rWork, &info);
+}
+
+
+
+/* inline CVector CMatrix::eigenvalues(CMatrix* eigenvectors, bool isHermitian) const
+ *
+ * Get eigenvalues of matrix
+ */
+
+inline CVector CMatrix::eigenvalues(CMatrix* eigenvectors, bool isHermitian) const
+{
+	
+	// Matrix is not square
+	if (_numRows != _numCols)
+		return CVector(0);
+	
+	// Variable to store eigenvalues
+	int one = 1;
+	CVector res(_numRows);
+	
+	// Matrix is Hermitian and eigenvectors are needed so diagonalize them directly
+	if ((isHermitian) && (eigenvectors))
+	{
+		*eigenvectors = *this;
+		hermitianEigen(_numRows, eigenvectors->_matrix, res, true);
+		return res;
 	}
 	
+	// Copy matrix to work space
+	Complex* matCopy = Workspace<Complex>::get(_length);
+	ZCOPY(&_length, _matrix, &one, matCopy, &one);
+	
+	// Matrix is Hermitian
+	if (isHermitian)
+		hermitianEigen(_numRows, matCopy, res, false);
+	
 	// Matrix is not hermitian
 	else
 	{
-		
-		// Work space
-		int one = 1;
-		int lWorkSize = 4*_numRows;
-		Complex lWork[lWorkSize];
-		double  rWork[2*_numRows];
-
-		// Set job type
-		char jobVL = 'N';
-		char jobVR = eigenvectors == 0 ? 'N' : 'V';
-		
-		// Make sure there is room for eigenvectors if needed
 		if (eigenvectors)
 			eigenvectors->size(_numRows);
-		
-		// Dummy variable or pointer to eigenvectors
-		Complex* evecs = eigenvectors == 0 ? 0 : eigenvectors->_matrix;
-		
-		// Get eigenvalues
-		ZGEEV(&jobVL, &jobVR, &_numRows, matCopy._matrix, &_numRows, res._vector, 0, &one, evecs, &_numRows, lWork, \
-			  &lWorkSize, rWork, &info);
+		generalEigen(_numRows, matCopy, res, eigenvectors == 0 ? 0 : eigenvectors->_matrix);
 	}
 	
-	// Return eigenvectors
+	// Return eigenvalues
+	return res;
+}
+
+
+
+/* inline CVector CMatrix::eigenvalueRange(int first, int last, CMatrix* eigenvectors) const
+ *
+ * Get eigenvalues first through last (counting from zero in ascending order) of Hermitian matrix
+ */
+
+inline CVector CMatrix::eigenvalueRange(int first, int last, CMatrix* eigenvectors) const
+{
+	
+	// Matrix is not square or range is empty
+	if (_numRows != _numCols)
+		return CVector(0);
+	first = Num<int>::max(first, 0);
+	last = Num<int>::min(last, _numRows - 1);
+	if (first > last)
+		return CVector(0);
+	
+	// Copy matrix to work space
+	int one = 1;
+	Complex* matCopy = Workspace<Complex>::get(_length);
+	ZCOPY(&_length, _matrix, &one, matCopy, &one);
+	
+	// Set job type
+	int info;
+	int numFound;
+	int minIndex = first + 1;
+	int maxIndex = last + 1;
+	double minVal = 0;
+	double maxVal = 0;
+	double absTol = 0;
+	char jobZ = eigenvectors == 0 ? 'N' : 'V';
+	char range = 'I';
+	char upOrLow = 'U';
+	double* evals = Workspace<double>::get(_numRows);
+	int* support = Workspace<int>::get(2 * (last - first + 1), 1);
+	
+	// Make sure there is room for eigenvectors
+	Complex* evecs = 0;
+	if (eigenvectors)
+	{
+		eigenvectors->size(_numRows, last - first + 1);
+		evecs = eigenvectors->_matrix;
+	}
+	
+	// Get size of work space
+	int lenWork = -1;
+	int lenRWork = -1;
+	int lenIWork = -1;
+	int optIWork;
+	double optRWork;
+	Complex optWork;
+	ZHEEVR(&jobZ, &range, &upOrLow, &_numRows, matCopy, &_numRows, &minVal, &maxVal, &minIndex, &maxIndex, \
+		&absTol, &numFound, evals, evecs, &_numRows, support, &optWork, &lenWork, &optRWork, &lenRWork, \
+		&optIWork, &lenIWork, &info);
+	lenWork = (int)optWork.real;
+	lenRWork = (int)optRWork;
+	lenIWork = optIWork;
+	
+	// Get eigenvalues
+	ZHEEVR(&jobZ, &range, &upOrLow, &_numRows, matCopy, &_numRows, &minVal, &maxVal, &minIndex, &maxIndex, \
+		&absTol, &numFound, evals, evecs, &_numRows, support, Workspace<Complex>::get(lenWork, 1), &lenWork, \
+		Workspace<double>::get(lenRWork, 1), &lenRWork, Workspace<int>::get(lenIWork), &lenIWork, &info);
+	
+	// Return eigenvalues
+	CVector res(numFound);
+	for (int i = 0; i < numFound; ++i)
+	{
+		res._vector[i].real = evals[i];
+		res._vector[i].imag = 0;
+	}
+	return res;
+}
+
+
+
+/* inline CVector CMatrix::eigenvaluesInPlace(bool getEigenvectors, bool isHermitian)
+ *
+ * Get eigenvalues without copying the matrix, which is replaced by the eigenvectors if they are requested and
+ *		is otherwise left in an undefined state
+ */
+
+inline CVector CMatrix::eigenvaluesInPlace(bool getEigenvectors, bool isHermitian)
+{
+	
+	// Matrix is not square
+	if (_numRows != _numCols)
+		return CVector(0);
+	
+	// Variable to store eigenvalues
+	CVector res(_numRows);
+	
+	// Matrix is Hermitian
+	if (isHermitian)
+		hermitianEigen(_numRows, _matrix, res, getEigenvectors);
+	
+	// Matrix is not hermitian
+	else
+	{
+		int one = 1;
+		Complex* evecs = getEigenvectors ? Workspace<Complex>::get(_length) : 0;
+		generalEigen(_numRows, _matrix, res, evecs);
+		if (getEigenvectors)
+			ZCOPY(&_length, evecs, &one, _matrix, &one);
+	}
+	
+	// Return eigenvalues
 	return res;
 }
 
@@ -3204,7 +3792,15 @@ inline Matrix3D::Matrix3D()
 
 inline Matrix3D::Matrix3D(const Matrix3D& copy)
 {
-	*this = copy;
+	_matrix[0] = copy._matrix[0];
+	_matrix[1] = copy._matrix[1];
+	_matrix[2] = copy._matrix[2];
+	_matrix[3] = copy._matrix[3];
+	_matrix[4] = copy._matrix[4];
+	_matrix[5] = copy._matrix[5];
+	_matrix[6] = copy._matrix[6];
+	_matrix[7] = copy._matrix[7];
+	_matrix[8] = copy._matrix[8];
 }
 
 inline Matrix3D::Matrix3D(double value)
@@ -3594,6 +4190,50 @@ inline Vector3D Matrix3D::operator* (const Vector3D& rhs) const
 
 
 
+/* inline double Matrix3D::quadratic(const Vector3D& vec) const
+ *
+ * Return vec * (matrix * vec) without forming the intermediate vector
+ */
+
+inline double Matrix3D::quadratic(const Vector3D& vec) const
+{
+	return vec[0] * (_matrix[0]*vec[0] + _matrix[1]*vec[1] + _matrix[2]*vec[2]) + \
+		   vec[1] * (_matrix[3]*vec[0] + _matrix[4]*vec[1] + _matrix[5]*vec[2]) + \
+		   vec[2] * (_matrix[6]*vec[0] + _matrix[7]*vec[1] + _matrix[8]*vec[2]);
+}
+
+
+
+/* inline void Matrix3D::transform(OList<Vector3D>& vectors) const
+ *
+ * Replace each vector in list with the product of matrix with the vector
+ */
+
+inline void Matrix3D::transform(OList<Vector3D>& vectors) const
+{
+	
+	// Keep matrix in local variables so that it is loaded once for all vectors
+	const double m0 = _matrix[0], m1 = _matrix[1], m2 = _matrix[2];
+	const double m3 = _matrix[3], m4 = _matrix[4], m5 = _matrix[5];
+	const double m6 = _matrix[6], m7 = _matrix[7], m8 = _matrix[8];
+	
+	// Loop over vectors
+	double x, y, z;
+	double* cur;
+	for (int i = 0; i < vectors.length(); ++i)
+	{
+		cur = vectors[i]._vector;
+		x = cur[0];
+		y = cur[1];
+		z = cur[2];
+		cur[0] = m0*x + m1*y + m2*z;
+		cur[1] = m3*x + m4*y + m5*z;
+		cur[2] = m6*x + m7*y + m8*z;
+	}
+}
+
+
+
 /* inline Matrix3D Matrix3D::operator* (const Matrix3D& rhs) const
  *
  * Multiply two matrices
@@ -3884,98 +4524,714 @@ inline Matrix3D Matrix3D::rowEchelon(int* swaps, Matrix3D* operations, bool inte
 			if (Num<double>::abs(res(rowIndex, pivCol)) > tol)
 			{
 
-				// Swap values on rows
-				found = true;
-				if (rowIndex != pivRow)
+				// Swap values on rows
+				found = true;
+				if (rowIndex != pivRow)
+				{
+					res.swapRows(pivRow, rowIndex);
+					if (swaps)
+						Num<int>::swap(swaps[pivRow], swaps[rowIndex]);
+					if (operations)
+						operations->swapRows(pivRow, rowIndex);
+				}
+				break;
+			}
+		}
+
+		// Increase column if needed
+		if (!found)
+		{
+			++pivCol;
+			continue;
+		}
+
+		// Loop over rest of rows and move smallest absolute value to top
+		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
+		{
+
+			// Found a new minimum
+			if ((Num<double>::abs(res(rowIndex, pivCol)) > tol) && \
+				(Num<double>::abs(res(rowIndex, pivCol)) < Num<double>::abs(res(pivRow, pivCol))))
+			{
+
+				// Swap values on rows
+				res.swapRows(pivRow, rowIndex);
+				if (swaps)
+					Num<int>::swap(swaps[pivRow], swaps[rowIndex]);
+				if (operations)
+					operations->swapRows(pivRow, rowIndex);
+			}
+		}
+
+		// Set pivot to a positive value
+		if (res(pivRow, pivCol) < 0)
+		{
+			for (colIndex = 0; colIndex < 3; ++colIndex)
+				res(pivRow, colIndex) *= -1;
+			if (operations)
+			{
+				for (colIndex = 0; colIndex < 3; ++colIndex)
+					(*operations)(pivRow, colIndex) *= -1;
+			}
+		}
+
+		// Set other rows
+		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
+		{
+
+			// Subtract multiple of pivot row
+			if (integer)
+				tempVal = Num<double>::floor(res(rowIndex, pivCol) / res(pivRow, pivCol));
+			else
+				tempVal = res(rowIndex, pivCol) / res(pivRow, pivCol);
+			if (Num<double>::abs(tempVal) < tol)
+				continue;
+			for (colIndex = 0; colIndex < 3; ++colIndex)
+				res(rowIndex, colIndex) -= tempVal * res(pivRow, colIndex);
+			if (operations)
+			{
+				for (colIndex = 0; colIndex < 3; ++colIndex)
+					(*operations)(rowIndex, colIndex) -= tempVal * (*operations)(pivRow, colIndex);
+			}
+		}
+
+		// Check if all zero below pivot
+		found = false;
+		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
+		{
+			if (Num<double>::abs(res(rowIndex, pivCol)) > tol)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		// Go to next row and column
+		if (!found)
+		{
+			++pivRow;
+			++pivCol;
+		}
+	}
+	
+	// Return matrix
+	return res;
+}
+
+
+
+
+// =====================================================================================================================
+// 3D integer matrix
+// =====================================================================================================================
+
+/* inline IMatrix3D::IMatrix3D()
+ *
+ * IMatrix3D constructors
+ */
+
+inline IMatrix3D::IMatrix3D()
+{  }
+
+inline IMatrix3D::IMatrix3D(long value)
+{
+	fill(value);
+}
+
+inline IMatrix3D::IMatrix3D(long val11, long val12, long val13, long val21, long val22, long val23, long val31, \
+							long val32, long val33)
+{
+	set(val11, val12, val13, val21, val22, val23, val31, val32, val33);
+}
+
+
+
+/* inline void IMatrix3D::fill(long input)
+ *
+ * Set all values in matrix
+ */
+
+inline void IMatrix3D::fill(long input)
+{
+	for (int i = 0; i < 9; ++i)
+		_matrix[i] = input;
+}
+
+
+
+/* inline void IMatrix3D::set(long val11, long val12, long val13, long val21, long val22, long val23, long val31,
+ *		long val32, long val33)
+ *
+ * Set the values in the matrix
+ */
+
+inline void IMatrix3D::set(long val11, long val12, long val13, long val21, long val22, long val23, long val31, \
+						   long val32, long val33)
+{
+	_matrix[0] = val11;
+	_matrix[1] = val12;
+	_matrix[2] = val13;
+	_matrix[3] = val21;
+	_matrix[4] = val22;
+	_matrix[5] = val23;
+	_matrix[6] = val31;
+	_matrix[7] = val32;
+	_matrix[8] = val33;
+}
+
+
+
+/* inline bool IMatrix3D::set(const Matrix3D& matrix, double tol)
+ *
+ * Set from rounded values of a real matrix and return whether all values were integers up to tol
+ */
+
+inline bool IMatrix3D::set(const Matrix3D& matrix, double tol)
+{
+	bool res = true;
+	for (int i = 0; i < 9; ++i)
+	{
+		_matrix[i] = (long) Num<double>::round(matrix[0][i], 1);
+		if (Num<double>::abs(matrix[0][i] - _matrix[i]) > tol)
+			res = false;
+	}
+	return res;
+}
+
+
+
+/* inline void IMatrix3D::swapRows(int row1, int row2)
+ *
+ * Swap two rows in the matrix
+ */
+
+inline void IMatrix3D::swapRows(int row1, int row2)
+{
+	if (row1 == row2)
+		return;
+	for (int i = 0; i < 3; ++i)
+		Num<long>::swap(_matrix[3*row1 + i], _matrix[3*row2 + i]);
+}
+
+
+
+/* inline void IMatrix3D::swapColumns(int col1, int col2)
+ *
+ * Swap two columns in the matrix
+ */
+
+inline void IMatrix3D::swapColumns(int col1, int col2)
+{
+	if (col1 == col2)
+		return;
+	for (int i = 0; i < 3; ++i)
+		Num<long>::swap(_matrix[3*i + col1], _matrix[3*i + col2]);
+}
+
+
+
+/* inline void IMatrix3D::addRow(int row, int source, long mult)
+ *
+ * Add multiple of source row to row
+ */
+
+inline void IMatrix3D::addRow(int row, int source, long mult)
+{
+	if (mult == 0)
+		return;
+	for (int i = 0; i < 3; ++i)
+		_matrix[3*row + i] += mult * _matrix[3*source + i];
+}
+
+
+
+/* inline void IMatrix3D::addColumn(int col, int source, long mult)
+ *
+ * Add multiple of source column to column
+ */
+
+inline void IMatrix3D::addColumn(int col, int source, long mult)
+{
+	if (mult == 0)
+		return;
+	for (int i = 0; i < 3; ++i)
+		_matrix[3*i + col] += mult * _matrix[3*i + source];
+}
+
+
+
+/* inline long IMatrix3D::floorDiv(long num, long den)
+ *
+ * Return floor of integer division
+ */
+
+inline long IMatrix3D::floorDiv(long num, long den)
+{
+	long res = num / den;
+	if ((num % den != 0) && ((num < 0) != (den < 0)))
+		--res;
+	return res;
+}
+
+
+
+/* inline void IMatrix3D::makeIdentity()
+ *
+ * Set matrix to identity
+ */
+
+inline void IMatrix3D::makeIdentity()
+{
+	set(1, 0, 0, 0, 1, 0, 0, 0, 1);
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::identity()
+ *
+ * Return identity matrix
+ */
+
+inline IMatrix3D IMatrix3D::identity()
+{
+	return IMatrix3D(1, 0, 0, 0, 1, 0, 0, 0, 1);
+}
+
+
+
+/* inline bool IMatrix3D::operator== (const IMatrix3D& rhs) const
+ *
+ * Return whether two matrices are the same
+ */
+
+inline bool IMatrix3D::operator== (const IMatrix3D& rhs) const
+{
+	for (int i = 0; i < 9; ++i)
+	{
+		if (_matrix[i] != rhs._matrix[i])
+			return false;
+	}
+	return true;
+}
+
+
+
+/* inline bool IMatrix3D::operator!= (const IMatrix3D& rhs) const
+ *
+ * Return whether two matrices are not the same
+ */
+
+inline bool IMatrix3D::operator!= (const IMatrix3D& rhs) const
+{
+	return !(*this == rhs);
+}
+
+
+
+/* inline bool IMatrix3D::isDiagonal() const
+ *
+ * Return whether all off-diagonal values are zero
+ */
+
+inline bool IMatrix3D::isDiagonal() const
+{
+	return (_matrix[1] == 0) && (_matrix[2] == 0) && (_matrix[3] == 0) && (_matrix[5] == 0) && \
+		   (_matrix[6] == 0) && (_matrix[7] == 0);
+}
+
+
+
+/* inline long IMatrix3D::determinant() const
+ *
+ * Return the determinant of the matrix
+ */
+
+inline long IMatrix3D::determinant() const
+{
+	return _matrix[0] * (_matrix[4] * _matrix[8] - _matrix[7] * _matrix[5]) - \
+		   _matrix[1] * (_matrix[3] * _matrix[8] - _matrix[5] * _matrix[6]) + \
+		   _matrix[2] * (_matrix[3] * _matrix[7] - _matrix[4] * _matrix[6]);
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::adjugate() const
+ *
+ * Return the adjugate of the matrix (M * adj(M) = det(M) * I)
+ */
+
+inline IMatrix3D IMatrix3D::adjugate() const
+{
+	return IMatrix3D(_matrix[4] * _matrix[8] - _matrix[7] * _matrix[5], \
+					 _matrix[2] * _matrix[7] - _matrix[8] * _matrix[1], \
+					 _matrix[1] * _matrix[5] - _matrix[4] * _matrix[2], \
+					 _matrix[5] * _matrix[6] - _matrix[8] * _matrix[3], \
+					 _matrix[0] * _matrix[8] - _matrix[6] * _matrix[2], \
+					 _matrix[2] * _matrix[3] - _matrix[5] * _matrix[0], \
+					 _matrix[3] * _matrix[7] - _matrix[6] * _matrix[4], \
+					 _matrix[1] * _matrix[6] - _matrix[7] * _matrix[0], \
+					 _matrix[0] * _matrix[4] - _matrix[3] * _matrix[1]);
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::inverse() const
+ *
+ * Return the exact inverse of a unimodular matrix
+ * For other matrices the inverse is adjugate() / determinant(), which is not integer
+ */
+
+inline IMatrix3D IMatrix3D::inverse() const
+{
+	IMatrix3D res = adjugate();
+	if (determinant() < 0)
+	{
+		for (int i = 0; i < 9; ++i)
+			res._matrix[i] *= -1;
+	}
+	return res;
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::transpose() const
+ *
+ * Return the transpose of the matrix
+ */
+
+inline IMatrix3D IMatrix3D::transpose() const
+{
+	return IMatrix3D(_matrix[0], _matrix[3], _matrix[6], _matrix[1], _matrix[4], _matrix[7], _matrix[2], \
+		_matrix[5], _matrix[8]);
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::operator* (const IMatrix3D& rhs) const
+ *
+ * Multiply two matrices
+ */
+
+inline IMatrix3D IMatrix3D::operator* (const IMatrix3D& rhs) const
+{
+	IMatrix3D res(0L);
+	int i, j, k;
+	for (i = 0; i < 3; ++i)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			for (k = 0; k < 3; ++k)
+				res._matrix[3*i + j] += _matrix[3*i + k] * rhs._matrix[3*k + j];
+		}
+	}
+	return res;
+}
+
+
+
+/* inline IMatrix3D& IMatrix3D::operator*= (const IMatrix3D& rhs)
+ *
+ * Multiply current matrix by another on the left, as for Matrix3D
+ */
+
+inline IMatrix3D& IMatrix3D::operator*= (const IMatrix3D& rhs)
+{
+	*this = rhs * *this;
+	return *this;
+}
+
+
+
+/* inline Matrix3D IMatrix3D::toDouble() const
+ *
+ * Return matrix as real values
+ */
+
+inline Matrix3D IMatrix3D::toDouble() const
+{
+	return Matrix3D(_matrix[0], _matrix[1], _matrix[2], _matrix[3], _matrix[4], _matrix[5], _matrix[6], \
+		_matrix[7], _matrix[8]);
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::hermite(IMatrix3D* operations) const
+ *
+ * Return the upper triangular Hermite normal form H = U * M where U is unimodular
+ * Pivots are positive and values above each pivot are in [0, pivot)
+ * Rows of H generate the same lattice as the rows of M
+ */
+
+inline IMatrix3D IMatrix3D::hermite(IMatrix3D* operations) const
+{
+
+	// Initialize
+	IMatrix3D res(*this);
+	IMatrix3D ops = identity();
+
+	// Loop over columns
+	int i;
+	int col;
+	int minRow;
+	int pivRow = 0;
+	long mult;
+	bool done;
+	for (col = 0; (col < 3) && (pivRow < 3); ++col)
+	{
+
+		// Reduce column by Euclidean algorithm until only the pivot is nonzero
+		done = false;
+		while (!done)
+		{
+
+			// Move smallest nonzero value to pivot row
+			minRow = -1;
+			for (i = pivRow; i < 3; ++i)
+			{
+				if ((res(i, col) != 0) && ((minRow == -1) || \
+					(Num<long>::abs(res(i, col)) < Num<long>::abs(res(minRow, col)))))
+					minRow = i;
+			}
+			if (minRow == -1)
+				break;
+			res.swapRows(pivRow, minRow);
+			ops.swapRows(pivRow, minRow);
+
+			// Remove multiple of pivot from lower rows
+			done = true;
+			for (i = pivRow + 1; i < 3; ++i)
+			{
+				mult = -floorDiv(res(i, col), res(pivRow, col));
+				res.addRow(i, pivRow, mult);
+				ops.addRow(i, pivRow, mult);
+				if (res(i, col) != 0)
+					done = false;
+			}
+		}
+
+		// No pivot in column
+		if (!done)
+			continue;
+
+		// Make pivot positive
+		if (res(pivRow, col) < 0)
+		{
+			res.addRow(pivRow, pivRow, -2);
+			ops.addRow(pivRow, pivRow, -2);
+		}
+
+		// Reduce values above pivot
+		for (i = 0; i < pivRow; ++i)
+		{
+			mult = -floorDiv(res(i, col), res(pivRow, col));
+			res.addRow(i, pivRow, mult);
+			ops.addRow(i, pivRow, mult);
+		}
+		++pivRow;
+	}
+
+	// Return result
+	if (operations)
+		*operations = ops;
+	return res;
+}
+
+
+
+/* inline IMatrix3D IMatrix3D::smith(IMatrix3D* rowOperations, IMatrix3D* colOperations) const
+ *
+ * Return the Smith normal form D = P * M * Q where P and Q are unimodular
+ * Diagonal values are non-negative and each divides the next
+ */
+
+inline IMatrix3D IMatrix3D::smith(IMatrix3D* rowOperations, IMatrix3D* colOperations) const
+{
+
+	// Initialize
+	IMatrix3D res(*this);
+	IMatrix3D P = identity();
+	IMatrix3D Q = identity();
+
+	// Loop over diagonal
+	int i, j;
+	int piv;
+	int minRow;
+	int minCol;
+	long mult;
+	bool clean;
+	for (piv = 0; piv < 3; ++piv)
+	{
+
+		// Loop until row and column of pivot are clear and pivot divides remaining values
+		while (true)
+		{
+
+			// Move smallest nonzero value in remaining block to pivot
+			minRow = -1;
+			minCol = -1;
+			for (i = piv; i < 3; ++i)
+			{
+				for (j = piv; j < 3; ++j)
+				{
+					if ((res(i, j) != 0) && ((minRow == -1) || \
+						(Num<long>::abs(res(i, j)) < Num<long>::abs(res(minRow, minCol)))))
+					{
+						minRow = i;
+						minCol = j;
+					}
+				}
+			}
+			if (minRow == -1)
+				break;
+			res.swapRows(piv, minRow);
+			P.swapRows(piv, minRow);
+			res.swapColumns(piv, minCol);
+			Q.swapColumns(piv, minCol);
+
+			// Clear column and row of pivot
+			clean = true;
+			for (i = piv + 1; i < 3; ++i)
+			{
+				mult = -floorDiv(res(i, piv), res(piv, piv));
+				res.addRow(i, piv, mult);
+				P.addRow(i, piv, mult);
+				if (res(i, piv) != 0)
+					clean = false;
+			}
+			for (j = piv + 1; j < 3; ++j)
+			{
+				mult = -floorDiv(res(piv, j), res(piv, piv));
+				res.addColumn(j, piv, mult);
+				Q.addColumn(j, piv, mult);
+				if (res(piv, j) != 0)
+					clean = false;
+			}
+			if (!clean)
+				continue;
+
+			// Pull in a row that is not divisible by the pivot
+			for (i = piv + 1; i < 3; ++i)
+			{
+				for (j = piv + 1; j < 3; ++j)
 				{
-					res.swapRows(pivRow, rowIndex);
-					if (swaps)
-						Num<int>::swap(swaps[pivRow], swaps[rowIndex]);
-					if (operations)
-						operations->swapRows(pivRow, rowIndex);
+					if (res(i, j) % res(piv, piv) != 0)
+					{
+						res.addRow(piv, i, 1);
+						P.addRow(piv, i, 1);
+						clean = false;
+						break;
+					}
 				}
-				break;
+				if (!clean)
+					break;
 			}
+			if (clean)
+				break;
 		}
 
-		// Increase column if needed
-		if (!found)
+		// Make pivot positive
+		if (res(piv, piv) < 0)
 		{
-			++pivCol;
-			continue;
+			res.addRow(piv, piv, -2);
+			P.addRow(piv, piv, -2);
 		}
+	}
 
-		// Loop over rest of rows and move smallest absolute value to top
-		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
-		{
+	// Return result
+	if (rowOperations)
+		*rowOperations = P;
+	if (colOperations)
+		*colOperations = Q;
+	return res;
+}
 
-			// Found a new minimum
-			if ((Num<double>::abs(res(rowIndex, pivCol)) > tol) && \
-				(Num<double>::abs(res(rowIndex, pivCol)) < Num<double>::abs(res(pivRow, pivCol))))
-			{
 
-				// Swap values on rows
-				res.swapRows(pivRow, rowIndex);
-				if (swaps)
-					Num<int>::swap(swaps[pivRow], swaps[rowIndex]);
-				if (operations)
-					operations->swapRows(pivRow, rowIndex);
-			}
-		}
 
-		// Set pivot to a positive value
-		if (res(pivRow, pivCol) < 0)
-		{
-			for (colIndex = 0; colIndex < 3; ++colIndex)
-				res(pivRow, colIndex) *= -1;
-			if (operations)
-			{
-				for (colIndex = 0; colIndex < 3; ++colIndex)
-					(*operations)(pivRow, colIndex) *= -1;
-			}
-		}
+/* inline long IMatrix3D::cosetIndex(long* vector) const
+ *
+ * Reduce a row vector by the rows of a nonsingular matrix in Hermite normal form and return the index of the
+ * coset of the lattice that it belongs to, which is in [0, determinant)
+ */
 
-		// Set other rows
-		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
-		{
+inline long IMatrix3D::cosetIndex(long* vector) const
+{
+	long mult;
+	long res = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		mult = floorDiv(vector[i], _matrix[4*i]);
+		for (int j = i; j < 3; ++j)
+			vector[j] -= mult * _matrix[3*i + j];
+		res = res * _matrix[4*i] + vector[i];
+	}
+	return res;
+}
 
-			// Subtract multiple of pivot row
-			if (integer)
-				tempVal = Num<double>::floor(res(rowIndex, pivCol) / res(pivRow, pivCol));
-			else
-				tempVal = res(rowIndex, pivCol) / res(pivRow, pivCol);
-			if (Num<double>::abs(tempVal) < tol)
-				continue;
-			for (colIndex = 0; colIndex < 3; ++colIndex)
-				res(rowIndex, colIndex) -= tempVal * res(pivRow, colIndex);
-			if (operations)
-			{
-				for (colIndex = 0; colIndex < 3; ++colIndex)
-					(*operations)(rowIndex, colIndex) -= tempVal * (*operations)(pivRow, colIndex);
-			}
-		}
 
-		// Check if all zero below pivot
-		found = false;
-		for (rowIndex = pivRow + 1; rowIndex < 3; ++rowIndex)
-		{
-			if (Num<double>::abs(res(rowIndex, pivCol)) > tol)
-			{
-				found = true;
-				break;
-			}
-		}
 
-		// Go to next row and column
-		if (!found)
+/* inline OList<IMatrix3D> IMatrix3D::sublattices(int index)
+ *
+ * Return the Hermite normal forms of all sublattices with a given index
+ */
+
+inline OList<IMatrix3D> IMatrix3D::sublattices(int index)
+{
+	OList<IMatrix3D> res;
+	IMatrix3D matrix(0);
+	while (nextSublattice(index, matrix))
+		res += matrix;
+	return res;
+}
+
+
+
+/* inline bool IMatrix3D::nextSublattice(int index, IMatrix3D& matrix)
+ *
+ * Move to the next Hermite normal form of a sublattice with a given index, so that sublattices can be enumerated
+ *	without storing all of them. Start from a matrix of zeros. Diagonals are ordered by increasing a then b, and
+ *	the values above the diagonal by increasing (0,1), (0,2), then (1,2). Returns false after the last one.
+ */
+
+inline bool IMatrix3D::nextSublattice(int index, IMatrix3D& matrix)
+{
+	
+	// Move to the next values above the diagonal
+	long a = matrix(0, 0);
+	long b = matrix(1, 1);
+	long c = matrix(2, 2);
+	if (a > 0)
+	{
+		if (++matrix(1, 2) < c)
+			return true;
+		matrix(1, 2) = 0;
+		if (++matrix(0, 2) < c)
+			return true;
+		matrix(0, 2) = 0;
+		if (++matrix(0, 1) < b)
+			return true;
+	}
+	
+	// Move to the next factorization of the index into diagonal values
+	else
+	{
+		a = 1;
+		b = 0;
+	}
+	for (; a <= index; ++a, b = 0)
+	{
+		if (index % a != 0)
+			continue;
+		while (++b <= index / a)
 		{
-			++pivRow;
-			++pivCol;
+			if ((index / a) % b != 0)
+				continue;
+			matrix.set(a, 0, 0, 0, b, 0, 0, 0, index / a / b);
+			return true;
 		}
 	}
 	
-	// Return matrix
-	return res;
+	// Reached the end
+	return false;
 }
 
 
@@ -4001,6 +5257,7 @@ inline void Functor<Tclass>::initialize()
 	_objFunPtrVec = 0; 
 	_funPtrVecArg = 0;
 	_objFunPtrVecArg = 0;
+	_threadSafe = false;
 }
 
 
@@ -4108,6 +5365,7 @@ inline void VectorFunctor<Tclass>::initialize()
 	_objPtr = 0;
 	_funPtr = 0;
 	_objFunPtr = 0;
+	_threadSafe = false;
 }
 
 
@@ -4604,113 +5862,257 @@ inline T Num<T>::volume(const T* vec1, const T* vec2, const T* vec3)
 
 
 
-/* inline T Num<T>::integrate(T (*fun)(T), T min, T max, IntegrationMethod method)
+/* inline T Num<T>::sum(int length, const T* values)
  *
- * Numerical integration
+ * Pairwise sum of values, the tree of additions is fixed by the length so the result does not depend on how the
+ *		values were generated
  */
 
 template <class T>
-template <class Tclass>
-inline T Num<T>::integrate(Functor<Tclass>& fun, T min, T max, IntegrationMethod method)
+inline T Num<T>::sum(int length, const T* values)
 {
 	
-	// Loop until converged
+	// Add short lists directly
+	if (length <= 8)
+	{
+		T res = 0;
+		for (int i = 0; i < length; ++i)
+			res += values[i];
+		return res;
+	}
+	
+	// Add halves separately
+	int half = length / 2;
+	return sum(half, values) + sum(length - half, values + half);
+}
+
+
+
+/* inline T Num<T>::integrate(Tfun& fun, T min, T max, IntegrationMethod method, double tol, T* error)
+ *
+ * Numerical integration of a function that is called once for each point
+ */
+
+template <class T>
+template <class Tfun>
+inline T Num<T>::integrate(Tfun& fun, T min, T max, IntegrationMethod method, double tol, T* error)
+{
+	BatchIntegrand<Tfun> batch(fun);
+	return integrateBatch(batch, min, max, method, tol, error);
+}
+
+
+
+/* inline T Num<T>::integrateBatch(Tfun& fun, T min, T max, IntegrationMethod method, double tol, T* error)
+ *
+ * Numerical integration of a function that is evaluated at all quadrature points in a single call as
+ * fun(num, points, values), tolerance is relative to the value of the integral. If the tolerance is not
+ * reached within the largest number of intervals or rule order, the last result is returned and error is
+ * set to its estimated error, so callers that need a converged result should check it against tol.
+ */
+
+template <class T>
+template <class Tfun>
+inline T Num<T>::integrateBatch(Tfun& fun, T min, T max, IntegrationMethod method, double tol, T* error)
+{
+	
+	// Adaptive Gauss-Kronrod integration
 	int i;
-	T curInt;
-	T prevInt;
-	bool first = true;
-	double tol = 1e-4;
-	Matrix points;
-        int order;
-	for (order = 6; order <= 48; order += 3)
+	T curInt = 0;
+	T curErr = 0;
+	T values[maxRuleOrder];
+	if (method == GAUSSKRONROD)
 	{
 		
-		// Save previous result
-		prevInt = curInt;
-		
-		// Generate points
-		points.size(order, 2);
-		if (method == GAUSSLEGENDRE)
-			GaussLegendrePoints(min, max, points);
+		// Intervals and their contributions
+		int maxIntervals = 500;
+		List<T> lower (1, min);
+		List<T> upper (1, max);
+		List<T> ints  (1);
+		List<T> errs  (1);
+		ints[0] = GaussKronrod(fun, min, max, values, errs[0]);
 		
-		// Evaluate integral
-		curInt = 0;
-		for (i = 0; i < order; ++i)
-			curInt += points(i, 1) * fun(points(i, 0));
-		curInt *= (max - min) / 2;
+		// Loop until converged
+		int worst;
+		T mid;
+		while (true)
+		{
+			
+			// Get current integral and error
+			worst = 0;
+			curInt = curErr = 0;
+			for (i = 0; i < ints.length(); ++i)
+			{
+				curInt += ints[i];
+				curErr += errs[i];
+				if (errs[i] > errs[worst])
+					worst = i;
+			}
+			
+			// Break if converged or out of intervals
+			if ((curErr <= tol * Num<T>::abs(curInt)) || (ints.length() >= maxIntervals))
+				break;
+			
+			// Bisect the interval with the largest error
+			mid = (lower[worst] + upper[worst]) / 2;
+			lower += mid;
+			upper += T(upper[worst]);
+			ints.add();
+			errs.add();
+			ints.last() = GaussKronrod(fun, mid, upper.last(), values, errs.last());
+			upper[worst] = mid;
+			ints[worst] = GaussKronrod(fun, lower[worst], mid, values, errs[worst]);
+		}
+	}
+	
+	// Gauss-Legendre integration of increasing order
+	else
+	{
 		
-		// Break if converged
-		if (first)
-			first = false;
-		else if (Num<T>::abs(curInt - prevInt) / curInt < tol)
-			break;
+		// Loop until converged
+		int order;
+		T prevInt;
+		T args[maxRuleOrder];
+		T halfRange = (max - min) / 2;
+		T center = (max + min) / 2;
+		const double* rule;
+		for (order = 6; order <= 48; order += 3)
+		{
+			
+			// Save previous result
+			prevInt = curInt;
+			
+			// Map cached points onto range and evaluate function at all of them
+			rule = GaussLegendreRule(order);
+			for (i = 0; i < order; ++i)
+				args[i] = rule[i] * halfRange + center;
+			fun(order, args, values);
+			
+			// Evaluate integral
+			curInt = 0;
+			for (i = 0; i < order; ++i)
+				curInt += rule[order + i] * values[i];
+			curInt *= halfRange;
+			
+			// Break if converged
+			if (order > 6)
+			{
+				curErr = Num<T>::abs(curInt - prevInt);
+				if (curErr <= tol * Num<T>::abs(curInt))
+					break;
+			}
+		}
 	}
-        
+	
 	// Return integral
+	if (error)
+		*error = curErr;
 	return curInt;
 }
 
 
 
-/* inline void Num<T>::GaussLegendrePoints(T min, T max, Matrix& points)
+/* inline T Num<T>::GaussKronrod(Tfun& fun, T min, T max, T* values, T& error)
  *
- * Generate points for Gauss-Legendre quadrature integration
+ * 15-point Kronrod integral over range, error is estimated from the embedded 7-point Gauss rule
  */
 
 template <class T>
-inline void Num<T>::GaussLegendrePoints(T min, T max, Matrix& points)
-{
-	
-	// Generate coefficients
-	int i, j;
-	int order = points.numRows();
-	Matrix coeffs(order + 1);
-	coeffs.fill(0);
-	coeffs(0, 0) = 1;
-	coeffs(1, 1) = 1;
-	for (i = 2; i <= order; ++i)
+template <class Tfun>
+inline T Num<T>::GaussKronrod(Tfun& fun, T min, T max, T* values, T& error)
+{
+	
+	// Kronrod points (odd indices are Gauss points) and weights
+	static const double kronrodPoints[8] = {0.991455371120812639206854697526329, 0.949107912342758524526189684047851, \
+		0.864864423359769072789712788640926, 0.741531185599394439863864773280788, \
+		0.586087235467691130294144845693013, 0.405845151377397166906606412076961, \
+		0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+	static const double kronrodWeights[8] = {0.022935322010529224963732008058970, 0.063092092629978553290700663189204, \
+		0.104790010322250183839876322541518, 0.140653259715525918745189590510238, \
+		0.169004726639267902826583426598550, 0.190350578064785409913256402421014, \
+		0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+	static const double gaussWeights[4] = {0.129484966168869693270611432679082, 0.279705391489276667901467771423780, \
+		0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+	
+	// Evaluate function at all points
+	int i;
+	T args[15];
+	T halfRange = (max - min) / 2;
+	T center = (max + min) / 2;
+	for (i = 0; i < 7; ++i)
 	{
-		coeffs(i, 0) = -(i - 1) * coeffs(i-2, 0) / i;
-		for (j = 1; j <= order; ++j)
-			coeffs(i, j) = ((2*i - 1) * coeffs(i-1, j-1) - (i - 1)*coeffs(i-2, j)) / i;
+		args[2*i]     = center - halfRange * kronrodPoints[i];
+		args[2*i + 1] = center + halfRange * kronrodPoints[i];
 	}
+	args[14] = center;
+	fun(15, args, values);
 	
-	// Generate points and weights
-	T x;
-	T x1;
-	for (i = 1; i <= order; ++i)
+	// Evaluate both rules
+	T kronrod = kronrodWeights[7] * values[14];
+	T gauss = gaussWeights[3] * values[14];
+	for (i = 0; i < 7; ++i)
 	{
-		x = cos(Constants::pi * (i - 0.25) / (order + 0.5));
-		do
-		{
-			x1 = x;
-			x -= Legendre(coeffs, order, x) * (x*x - 1) / order /\
-			 	(x * Legendre(coeffs, order, x) - Legendre(coeffs, order - 1, x));
-		} while (abs(x - x1) > 1e-8);
-		points(i-1, 0) = x;
-		x1 = order*(x*Legendre(coeffs, order, x) - Legendre(coeffs, order - 1, x)) / (x*x - 1);
-		points(i-1, 1) = 2 / ((1 - x*x) * x1*x1);
+		kronrod += kronrodWeights[i] * (values[2*i] + values[2*i + 1]);
+		if (i % 2)
+			gauss += gaussWeights[i / 2] * (values[2*i] + values[2*i + 1]);
 	}
 	
-	// Convert points from -1:1 to min:max
-	for (i = 0; i < order; ++i)
-		points(i, 0) = points(i, 0) * (max - min) / 2 + (max + min) / 2;
+	// Return result
+	error = Num<T>::abs((kronrod - gauss) * halfRange);
+	return kronrod * halfRange;
 }
 
 
 
-/* inline T Num<T>::Legendre(const Matrix<T>& coeffs, int order, T point)
+/* inline const double* Num<T>::GaussLegendreRule(int order)
  *
- * Generate value of Legendre polynomial at point
+ * Return Gauss-Legendre points on -1:1 followed by their weights, rules are generated once per order and thread
  */
 
 template <class T>
-inline T Num<T>::Legendre(const Matrix& coeffs, int order, T point)
+inline const double* Num<T>::GaussLegendreRule(int order)
 {
-	T res = coeffs(order, order);
-	for (int i = order; i > 0; --i)
-		res = res * point + coeffs(order, i-1);
-	return res;
+	
+	// Return saved rule if it exists
+	static MINT_THREAD_LOCAL double* rules[maxRuleOrder + 1] = {0};
+	if ((order < 1) || (order > maxRuleOrder))
+		return 0;
+	if (rules[order])
+		return rules[order];
+	
+	// Generate points from roots of Legendre polynomial using recurrence relation
+	int i, j, iter;
+	double x;
+	double dx;
+	double p0, p1, p2;
+	double deriv;
+	double* rule = new double [2*order];
+	for (i = 0; i < order; ++i)
+	{
+		x = cos(Constants::pi * (i + 0.75) / (order + 0.5));
+		for (iter = 0; iter < 100; ++iter)
+		{
+			p0 = 1;
+			p1 = x;
+			for (j = 2; j <= order; ++j)
+			{
+				p2 = ((2*j - 1) * x * p1 - (j - 1) * p0) / j;
+				p0 = p1;
+				p1 = p2;
+			}
+			deriv = order * (x * p1 - p0) / (x*x - 1);
+			dx = p1 / deriv;
+			x -= dx;
+			if (fabs(dx) < 1e-15)
+				break;
+		}
+		rule[i] = x;
+		rule[order + i] = 2 / ((1 - x*x) * deriv*deriv);
+	}
+	
+	// Save and return rule
+	rules[order] = rule;
+	return rule;
 }
 
 
@@ -4719,12 +6121,6 @@ inline T Num<T>::Legendre(const Matrix& coeffs, int order, T point)
 // Solve
 // =====================================================================================================================
 
-// Static member variables
-template <class Tclass>
-Functor<Tclass>* Solve<Tclass>::_functorFun;
-
-
-
 /* inline double Solve<Tclass>::findRoot(Functor<Tclass>& fun, double target, double convergeArg, double convergeRes,
  *		double min, double max, RootMethod method, double& argRes)
  *
@@ -4944,24 +6340,7 @@ template <class Tclass>
 inline double Solve<Tclass>::minimize(Functor<Tclass>& fun, double convergeRes, double initial, double step, \
 	double& argRes)
 {
-	
-	// Vector variables
-	Vector initVec(1);
-	Vector stepVec(1);
-	Vector argResVec(1);
-	initVec[0] = initial;
-	stepVec[0] = step;
-	
-	// Functor with vector
-	_functorFun = &fun;
-	Functor<Solve<Tclass> > funVec(&Solve<Tclass>::NelderHelper);
-	
-	// Evaluate function
-	double res = Solve<Solve<Tclass> >::NelderMead(funVec, convergeRes, initVec, stepVec, argResVec, 1);
-	
-	// Return result
-	argRes = argResVec[0];
-	return res;
+	return NelderMead1D(fun, convergeRes, initial, step, argRes, 1);
 }
 
 
@@ -4983,6 +6362,21 @@ template <class Tclass>
 inline double Solve<Tclass>::maximize(Functor<Tclass>& fun, double convergeRes, double initial, double step, \
 	double& argRes)
 {
+	return NelderMead1D(fun, convergeRes, initial, step, argRes, -1);
+}
+
+
+
+/* inline double Solve<Tclass>::NelderMead1D(Functor<Tclass>& fun, double convergeRes, double initial, double step,
+ *		double& argRes, int mult)
+ *
+ * Nelder-Mead simplex method for a function of one variable
+ */
+
+template <class Tclass>
+inline double Solve<Tclass>::NelderMead1D(Functor<Tclass>& fun, double convergeRes, double initial, double step, \
+	double& argRes, int mult)
+{
 	
 	// Vector variables
 	Vector initVec(1);
@@ -4992,11 +6386,13 @@ inline double Solve<Tclass>::maximize(Functor<Tclass>& fun, double convergeRes,
 	stepVec[0] = step;
 	
 	// Functor with vector
-	_functorFun = &fun;
-	Functor<Solve<Tclass> > funVec(&Solve<Tclass>::NelderHelper);
+	NelderHelp help;
+	help._functor = &fun;
+	Functor<NelderHelp> funVec(&help, &NelderHelp::value);
+	funVec.threadSafe(fun.threadSafe());
 	
 	// Evaluate function
-	double res = Solve<Solve<Tclass> >::NelderMead(funVec, convergeRes, initVec, stepVec, argResVec, -1);
+	double res = Solve<NelderHelp>::NelderMead(funVec, convergeRes, initVec, stepVec, argResVec, mult);
 	
 	// Return result
 	argRes = argResVec[0];
@@ -5079,8 +6475,8 @@ inline double Solve<Tclass>::NelderMead(Functor<Tclass>& fun, double convergeRes
 		vertices[i] = initial;
 		if (i > 0)
 			vertices[i][i-1] += steps[i-1];
-		values[i] = mult * fun(vertices[i]);
 	}
+	evaluateVertices(fun, vertices, values, 0, mult);
 	
 	// Scaling factors
 	double cReflect = 1.0;
@@ -5157,6 +6553,7 @@ inline double Solve<Tclass>::NelderMead(Functor<Tclass>& fun, double convergeRes
 			{
 				values.last() = valueContracted;
 				vertices.last() = vertexContracted;
+				continue;
 			}
 		}
 		
@@ -5170,15 +6567,14 @@ inline double Solve<Tclass>::NelderMead(Functor<Tclass>& fun, double convergeRes
 			{
 				values.last() = valueContracted;
 				vertices.last() = vertexContracted;
+				continue;
 			}
 		}
 		
 		// Reduction
 		for (i = 1; i < vertices.length(); ++i)
-		{
 			vertices[i] = vertices[0] + (vertices[i] - vertices[0]) * cReduce;
-			values[i] = mult * fun(vertices[i]);
-		}
+		evaluateVertices(fun, vertices, values, 1, mult);
 	}
 	
 	// Return result
@@ -5188,6 +6584,25 @@ inline double Solve<Tclass>::NelderMead(Functor<Tclass>& fun, double convergeRes
 
 
 
+/* inline void Solve<Tclass>::evaluateVertices(Functor<Tclass>& fun, const OList<Vector>& vertices,
+ *		List<double>& values, int start, int mult)
+ *
+ * Evaluate function at vertices starting from index, in parallel if the function allows it
+ */
+
+template <class Tclass>
+inline void Solve<Tclass>::evaluateVertices(Functor<Tclass>& fun, const OList<Vector>& vertices, \
+	List<double>& values, int start, int mult)
+{
+	#ifdef MINT_OPENMP
+	#pragma omp parallel for schedule(dynamic) if (fun.threadSafe())
+	#endif
+	for (int i = start; i < vertices.length(); ++i)
+		values[i] = mult * fun(vertices[i]);
+}
+
+
+
 /* inline void Solve<Tclass>::sortVertices(OList<Vector>& vertices, List<double>& values, int left, int right)
  *
  * Sort values during Nelder-Mead method using quicksort
@@ -5294,6 +6709,27 @@ template <class Tclass>
 inline Vector Fit::LM(const OList<List<double> >& data, Functor<Tclass>& fun, VectorFunctor<Tclass>& deriv, \
 	const Vector& initial, double tol)
 {
+	return LMSolve(data, fun, &deriv, initial, tol);
+}
+
+template <class Tclass>
+inline Vector Fit::LM(const OList<List<double> >& data, Functor<Tclass>& fun, const Vector& initial, double tol)
+{
+	return LMSolve(data, fun, (VectorFunctor<Tclass>*)0, initial, tol);
+}
+
+
+
+/* inline Vector Fit::LMSolve(const OList<List<double> >& data, Functor<Tclass>& fun, VectorFunctor<Tclass>* deriv,
+ *		const Vector& initial, double tol)
+ *
+ * Run Levenberg–Marquardt algorithm, derivatives are evaluated by finite differences if deriv is not set
+ */
+
+template <class Tclass>
+inline Vector Fit::LMSolve(const OList<List<double> >& data, Functor<Tclass>& fun, VectorFunctor<Tclass>* deriv, \
+	const Vector& initial, double tol)
+{
 	
 	// Variable to store result
 	Vector params = initial;
@@ -5302,7 +6738,7 @@ inline Vector Fit::LM(const OList<List<double> >& data, Functor<Tclass>& fun, Ve
 	// Storage variables
 	Matrix jacobian(data.length(), params.length());
 	Matrix jacobianTranspose(params.length(), data.length());
-	Matrix matrix(data.length(), data.length());
+	Matrix matrix(params.length(), params.length());
 	
 	// Save initial residual and magnitude
 	Vector residual(data.length());
@@ -5320,7 +6756,10 @@ inline Vector Fit::LM(const OList<List<double> >& data, Functor<Tclass>& fun, Ve
 	{
 		
 		// Get the new parameters
-		LMBuildJacobian(data, deriv, params, jacobian, jacobianTranspose);
+		if (deriv)
+			LMBuildJacobian(data, *deriv, params, jacobian, jacobianTranspose);
+		else
+			LMDiffJacobian(data, fun, params, residual, jacobian, jacobianTranspose);
 		LMSetMatrix(jacobian, jacobianTranspose, damper, matrix);
 		paramsNew = params + matrix.solve(jacobianTranspose*residual);
 		
@@ -5366,18 +6805,46 @@ template <class Tclass>
 inline void Fit::LMBuildJacobian(const OList<List<double> >& data, VectorFunctor<Tclass>& deriv, Vector& params, \
 	Matrix& jacobian, Matrix& jacobianTranspose)
 {
-	int i, j;
-	Vector derivs;
-	for (i = 0; i < data.length(); ++i)
+	#ifdef MINT_OPENMP
+	#pragma omp parallel for if (deriv.threadSafe())
+	#endif
+	for (int i = 0; i < data.length(); ++i)
 	{
-		derivs = deriv(params, data[i][0]);
-		for (j = 0; j < derivs.length(); ++j)
+		Vector derivs = deriv(params, data[i][0]);
+		for (int j = 0; j < derivs.length(); ++j)
 			jacobian(i, j) = jacobianTranspose(j, i) = derivs[j];
 	}
 }
 
 
 
+/* inline void Fit::LMDiffJacobian(const OList<List<double> >& data, Functor<Tclass>& fun, Vector& params,
+ *		const Vector& residuals, Matrix& jacobian, Matrix& jacobianTranspose)
+ *
+ * Build the Jacobian matrix and its transpose from forward differences, residuals are those at params
+ */
+
+template <class Tclass>
+inline void Fit::LMDiffJacobian(const OList<List<double> >& data, Functor<Tclass>& fun, Vector& params, \
+	const Vector& residuals, Matrix& jacobian, Matrix& jacobianTranspose)
+{
+	#ifdef MINT_OPENMP
+	#pragma omp parallel for schedule(dynamic) if (fun.threadSafe())
+	#endif
+	for (int j = 0; j < params.length(); ++j)
+	{
+		Vector shifted = params;
+		double step = 1e-7 * Num<double>::max(Num<double>::abs(params[j]), 1.0);
+		shifted[j] += step;
+		step = shifted[j] - params[j];
+		for (int i = 0; i < data.length(); ++i)
+			jacobian(i, j) = jacobianTranspose(j, i) = \
+				(fun(shifted, data[i][0]) - (data[i][1] - residuals[i])) / step;
+	}
+}
+
+
+
 /* inline void Fit::LMSetMatrix(Matrix& jacobian, Matrix& jacobianTranspose, double damper, Matrix& matrix)
  *
  * Set the matrix values for Levenberg–Marquardt algorithm
@@ -5400,6 +6867,9 @@ inline void Fit::LMSetMatrix(Matrix& jacobian, Matrix& jacobianTranspose, double
 template <class Tclass>
 inline void Fit::LMGetResidual(const OList<List<double> >& data, Functor<Tclass>& fun, Vector& params, Vector& residuals)
 {
+	#ifdef MINT_OPENMP
+	#pragma omp parallel for if (fun.threadSafe())
+	#endif
 	for (int i = 0; i < data.length(); ++i)
 		residuals[i] = data[i][1] - fun(params, data[i][0]);
 }
@@ -5421,10 +6891,13 @@ inline Vector Fit::NM(const OList<List<double> >& data, Functor<Tclass>& fun, co
 	NMHelp<Tclass> help;
 	help._functor = &fun;
 	help._NMData = &data;
-	Functor<NMHelp<Tclass> > functor(&help, &help.NMRSquared);
+	Functor<NMHelp<Tclass> > functor(&help, &NMHelp<Tclass>::NMRSquared);
+	functor.threadSafe(fun.threadSafe());
 	
 	// Return fitting parameters
-	return Solve<Tclass>::minimize(functor, tol, initial, steps);
+	Vector params;
+	Solve<NMHelp<Tclass> >::minimize(functor, tol, initial, steps, params);
+	return params;
 }
 
 
@@ -33,8 +33,15 @@
 
 void PairPotential::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const {
 
-	// Set image iterator
-	_images.setCell(iso.basis(), _cutoff);
+	// Update neighbor list if it is kept between evaluations, otherwise set image iterator
+	bool useList = (_skin > 0);
+	if (useList)
+		_neighbors.update(iso, _cutoff, _skin);
+	else
+		_images.setCell(iso.basis(), _cutoff);
+
+	// Set table if screening
+	updateScreenTable();
 
 	// Set which elements should be updated
 	OList<Element>::D2 elements(1);
@@ -53,10 +60,17 @@ void PairPotential::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D
 		localForces.fill(0.0);
 	}
 
+	// Variables to store energy of each atom and corrections
+	List<double> terms;
+	Accumulator corrections;
+	if (totalEnergy) {
+		terms.length(elements.length() * iso.numAtoms());
+		terms.fill(0);
+	}
+
 	// Loop over element pairs
 	int i, j, k;
 	int count = 0;
-	double localTotal = 0;
 	for (i = 0; i < elements.length(); ++i) {
 
 		// Loop over elements
@@ -67,9 +81,18 @@ void PairPotential::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D
 
 				// Loop over atoms of current element and add energy and get force
 				for (k = 0; k < iso.atoms()[j].length(); ++k) {
-					if ((++count + Multi::rank()) % Multi::worldSize() == 0) {
+					if ((++count + Multi::rank()) % Multi::worldSize() != 0)
+						continue;
+					if (useList) {
 						if (totalEnergy)
-							localTotal += energy(iso, &iso.atoms()[j][k], elements[i][0], elements[i][1], true);
+							terms[count - 1] = listEnergy(_neighbors, &iso.atoms()[j][k], elements[i][0], elements[i][1]);
+						if (totalForces)
+							localForces[iso.atoms()[j][k].atomNumber()] = \
+								listForce(iso, _neighbors, &iso.atoms()[j][k], elements[i][0], elements[i][1]);
+					}
+					else {
+						if (totalEnergy)
+							terms[count - 1] = energy(iso, &iso.atoms()[j][k], elements[i][0], elements[i][1], true);
 						if (totalForces)
 							localForces[iso.atoms()[j][k].atomNumber()] = \
 								force(iso, &iso.atoms()[j][k], elements[i][0], elements[i][1]);
@@ -78,11 +101,11 @@ void PairPotential::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D
 
 				// Add tail if needed
 				if ((_addTail) && (totalEnergy))
-					localTotal += iso.atoms()[j].length() * tail(iso, elements[i][1]) / Multi::worldSize();
+					corrections += iso.atoms()[j].length() * tail(iso, elements[i][1]);
 
 				// Shift energy if needed
 				if ((_shift) && (!_addTail) && (totalEnergy))
-					localTotal -= iso.atoms()[j].length() * pairEnergy(_cutoff) / (2 * Multi::worldSize());
+					corrections -= iso.atoms()[j].length() * pairEnergy(_cutoff) / 2;
 
 				// Finished since element was found
 				break;
@@ -90,15 +113,9 @@ void PairPotential::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D
 		}
 	}
 
-	// Send energy between processors
-	if (totalEnergy) {
-		double temp;
-		for (i = 0; i < Multi::worldSize(); ++i) {
-			temp = localTotal;
-			Multi::broadcast(temp, i);
-			*totalEnergy += temp;
-		}
-	}
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms) + corrections.value();
 
 	// Send forces between processors
 	if (totalForces) {
@@ -131,6 +148,9 @@ void PairPotential::evaluate(const ISO& iso, const Symmetry& symmetry, double* t
 	// Set image iterator
 	_images.setCell(iso.basis(), _cutoff);
 
+	// Set table if screening
+	updateScreenTable();
+
 	// Set which elements should be updated
 	OList<Element>::D2 elements(1);
 	elements[0] += _element1;
@@ -148,10 +168,17 @@ void PairPotential::evaluate(const ISO& iso, const Symmetry& symmetry, double* t
 		localForces.fill(0.0);
 	}
 
+	// Variables to store energy of each unique atom and corrections
+	List<double> terms;
+	Accumulator corrections;
+	if (totalEnergy) {
+		terms.length(elements.length() * symmetry.orbits().length());
+		terms.fill(0);
+	}
+
 	// Loop over unique atoms
 	int i, j;
 	int count = 0;
-	double localTotal = 0;
 	for (i = 0; i < elements.length(); ++i) {
 		for (j = 0; j < symmetry.orbits().length(); ++j) {
 
@@ -159,23 +186,23 @@ void PairPotential::evaluate(const ISO& iso, const Symmetry& symmetry, double* t
 			if (symmetry.orbits()[j].atoms()[0]->element() != elements[i][0])
 				continue;
 
+			// Add tail if needed
+			if ((_addTail) && (totalEnergy))
+				corrections += symmetry.orbits()[j].atoms().length() * tail(iso, elements[i][1]);
+
+			// Shift energy if needed
+			if ((_shift) && (!_addTail) && (totalEnergy))
+				corrections -= symmetry.orbits()[j].atoms().length() * pairEnergy(_cutoff) / 2;
+
 			// Check if adding on current processor
 			if ((++count + Multi::rank()) % Multi::worldSize() != 0)
 				continue;
 
 			// Add energy
 			if (totalEnergy)
-				localTotal += symmetry.orbits()[j].atoms().length() * \
+				terms[count - 1] = symmetry.orbits()[j].atoms().length() * \
 					energy(iso, symmetry.orbits()[j].atoms()[0], elements[i][0], elements[i][1], false) / 2;
 
-			// Add tail if needed
-			if ((_addTail) && (totalEnergy))
-				localTotal += symmetry.orbits()[j].atoms().length() * tail(iso, elements[i][1]);
-
-			// Shift energy if needed
-			if ((_shift) && (!_addTail) && (totalEnergy))
-				localTotal -= symmetry.orbits()[j].atoms().length() * pairEnergy(_cutoff) / 2;
-
 			// Get force
 			if (totalForces)
 				localForces[symmetry.orbits()[j].atoms()[0]->atomNumber()] = \
@@ -184,15 +211,9 @@ void PairPotential::evaluate(const ISO& iso, const Symmetry& symmetry, double* t
 		}
 	}
 
-	// Send energy between processors
-	if (totalEnergy) {
-		double temp;
-		for (i = 0; i < Multi::worldSize(); ++i) {
-			temp = localTotal;
-			Multi::broadcast(temp, i);
-			*totalEnergy += temp;
-		}
-	}
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms) + corrections.value();
 
 	// Send forces between processors
 	if (totalForces) {
@@ -217,6 +238,49 @@ void PairPotential::evaluate(const ISO& iso, const Symmetry& symmetry, double* t
 	}
 }
 
+/**
+ * Compute the change in energy from a local move using the reference state saved by commit
+ * 
+ * Only interactions that involve the changed atoms are evaluated. If the move changes the
+ *  composition and the tail correction is used, the full energy is evaluated instead.
+ * @param iso [in] Reference structure
+ * @param move [in] Changes to apply to the structure
+ * @return Energy after the move minus energy before the move
+ */
+double PairPotential::deltaEnergy(const ISO& iso, const LocalMove& move) const {
+
+	// Tail depends on the density of every element
+	if ((_addTail) && (move.changesComposition()))
+		return SingleLocalPotential::deltaEnergy(iso, move);
+
+	// Save reference if it has not been set or the structure has changed
+	if (!committed(iso))
+		commit(iso);
+
+	// Set table if screening
+	updateScreenTable();
+
+	// Get change in pair energy
+	double res = localPairEnergy(iso, _reference, move, true) - localPairEnergy(iso, _reference, move, false);
+
+	// Change in the shift, which depends on the number of atoms of each element
+	if ((_shift) && (!_addTail)) {
+		int change = 0;
+		for (int i = 0; i < move.length(); ++i) {
+			for (int after = 0; after < 2; ++after) {
+				if (!move.present(i, after))
+					continue;
+				if ((move.element(i, after) == _element1) || (move.element(i, after) == _element2))
+					change += (after) ? 1 : -1;
+			}
+		}
+		res -= change * pairEnergy(_cutoff) / 2;
+	}
+
+	// Return energy change
+	return res;
+}
+
 /* double PairPotential::energy(const ISO& iso, Atom* atom, const Element& elem1, const Element& elem2, 
  *		bool skipLowerAtoms) const
  *
@@ -232,7 +296,7 @@ double PairPotential::energy(const ISO& iso, Atom* atom, const Element& elem1, c
 
 	// Loop over elements in the structure
 	int i, j;
-	double res = 0;
+	Accumulator res;
 	for (i = 0; i < iso.atoms().length(); ++i) {
 
 		// Found second element
@@ -254,14 +318,14 @@ double PairPotential::energy(const ISO& iso, Atom* atom, const Element& elem1, c
 				if ((atom->atomNumber() == iso.atoms()[i][j].atomNumber()) && (skipLowerAtoms)) {
 					while (!_images.finished()) {
 						if (++_images > 1e-8)
-							res += pairEnergy(_images.distance()) / 2;
+							res += termEnergy(_images.distance()) / 2;
 					}
 				}
 					// Getting energy of different atoms or using symmetry
 				else {
 					while (!_images.finished()) {
 						if (++_images > 1e-8)
-							res += pairEnergy(_images.distance());
+							res += termEnergy(_images.distance());
 					}
 				}
 			}
@@ -272,7 +336,7 @@ double PairPotential::energy(const ISO& iso, Atom* atom, const Element& elem1, c
 	}
 
 	// Return energy
-	return res;
+	return res.value();
 }
 
 /* Vector3D PairPotential::force(const ISO& iso, Atom* atom, const Element& elem1, const Element& elem2) const
@@ -306,7 +370,7 @@ Vector3D PairPotential::force(const ISO& iso, Atom* atom, const Element& elem1,
 					if (++_images > 1e-8) {
 						temp = _images.cartVector();
 						temp /= _images.distance();
-						temp *= pairForce(_images.distance());
+						temp *= termForce(_images.distance());
 						iso.basis().toFractional(temp);
 						res -= temp;
 					}
@@ -322,6 +386,127 @@ Vector3D PairPotential::force(const ISO& iso, Atom* atom, const Element& elem1,
 	return res;
 }
 
+/* double PairPotential::listEnergy(const NeighborList& neighbors, Atom* atom, const Element& elem1,
+ *		const Element& elem2) const
+ *
+ * Return half of the energy of an atom with its neighbors of the second element (neighbor list must be current)
+ */
+
+double PairPotential::listEnergy(const NeighborList& neighbors, Atom* atom, const Element& elem1, \
+	const Element& elem2) const {
+
+	// Return if atom is not of correct type
+	if (atom->element() != elem1)
+		return 0;
+
+	// Loop over neighbors
+	int i;
+	int atomNumber = atom->atomNumber();
+	Accumulator res;
+	for (i = 0; i < neighbors.numNeighbors(atomNumber); ++i) {
+		if ((neighbors.neighbor(atomNumber, i)->element() == elem2) && (neighbors.distance(atomNumber, i) > 1e-8))
+			res += termEnergy(neighbors.distance(atomNumber, i)) / 2;
+	}
+
+	// Return energy
+	return res.value();
+}
+
+/* Vector3D PairPotential::listForce(const ISO& iso, const NeighborList& neighbors, Atom* atom, const Element& elem1,
+ *		const Element& elem2) const
+ *
+ * Return the force on an atom from its neighbors of the second element (neighbor list must be current)
+ */
+
+Vector3D PairPotential::listForce(const ISO& iso, const NeighborList& neighbors, Atom* atom, const Element& elem1, \
+	const Element& elem2) const {
+
+	// Return if atom is not of correct type
+	if (atom->element() != elem1)
+		return Vector3D(0.0);
+
+	// Loop over neighbors
+	int i;
+	int atomNumber = atom->atomNumber();
+	double distance;
+	Vector3D res(0.0);
+	for (i = 0; i < neighbors.numNeighbors(atomNumber); ++i) {
+		distance = neighbors.distance(atomNumber, i);
+		if ((neighbors.neighbor(atomNumber, i)->element() == elem2) && (distance > 1e-8))
+			res -= neighbors.cartVector(atomNumber, i) * (termForce(distance) / distance);
+	}
+
+	// Return force in fractional units
+	iso.basis().toFractional(res);
+	return res;
+}
+
+/**
+ * Build the single precision table of the energy used in screening evaluations
+ * 
+ * The energy between a quarter of the cutoff and the cutoff is stored as a cubic Hermite polynomial on
+ *  each interval, so that energies and forces from the table are consistent. Distances below the start
+ *  of the table are evaluated exactly. The error estimate is the largest difference in energy between the
+ *  table and the exact function at points inside each interval.
+ */
+void PairPotential::setScreenTable() const {
+
+	// Set range
+	int numIntervals = 4096;
+	_screenStart = _cutoff / 4;
+	double step = (_cutoff - _screenStart) / numIntervals;
+	_screenScale = 1 / step;
+	_screenTable.length(4 * numIntervals);
+
+	// Set coefficients of each interval
+	int i;
+	double r0, r1;
+	double e0, e1, d0, d1;
+	for (i = 0; i < numIntervals; ++i) {
+		r0 = _screenStart + i * step;
+		r1 = r0 + step;
+		e0 = pairEnergy(r0);
+		e1 = pairEnergy(r1);
+		d0 = -pairForce(r0) * step;
+		d1 = -pairForce(r1) * step;
+		_screenTable[4*i] = e0;
+		_screenTable[4*i + 1] = d0;
+		_screenTable[4*i + 2] = 3 * (e1 - e0) - 2 * d0 - d1;
+		_screenTable[4*i + 3] = 2 * (e0 - e1) + d0 + d1;
+	}
+	_screenSet = true;
+
+	// Save settings the table was built for
+	_screenParams.length(numParameters() + 1);
+	_screenParams[0] = _cutoff;
+	for (i = 0; i < numParameters(); ++i)
+		_screenParams[i + 1] = parameter(i);
+
+	// Get error estimate
+	int j;
+	double distance;
+	_screenError = 0;
+	for (i = 0; i < numIntervals; ++i) {
+		for (j = 0; j <= 4; ++j) {
+			distance = _screenStart + (i + j / 4.0) * step;
+			_screenError = Num<double>::max(_screenError, fabs(termEnergy(distance) - pairEnergy(distance)));
+		}
+	}
+}
+
+/**
+ * Return an estimate of the error in each pair energy at the current precision
+ * 
+ * The error of the table is sampled at five points in each interval, so it is not a strict bound.
+ * @return Largest sampled difference between the screening table and the exact energy (zero at full precision)
+ */
+double PairPotential::errorEstimate() const {
+	if (_precision != LP_SCREENING)
+		return 0;
+	updateScreenTable();
+	return _screenError;
+}
+
 /**
  * Define pair potential settings from text.
  * @param input [in] Text containing 
@@ -740,3 +925,79 @@ void PairPotential::print() {
 	else
 		Output::print("False");
 }
+
+/**
+ * Write potential in the format of an input file
+ */
+void PairPotential::write() const {
+	Output::newline();
+	Output::print(keyword());
+	Output::print(" ");
+	Output::print(_element1.symbol());
+	Output::print(" ");
+	Output::print(_element2.symbol());
+	writeParameters();
+	Output::newline();
+	Output::print("    cutoff ");
+	Output::print(_cutoff, 8);
+	Output::newline();
+	Output::print("    tail ");
+	Output::print(_addTail ? "true" : "false");
+	Output::newline();
+	Output::print("    shift ");
+	Output::print(_shift ? "true" : "false");
+}
+
+/**
+ * Write Lennard-Jones parameters (epsilon sigma)
+ */
+void LennardJones::writeParameters() const {
+	Output::print(" ");
+	Output::print(_eps, 12);
+	Output::print(" ");
+	Output::print(_sig, 12);
+}
+
+/**
+ * Write Buckingham parameters (A rho C)
+ */
+void Buckingham::writeParameters() const {
+	Output::print(" ");
+	Output::print(_A, 12);
+	Output::print(" ");
+	Output::print(_rho, 12);
+	Output::print(" ");
+	Output::print(_C, 12);
+}
+
+/**
+ * Write power parameters (power epsilon sigma)
+ */
+void Power::writeParameters() const {
+	Output::print(" ");
+	Output::print((int) _power);
+	Output::print(" ");
+	Output::print(_eps, 12);
+	Output::print(" ");
+	Output::print(_sig, 12);
+}
+
+/**
+ * Write exponential parameters (epsilon rho)
+ */
+void Exponential::writeParameters() const {
+	Output::print(" ");
+	Output::print(_eps, 12);
+	Output::print(" ");
+	Output::print(_rho, 12);
+}
+
+/**
+ * Write covalent parameters (epsilon sigma)
+ */
+void Covalent::writeParameters() const {
+	Output::print(" ");
+	Output::print(_eps, 12);
+	Output::print(" ");
+	Output::print(_sig, 12);
+}
@@ -49,12 +49,30 @@ protected:
 	Element _element1;
 	Element _element2;
 	mutable ImageIterator _images;
+	mutable NeighborList _neighbors;
+	mutable NeighborList _reference;
+	
+	// Single precision cubic table of the energy used in screening evaluations
+	mutable bool _screenSet;
+	mutable double _screenStart;
+	mutable double _screenScale;
+	mutable double _screenError;
+	mutable List<float> _screenTable;
+	mutable List<double> _screenParams;
 	
 	// Functions
 	double energy(const ISO& iso, Atom* atom, const Element& elem1, const Element& elem2, bool skipLowerAtoms) const;
 	Vector3D force(const ISO& iso, Atom* atom, const Element& elem1, const Element& elem2) const;
+	double listEnergy(const NeighborList& neighbors, Atom* atom, const Element& elem1, const Element& elem2) const;
+	Vector3D listForce(const ISO& iso, const NeighborList& neighbors, Atom* atom, const Element& elem1, \
+		const Element& elem2) const;
 	double density(const ISO& iso, const Element& elem2) const;
+	double interaction(const Element& elem1, const Element& elem2, double distance) const;
 	void print();
+	void setScreenTable() const;
+	void updateScreenTable() const;
+	double termEnergy(double distance) const;
+	double termForce(double distance) const;
 	
 	// Virtual functions
 	/** Compute energy as a function of distance */
@@ -63,11 +81,15 @@ protected:
 	virtual double pairForce(double distance) const = 0;
 	/** Compute "tail" energy based on density of element within a solid */
 	virtual double tail(const ISO& iso, const Element& elem2) const = 0;
+	/** Keyword of the potential in input files */
+	virtual const char* keyword() const	{ return ""; }
+	/** Write parameters after the elements on the first line of the input */
+	virtual void writeParameters() const	{}
 	
 public:
 	
 	// Constructor
-	PairPotential()	{ _addTail = false; _shift = true; _cutoff = -1; }
+	PairPotential()	{ _addTail = false; _shift = true; _cutoff = -1; _screenSet = false; _screenError = 0; }
 	
 	// Setup by file input
 	virtual void set(const Text& input);
@@ -78,6 +100,38 @@ public:
 	// Evaluation functions
 	void evaluate(const ISO& iso, double* totalEnergy = 0, OList<Vector3D >* totalForces = 0) const;
 	void evaluate(const ISO& iso, const Symmetry& symmetry, double* energy = 0, OList<Vector3D>* forces = 0) const;
+	
+	// Energy changes for local moves
+	void commit(const ISO& iso) const	{ _reference.set(iso, _cutoff, false); markCommitted(iso); }
+	double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+	
+	// Precision (table is kept between changes and rebuilt when the parameters or cutoff change)
+	double errorEstimate() const;
+	
+	// Parameters that can be fit
+	/** Number of parameters that can be fit */
+	virtual int numParameters() const									{ return 0; }
+	/** Get the value of a parameter */
+	virtual double parameter(int index) const							{ return 0; }
+	/** Set the value of a parameter */
+	virtual void parameter(int index, double value)						{}
+	/** Derivatives of pairEnergy and pairForce with respect to each parameter at a distance */
+	virtual void parameterDerivatives(double distance, double* energy, double* force) const	{}
+	
+	// Access functions used when fitting parameters
+	double cutoff() const					{ return _cutoff; }
+	bool addTail() const					{ return _addTail; }
+	bool shift() const						{ return _shift; }
+	const Element& elementOne() const		{ return _element1; }
+	const Element& elementTwo() const		{ return _element2; }
+	double energyAt(double distance) const	{ return pairEnergy(distance); }
+	double forceAt(double distance) const	{ return pairForce(distance); }
+	double tailEnergy(const ISO& iso, const Element& elem2) const	{ return tail(iso, elem2); }
+	bool interacts(const Element& elem1, const Element& elem2) const
+		{ return ((elem1 == _element1) && (elem2 == _element2)) || ((elem1 == _element2) && (elem2 == _element1)); }
+	
+	// Write potential in input format
+	void write() const;
 };
 
 
@@ -114,6 +168,26 @@ public:
 			return 8 * Constants::pi * _eps * density(iso, elem2) * \
 				(pow(_sig, 12) - 3 * pow(_sig * _cutoff, 6)) / (9 * pow(_cutoff, 9));
 		}
+	
+	// Fitting functions (epsilon, sigma)
+	int numParameters() const						{ return 2; }
+	double parameter(int index) const				{ return (index == 0) ? _eps : _sig; }
+	void parameter(int index, double value)			{ if (index == 0) _eps = value; else _sig = value; }
+	void parameterDerivatives(double distance, double* energy, double* force) const
+		{
+			double s6 = pow(_sig / distance, 6);
+			double s12 = s6 * s6;
+			energy[0] = 4 * (s12 - s6);
+			energy[1] = 4 * _eps * (12 * s12 - 6 * s6) / _sig;
+			force[0] = 24 * (2 * s12 - s6) / distance;
+			force[1] = 24 * _eps * (24 * s12 - 6 * s6) / (_sig * distance);
+		}
+	
+protected:
+	
+	// Input functions
+	const char* keyword() const		{ return "lennard"; }
+	void writeParameters() const;
 };
 
 
@@ -151,7 +225,29 @@ public:
 			return -2 * _C * Constants::pi * density(iso, elem2) / (3 * pow(_cutoff, 3)) + 2 * _A * \
 				exp(-_cutoff / _rho) * Constants::pi * density(iso, elem2) * (2 + _cutoff * pow(_rho, 3) * \
 				(2 + _cutoff / _rho) / _rho);
-		}		
+		}
+	
+	// Fitting functions (A, rho, C)
+	int numParameters() const						{ return 3; }
+	double parameter(int index) const				{ return (index == 0) ? _A : ((index == 1) ? _rho : _C); }
+	void parameter(int index, double value)
+		{ if (index == 0) _A = value; else if (index == 1) _rho = value; else _C = value; }
+	void parameterDerivatives(double distance, double* energy, double* force) const
+		{
+			double decay = exp(-distance / _rho);
+			energy[0] = decay;
+			energy[1] = _A * decay * distance / (_rho * _rho);
+			energy[2] = -1 / pow(distance, 6);
+			force[0] = decay / _rho;
+			force[1] = _A * decay * (distance / _rho - 1) / (_rho * _rho);
+			force[2] = -6 / pow(distance, 7);
+		}
+	
+protected:
+	
+	// Input functions
+	const char* keyword() const		{ return "buckingham"; }
+	void writeParameters() const;
 };
 
 
@@ -184,12 +280,31 @@ public:
 	double pairEnergy(double distance) const
 		{ return _eps * pow(_sig / distance, _power); }
 	double pairForce(double distance) const
-		{ return _eps * pow(_sig / distance, _power) / distance; }
+		{ return _power * _eps * pow(_sig / distance, _power) / distance; }
 	double tail(const ISO& iso, const Element& elem2) const
 		{
 			return 2 * Constants::pi * pow(_cutoff, 3 - _power) * _eps * density(iso, elem2) * \
 				pow(_sig, _power) / (_power - 3);
 		}
+	
+	// Fitting functions (epsilon, sigma; the power is fixed)
+	int numParameters() const						{ return 2; }
+	double parameter(int index) const				{ return (index == 0) ? _eps : _sig; }
+	void parameter(int index, double value)			{ if (index == 0) _eps = value; else _sig = value; }
+	void parameterDerivatives(double distance, double* energy, double* force) const
+		{
+			double value = pow(_sig / distance, _power);
+			energy[0] = value;
+			energy[1] = _eps * _power * value / _sig;
+			force[0] = _power * value / distance;
+			force[1] = _eps * _power * _power * value / (_sig * distance);
+		}
+	
+protected:
+	
+	// Input functions
+	const char* keyword() const		{ return "power"; }
+	void writeParameters() const;
 };
 
 
@@ -226,6 +341,25 @@ public:
 			return 2 * Constants::pi * _eps * density(iso, elem2) * _rho * exp(-_cutoff / _rho) * \
 				(_cutoff * _cutoff + 2 * _cutoff * _rho + 2 * _rho * _rho);
 		}
+	
+	// Fitting functions (epsilon, rho)
+	int numParameters() const						{ return 2; }
+	double parameter(int index) const				{ return (index == 0) ? _eps : _rho; }
+	void parameter(int index, double value)			{ if (index == 0) _eps = value; else _rho = value; }
+	void parameterDerivatives(double distance, double* energy, double* force) const
+		{
+			double decay = exp(-distance / _rho);
+			energy[0] = decay;
+			energy[1] = _eps * decay * distance / (_rho * _rho);
+			force[0] = decay / _rho;
+			force[1] = _eps * decay * (distance / _rho - 1) / (_rho * _rho);
+		}
+	
+protected:
+	
+	// Input functions
+	const char* keyword() const		{ return "exponential"; }
+	void writeParameters() const;
 };
 
 
@@ -264,6 +398,27 @@ public:
 		}
 	double tail(const ISO& iso, const Element& elem2) const
 		{ return 0; }
+	
+	// Fitting functions (epsilon, sigma)
+	int numParameters() const						{ return 2; }
+	double parameter(int index) const				{ return (index == 0) ? _eps : _sig; }
+	void parameter(int index, double value)			{ if (index == 0) _eps = value; else _sig = value; }
+	void parameterDerivatives(double distance, double* energy, double* force) const
+		{
+			double square = (distance - _idealDistance) * (distance - _idealDistance) / (2 * distance);
+			double decay = exp(-_sig * square);
+			double product = (distance + _idealDistance) * (distance - _idealDistance) / (2 * distance * distance);
+			energy[0] = -decay;
+			energy[1] = _eps * square * decay;
+			force[0] = -_sig * product * decay;
+			force[1] = -_eps * product * decay * (1 - _sig * square);
+		}
+	
+protected:
+	
+	// Input functions
+	const char* keyword() const		{ return "covalent"; }
+	void writeParameters() const;
 };
 
 
@@ -331,4 +486,80 @@ inline double PairPotential::density(const ISO& iso, const Element& elem2) const
 
 
 
+/**
+ * inline void PairPotential::updateScreenTable() const
+ *
+ * Build the screening table if screening and the table is not set or was built for other parameters
+ */
+inline void PairPotential::updateScreenTable() const
+{
+	if (_precision != LP_SCREENING)
+		return;
+	if (_screenSet)
+	{
+		bool current = (_screenParams.length() == numParameters() + 1) && (_screenParams[0] == _cutoff);
+		for (int i = 0; (current) && (i < numParameters()); ++i)
+			current = (_screenParams[i + 1] == parameter(i));
+		if (current)
+			return;
+	}
+	setScreenTable();
+}
+
+
+
+/**
+ * inline double PairPotential::termEnergy(double distance) const
+ *
+ * Return the pair energy at a distance, from the single precision table when screening
+ */
+inline double PairPotential::termEnergy(double distance) const
+{
+	if ((_precision != LP_SCREENING) || (distance < _screenStart))
+		return pairEnergy(distance);
+	double x = (distance - _screenStart) * _screenScale;
+	int index = (int)x;
+	if (index >= _screenTable.length() / 4)
+		index = _screenTable.length() / 4 - 1;
+	const float* c = &_screenTable[4*index];
+	float t = (float)(x - index);
+	return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+}
+
+
+
+/**
+ * inline double PairPotential::termForce(double distance) const
+ *
+ * Return the pair force at a distance, from the single precision table when screening
+ */
+inline double PairPotential::termForce(double distance) const
+{
+	if ((_precision != LP_SCREENING) || (distance < _screenStart))
+		return pairForce(distance);
+	double x = (distance - _screenStart) * _screenScale;
+	int index = (int)x;
+	if (index >= _screenTable.length() / 4)
+		index = _screenTable.length() / 4 - 1;
+	const float* c = &_screenTable[4*index];
+	float t = (float)(x - index);
+	return -(c[1] + t*(2*c[2] + t*3*c[3])) * (float)_screenScale;
+}
+
+
+
+/**
+ * inline double PairPotential::interaction(const Element& elem1, const Element& elem2, double distance) const
+ *
+ * Return the pair energy if the elements match those of the potential
+ */
+inline double PairPotential::interaction(const Element& elem1, const Element& elem2, double distance) const
+{
+	if (((elem1 == _element1) && (elem2 == _element2)) || ((elem1 == _element2) && (elem2 == _element1)))
+		return termEnergy(distance);
+	return 0;
+}
+
+
+
 #endif
@@ -29,6 +29,11 @@
 
 
 
+// Force constants with no element larger than this are not stored
+const double Phonons::_zeroTolerance = 1e-8;
+
+
+
 /* Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, const Potential& potential, 
  *		const Word& fileAppend)
  *
@@ -51,17 +56,23 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 	// Make space
 	int i;
 	clear();
-	_forceConstants.size(3 * iso.numAtoms());
-	_massFactors.size(iso.numAtoms());
-	_vectors.length(iso.numAtoms());
-	for (i = 0; i < _vectors.length(); ++i)
-		_vectors[i].length(iso.numAtoms());
-	
-	// Variable to store pairs of atom types
-	List<int>::D3 types;
-	types.length(iso.numAtoms());
-	for (i = 0; i < types.length(); ++i)
-		types[i].length(iso.numAtoms());
+	_masses.length(iso.numAtoms());
+	_pairAtoms.length(iso.numAtoms());
+	_pairConstants.length(iso.numAtoms());
+	_pairVectors.length(iso.numAtoms());
+	
+	// Variables to store atoms by number and their types
+	int j;
+	List<int> types(iso.numAtoms());
+	List<Atom*> atoms(iso.numAtoms());
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+		{
+			types[iso.atoms()[i][j].atomNumber()] = i;
+			atoms[iso.atoms()[i][j].atomNumber()] = &iso.atoms()[i][j];
+		}
+	}
 	
 	// Variable to store atom maps for each symmetry operation
 	OList<List<Atom*> >::D2 atomMap;
@@ -69,13 +80,13 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 	for (i = 0; i < symmetry.operations().length(); ++i)
 		atomMap[i].length(symmetry.operations()[i].translations().length());
 	
-	// Loop over unique atoms in the structure and build up force constant matrix
-	int j, k, m, n;
+	// Loop over unique atoms in the structure and build up force constants
+	int k, m, n;
 	int atom1;
 	int atom2;
 	Atom* atom;
 	List<Atom*>* curAtomMap;
-	Vector curForceConstants;
+	OList<Vector> curForceConstants(3);
 	Matrix3D curMat;
 	Matrix3D cartRot;
 	Matrix3D cartRotTrans;
@@ -109,14 +120,24 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 			Output::increase();
 			
 			// Get force constant
-			getForceConstants(curForceConstants, iso, symmetry, potential, atom, j);
-			for (k = 0; k < curForceConstants.length(); ++k)
-				_forceConstants(3*atom->atomNumber()+j, k) = curForceConstants[k];
+			getForceConstants(curForceConstants[j], iso, symmetry, potential, atom, j);
 			
 			// Output
 			Output::decrease();
 		}
 		
+		// Save blocks for pairs that interact
+		for (k = 0; k < iso.numAtoms(); ++k)
+		{
+			for (m = 0; m < 3; ++m)
+			{
+				for (n = 0; n < 3; ++n)
+					curMat(m, n) = curForceConstants[m][3*k+n];
+			}
+			if (!isZero(curMat))
+				addPair(atom->atomNumber(), k, curMat);
+		}
+		
 		// Output
 		Output::newline();
 		Output::print("Generating equivalent components of force constant matrix");
@@ -164,29 +185,18 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 				symmetry.getFullMap(*curAtomMap, iso, symmetry.orbits()[i].generators()[j].rotation(), \
 					symmetry.orbits()[i].generators()[j].translations()[0]);
 			
-			// Loop over atoms
+			// Loop over pairs of the displaced atom
 			atom1 = symmetry.orbits()[i].atoms()[j]->atomNumber();
-			for (k = 0; k < curAtomMap->length(); ++k)
+			for (k = 0; k < _pairAtoms[atom->atomNumber()].length(); ++k)
 			{
 				
-				// Get current 3x3 for pair of atoms
-				atom2 = (*curAtomMap)[k]->atomNumber();
-				for (m = 0; m < 3; ++m)
-				{
-					for (n = 0; n < 3; ++n)
-						curMat(m, n) = _forceConstants(3*atom->atomNumber()+m, 3*k+n);
-				}
-				
-				// Convert under symmetry operation
-				curMat  = curMat * cartRot;
+				// Convert 3x3 for pair of atoms under symmetry operation
+				atom2 = (*curAtomMap)[_pairAtoms[atom->atomNumber()][k]]->atomNumber();
+				curMat  = _pairConstants[atom->atomNumber()][k] * cartRot;
 				curMat *= cartRotTrans;
 				
 				// Save new 3x3 for equivalent pair
-				for (m = 0; m < 3; ++m)
-				{
-					for (n = 0; n < 3; ++n)
-						_forceConstants(3*atom1+m, 3*atom2+n) = curMat(m, n);
-				}
+				addPair(atom1, atom2, curMat);
 			}
 		}
 		
@@ -197,59 +207,109 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 		Output::decrease();
 	}
 	
-	// Make sure that force constant matrix is symmetric
-	for (i = 0; i < _forceConstants.numRows(); ++i)
+	// Find missing self terms and missing orientations of stored pairs (a pair is kept if either orientation
+	// was kept, and the missing orientation starts as the transpose of the stored one)
+	int index;
+	List<int> missingRows;
+	List<int> missingCols;
+	OList<Matrix3D> missingConstants;
+	for (i = 0; i < _pairAtoms.length(); ++i)
+		sortPairs(_pairAtoms[i], _pairConstants[i], 0, _pairAtoms[i].length() - 1);
+	for (i = 0; i < _pairAtoms.length(); ++i)
 	{
-		for (j = 0; j < i; ++j)
-			_forceConstants(i, j) = _forceConstants(j, i) = (_forceConstants(i, j) + _forceConstants(j, i))/2;
+		if (pairIndex(i, i) < 0)
+		{
+			missingRows += i;
+			missingCols += i;
+			missingConstants += Matrix3D(0.0);
+		}
+		for (j = 0; j < _pairAtoms[i].length(); ++j)
+		{
+			atom2 = _pairAtoms[i][j];
+			if ((atom2 != i) && (pairIndex(atom2, i) < 0))
+			{
+				missingRows += atom2;
+				missingCols += i;
+				missingConstants += _pairConstants[i][j].transpose();
+			}
+		}
 	}
 	
-	for (i = 0; i < _forceConstants.numRows(); ++i)
-		_forceConstants(i, i) += 1;
+	// Add missing blocks once all have been found and sort again
+	for (i = 0; i < missingRows.length(); ++i)
+		addPair(missingRows[i], missingCols[i], missingConstants[i]);
+	for (i = 0; i < _pairAtoms.length(); ++i)
+		sortPairs(_pairAtoms[i], _pairConstants[i], 0, _pairAtoms[i].length() - 1);
 	
-	// Set translation constraint
-	double total;
-	double absTotal;
-	for (i = 0; i < _forceConstants.numRows(); ++i)
+	// Make sure that force constants are symmetric (both orientations of every pair are now stored)
+	for (i = 0; i < _pairAtoms.length(); ++i)
 	{
-		total = 0;
-		absTotal = 0;
-		for (j = 0; j < _forceConstants.numCols(); ++j)
+		for (j = 0; j < _pairAtoms[i].length(); ++j)
 		{
-			total += _forceConstants(i, j);
-			absTotal += Num<double>::abs(_forceConstants(i, j));
+			atom2 = _pairAtoms[i][j];
+			if (atom2 < i)
+				continue;
+			index = pairIndex(atom2, i);
+			curMat  = _pairConstants[i][j];
+			curMat += _pairConstants[atom2][index].transpose();
+			curMat *= 0.5;
+			_pairConstants[i][j] = curMat;
+			_pairConstants[atom2][index] = curMat.transpose();
 		}
-		for (j = 0; j < _forceConstants.numCols(); ++j)
-			_forceConstants(i, j) -= total * Num<double>::abs(_forceConstants(i, j)) / absTotal;
 	}
 	
-	// Build up mass factor, vector, and type variables
-	for (i = 0; i < iso.atoms().length(); ++i)
+	for (i = 0; i < _pairAtoms.length(); ++i)
 	{
-		for (j = 0; j < iso.atoms()[i].length(); ++j)
+		index = pairIndex(i, i);
+		for (j = 0; j < 3; ++j)
+			_pairConstants[i][index](j, j) += 1;
+	}
+	
+	// Set translation constraint
+	double total;
+	double absTotal;
+	for (i = 0; i < _pairAtoms.length(); ++i)
+	{
+		for (m = 0; m < 3; ++m)
 		{
-			
-			// Loop over pairs of atoms and save values
-			atom1 = iso.atoms()[i][j].atomNumber();
-			for (k = 0; k < iso.atoms().length(); ++k)
+			total = 0;
+			absTotal = 0;
+			for (j = 0; j < _pairAtoms[i].length(); ++j)
 			{
-				for (m = 0; m < iso.atoms()[k].length(); ++m)
+				for (n = 0; n < 3; ++n)
 				{
-					atom2 = iso.atoms()[k][m].atomNumber();
-					types[atom1][atom2].length(2);
-					types[atom1][atom2][0] = i;
-					types[atom1][atom2][1] = k;
-					_massFactors(atom1, atom2) = sqrt(iso.atoms()[i][j].element().mass() * \
-						iso.atoms()[k][m].element().mass());
-					iso.basis().distance(iso.atoms()[i][j].fractional(), FRACTIONAL, iso.atoms()[k][m].fractional(), \
-						FRACTIONAL, &_vectors[atom1][atom2]);
-					_vectors[atom1][atom2] += iso.atoms()[k][m].fractional();
-					_vectors[atom1][atom2] -= iso.atoms()[i][j].fractional();
+					total += _pairConstants[i][j](m, n);
+					absTotal += Num<double>::abs(_pairConstants[i][j](m, n));
 				}
 			}
+			for (j = 0; j < _pairAtoms[i].length(); ++j)
+			{
+				for (n = 0; n < 3; ++n)
+					_pairConstants[i][j](m, n) -= total * Num<double>::abs(_pairConstants[i][j](m, n)) / absTotal;
+			}
 		}
 	}
 	
+	// Save masses and vectors between pairs of atoms
+	for (i = 0; i < _pairAtoms.length(); ++i)
+	{
+		_masses[i] = atoms[i]->element().mass();
+		_pairVectors[i].length(_pairAtoms[i].length());
+		for (j = 0; j < _pairAtoms[i].length(); ++j)
+			_pairVectors[i][j] = pairVector(iso, *atoms[i], *atoms[_pairAtoms[i][j]]);
+	}
+	
+	// Output
+	int numPairs = 0;
+	for (i = 0; i < _pairAtoms.length(); ++i)
+		numPairs += _pairAtoms[i].length();
+	Output::newline();
+	Output::print("Stored force constants for ");
+	Output::print(numPairs);
+	Output::print(" of ");
+	Output::print(iso.numAtoms() * iso.numAtoms());
+	Output::print(" pairs of atoms");
+	
 	// Print force constant file if needed
 	Word fcFile;
 	if (_writeFCFile)
@@ -275,18 +335,22 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 		// Loop over pairs of atoms
 		for (i = 0; i < types.length(); ++i)
 		{
-			for (j = 0; j < types[i].length(); ++j)
+			for (j = 0; j < types.length(); ++j)
 			{
 
 				// Print types
 				Output::newline();
-				Output::print(types[i][j][0]);
+				Output::print(types[i]);
 				Output::print(" ");
-				Output::print(types[i][j][1]);
+				Output::print(types[j]);
 				Output::print(" ");
 
 				// Print vector components
-				Output::print(_vectors[i][j], 8, false);
+				index = pairIndex(i, j);
+				if (index >= 0)
+					Output::print(_pairVectors[i][index], 8, false);
+				else
+					Output::print(pairVector(iso, *atoms[i], *atoms[j]), 8, false);
 
 				// Print force constants
 				for (k = 0; k < 3; ++k)
@@ -294,7 +358,7 @@ Word Phonons::generateForceConstants(const ISO& iso, const Symmetry& symmetry, c
 					Output::newline();
 					for (m = 0; m < 3; ++m)
 					{
-						Output::printSci(_forceConstants(3*i+k, 3*j+m), 8);
+						Output::printSci(index >= 0 ? _pairConstants[i][index](k, m) : 0.0, 8);
 						if (m != 2)
 							Output::print(" ");
 					}
@@ -366,8 +430,7 @@ void Phonons::getForceConstants(Vector& constants, const ISO& iso, const Symmetr
 		potential.single(iso, /*newSymmetry, */0, &forces.last(), true, false);
 		
 		// Convert forces to cartesian frame
-		for (i = 0; i < forces.last().length(); ++i)
-			iso.basis().toCartesian(forces.last()[i]);
+		iso.basis().toCartesian(forces.last());
 		
 		// Output
 		Output::decrease();
@@ -401,50 +464,163 @@ void Phonons::getForceConstants(Vector& constants, const ISO& iso, const Symmetr
 
 
 
-/* CVector Phonons::frequencies(const Vector3D& qFrac, CMatrix* modes) const
+/* Vector3D Phonons::pairVector(const ISO& iso, const Atom& atom1, const Atom& atom2)
  *
- * Get the squared frequencies for a set reciprocal lattice vector
+ * Get the fractional vector from an atom to the nearest image of a second atom
  */
 
-CVector Phonons::frequencies(const Vector3D& qFrac, CMatrix* modes) const
+Vector3D Phonons::pairVector(const ISO& iso, const Atom& atom1, const Atom& atom2)
+{
+	Vector3D res;
+	iso.basis().distance(atom1.fractional(), FRACTIONAL, atom2.fractional(), FRACTIONAL, &res);
+	res += atom2.fractional();
+	res -= atom1.fractional();
+	return res;
+}
+
+
+
+/* void Phonons::sortPairs(List<int>& atoms, OList<Matrix3D>& constants, int left, int right)
+ *
+ * Sort pairs of an atom by the number of the second atom
+ */
+
+void Phonons::sortPairs(List<int>& atoms, OList<Matrix3D>& constants, int left, int right)
 {
 	
-	// Output
-	Output::newline();
-	Output::print("Diagonalizing dynamical matrix at q = ");
-	Output::print(qFrac, 8, true);
-	Output::increase();
+	// Current partition has no width
+	if (left >= right)
+		return;
+	
+	// Choose pivot index
+	int pivotIndex = (left + right) / 2;
+	int pivot = atoms[pivotIndex];
+	
+	// Move pivot to end
+	atoms.swap(pivotIndex, right);
+	constants.swap(pivotIndex, right);
+	
+	// Iterate through current partition
+	int newPivotIndex = left;
+	for (int i = left; i < right; ++i)
+	{
+		if (atoms[i] < pivot)
+		{
+			atoms.swap(i, newPivotIndex);
+			constants.swap(i, newPivotIndex);
+			++newPivotIndex;
+		}
+	}
+	
+	// Move pivot to final position
+	atoms.swap(newPivotIndex, right);
+	constants.swap(newPivotIndex, right);
+	
+	// Recursive calls to next sorts
+	sortPairs(atoms, constants, left, newPivotIndex - 1);
+	sortPairs(atoms, constants, newPivotIndex + 1, right);
+}
+
+
+
+/* Matrix Phonons::forceConstants() const
+ *
+ * Get the full force constant matrix
+ */
+
+Matrix Phonons::forceConstants() const
+{
+	int i, j, k, m;
+	Matrix res(3 * numAtoms());
+	res.fill(0);
+	for (i = 0; i < _pairAtoms.length(); ++i)
+	{
+		for (j = 0; j < _pairAtoms[i].length(); ++j)
+		{
+			for (k = 0; k < 3; ++k)
+			{
+				for (m = 0; m < 3; ++m)
+					res(3*i+k, 3*_pairAtoms[i][j]+m) = _pairConstants[i][j](k, m);
+			}
+		}
+	}
+	return res;
+}
+
+
+
+/* void Phonons::dynamicalMatrix(const Vector3D& qFrac, CMatrix& matrix) const
+ *
+ * Build the dynamical matrix at a reciprocal lattice vector from the stored pairs of atoms
+ */
+
+void Phonons::dynamicalMatrix(const Vector3D& qFrac, CMatrix& matrix) const
+{
 	
 	// Get the q vector
 	Vector3D q = qFrac * (2 * Constants::pi);
 	
-	// Build up the Hessian matrix, loop over pairs of atoms
+	// Clear matrix
 	int i, j, k, m;
+	int atom2;
+	int size = 3 * numAtoms();
+	matrix.size(size, size);
+	for (i = 0; i < size; ++i)
+	{
+		for (j = 0; j < size; ++j)
+			matrix(i, j).real = matrix(i, j).imag = 0;
+	}
+	
+	// Loop over stored pairs of atoms
 	double arg;
+	double massFactor;
 	Complex scale;
-	CMatrix H(_forceConstants.numRows(), _forceConstants.numCols());
-	for (i = 0; i < _massFactors.numRows(); ++i)
+	for (i = 0; i < _pairAtoms.length(); ++i)
 	{
-		for (j = 0; j < _massFactors.numCols(); ++j)
+		for (j = 0; j < _pairAtoms[i].length(); ++j)
 		{
 			
 			// Save scaling for current pair
-			arg = q * _vectors[i][j];
-			scale.real = cos(arg)/_massFactors(i, j);
-			scale.imag = sin(arg)/_massFactors(i, j);
+			atom2 = _pairAtoms[i][j];
+			arg = q * _pairVectors[i][j];
+			massFactor = sqrt(_masses[i] * _masses[atom2]);
+			scale.real = cos(arg)/massFactor;
+			scale.imag = sin(arg)/massFactor;
 			
 			// Loop over directions and save matrix values
 			for (k = 0; k < 3; ++k)
 			{
 				for (m = 0; m < 3; ++m)
-					H(3*i+k, 3*j+m) = _forceConstants(3*i+k, 3*j+m) * scale;
+					matrix(3*i+k, 3*atom2+m) = _pairConstants[i][j](k, m) * scale;
 			}
 		}
 	}
+}
+
+
+
+/* CVector Phonons::frequencies(const Vector3D& qFrac, CMatrix* modes) const
+ *
+ * Get the squared frequencies for a set reciprocal lattice vector
+ */
+
+CVector Phonons::frequencies(const Vector3D& qFrac, CMatrix* modes) const
+{
+	
+	// Output
+	Output::newline();
+	Output::print("Diagonalizing dynamical matrix at q = ");
+	Output::print(qFrac, 8, true);
+	Output::increase();
+	
+	// Build up the Hessian matrix
+	int i;
+	CMatrix H;
+	dynamicalMatrix(qFrac, H);
 	
 	// Get the squared frequencies
-	CMatrix allModes;
-	CVector squaredFreqs = H.eigenvalues(&allModes, true);
+	CVector squaredFreqs = H.eigenvaluesInPlace(true, true);
+	CMatrix& allModes = H;
 	for (i = 0; i < squaredFreqs.length(); ++i)
 	{
 		
@@ -510,6 +686,209 @@ CVector Phonons::frequencies(const Vector3D& qFrac, CMatrix* modes) const
 
 
 
+/* CVector Phonons::lowestFrequencies(const Vector3D& qFrac, int numModes, CMatrix* modes) const
+ *
+ * Get the lowest frequencies at a reciprocal lattice vector without solving for all modes
+ */
+
+CVector Phonons::lowestFrequencies(const Vector3D& qFrac, int numModes, CMatrix* modes) const
+{
+	
+	// Output
+	Output::newline();
+	Output::print("Getting lowest ");
+	Output::print(numModes);
+	Output::print(" mode");
+	if (numModes != 1)
+		Output::print("s");
+	Output::print(" of dynamical matrix at q = ");
+	Output::print(qFrac, 8, true);
+	Output::increase();
+	
+	// Build up the Hessian matrix
+	CMatrix H;
+	dynamicalMatrix(qFrac, H);
+	
+	// Get the lowest squared frequencies in ascending order
+	CVector squaredFreqs = H.eigenvalueRange(0, numModes - 1, modes);
+	
+	// Get the frequencies
+	CVector freqs(squaredFreqs.length());
+	for (int i = 0; i < freqs.length(); ++i)
+	{
+		if (squaredFreqs[i].real >= 0)
+		{
+			freqs[i].real = sqrt(squaredFreqs[i].real) / (2 * Constants::pi);
+			freqs[i].imag = 0;
+		}
+		else
+		{
+			freqs[i].imag = sqrt(-squaredFreqs[i].real) / (2 * Constants::pi);
+			freqs[i].real = 0;
+		}
+	}
+	
+	// Output
+	Output::decrease();
+	
+	// Return the frequencies
+	return freqs;
+}
+
+
+
+/* double Phonons::freeEnergy(double temperature, int meshSize, const Symmetry* symmetry, int* numImaginary) const
+ *
+ * Get the harmonic vibrational free energy of the cell (eV) at a temperature using a gamma-centered q-point
+ *		mesh that is reduced by the point group of the structure and time reversal symmetry. Imaginary modes
+ *		do not contribute, so the result is only meaningful if numImaginary is zero.
+ */
+
+double Phonons::freeEnergy(double temperature, int meshSize, const Symmetry* symmetry, int* numImaginary) const
+{
+	
+	// Output
+	Output::newline();
+	Output::print("Calculating vibrational free energy at ");
+	Output::print(temperature);
+	Output::print(" K on a ");
+	Output::print(meshSize);
+	Output::print("x");
+	Output::print(meshSize);
+	Output::print("x");
+	Output::print(meshSize);
+	Output::print(" q-point mesh");
+	Output::increase();
+	
+	// Get the rotations that leave the mesh unchanged (q transforms as the transpose of the rotation)
+	int i, j, k;
+	OList<Matrix3D> rotations;
+	if (symmetry)
+	{
+		for (i = 0; i < symmetry->operations().length(); ++i)
+			rotations += symmetry->operations()[i].rotation().transpose();
+	}
+	if (!rotations.length())
+	{
+		rotations.add();
+		rotations.last().makeIdentity();
+	}
+	
+	// Reduce mesh to irreducible points
+	int m, n;
+	int index;
+	int numPoints = meshSize * meshSize * meshSize;
+	List<int> weights(numPoints);
+	weights.fill(-1);
+	List<int> irreducible;
+	Vector3D point;
+	Vector3D rotPoint;
+	for (i = 0; i < numPoints; ++i)
+	{
+		
+		// Already mapped to an irreducible point
+		if (weights[i] >= 0)
+			continue;
+		irreducible += i;
+		weights[i] = 1;
+		
+		// Loop over operations and time reversal
+		point.set(i / (meshSize * meshSize), (i / meshSize) % meshSize, i % meshSize);
+		for (j = 0; j < rotations.length(); ++j)
+		{
+			rotPoint = rotations[j] * point;
+			for (k = -1; k <= 1; k += 2)
+			{
+				index = 0;
+				for (m = 0; m < 3; ++m)
+				{
+					n = (int)Num<double>::round(k * rotPoint[m], 1) % meshSize;
+					if (n < 0)
+						n += meshSize;
+					index = index * meshSize + n;
+				}
+				if (weights[index] < 0)
+				{
+					weights[index] = 0;
+					++weights[i];
+				}
+			}
+		}
+	}
+	
+	// Output
+	Output::newline();
+	Output::print("Using ");
+	Output::print(irreducible.length());
+	Output::print(" irreducible q-point");
+	if (irreducible.length() != 1)
+		Output::print("s");
+	
+	// Conversion from internal frequency units to Hz
+	double toHz = Constants::meter * sqrt(Constants::kg / Constants::joule);
+	double kT = Constants::kb * temperature;
+	
+	// Loop over irreducible points
+	int numSkipped = 0;
+	int totalWeight = 0;
+	double energy;
+	Accumulator total;
+	CVector freqs;
+	for (i = 0; i < irreducible.length(); ++i)
+	{
+		
+		// Get the frequencies at the point
+		index = irreducible[i];
+		point.set((double)(index / (meshSize * meshSize)) / meshSize, (double)((index / meshSize) % meshSize) / \
+			meshSize, (double)(index % meshSize) / meshSize);
+		freqs = frequencies(point);
+		
+		// Add contribution from each mode
+		totalWeight += weights[index];
+		for (j = 0; j < freqs.length(); ++j)
+		{
+			
+			// Skip acoustic modes at gamma and imaginary modes
+			if ((!index) && (j < 3))
+				continue;
+			if ((freqs[j].imag > 0) || (freqs[j].real <= 0))
+			{
+				++numSkipped;
+				continue;
+			}
+			
+			// Zero point energy plus thermal contribution
+			energy = Constants::h * toHz * freqs[j].real;
+			if (kT > 0)
+				total += weights[index] * (energy / 2 + kT * log(1 - exp(-energy / kT)));
+			else
+				total += weights[index] * energy / 2;
+		}
+	}
+	
+	// Save number of skipped modes and print warning
+	if (numImaginary)
+		*numImaginary = numSkipped;
+	if (numSkipped)
+	{
+		Output::newline(WARNING);
+		Output::print("Ignored ");
+		Output::print(numSkipped);
+		Output::print(" imaginary mode");
+		if (numSkipped != 1)
+			Output::print("s");
+		Output::print(" when calculating vibrational free energy");
+	}
+	
+	// Output
+	Output::decrease();
+	
+	// Return the average over the mesh
+	return total.value() / totalWeight;
+}
+
+
+
 /* void Phonons::sortModes(CVector& freqs, CMatrix& modes, int left, int right)
  *
  * Sort frequencies
@@ -722,11 +1101,10 @@ void Phonons::set(const Text& content)
 	
 	// Allocate space
 	int i;
-	_forceConstants.size(3*size);
-	_massFactors.size(size);
-	_vectors.length(size);
-	for (i = 0; i < size; ++i)
-		_vectors[i].length(size);
+	_masses.length(size);
+	_pairAtoms.length(size);
+	_pairConstants.length(size);
+	_pairVectors.length(size);
 	
 	// Get masses
 	List<double> masses(content[0].length());
@@ -734,11 +1112,12 @@ void Phonons::set(const Text& content)
 		masses[i] = atof(content[0][i].array());
 	
 	// Loop over data lines
-	int j, k;
 	int type1;
 	int type2;
 	int curRow = 0;
 	int curCol = 0;
+	Matrix3D curMat;
+	Matrix3D transMat;
 	for (i = 1; i < content.length(); i += 4)
 	{
 		
@@ -759,17 +1138,16 @@ void Phonons::set(const Text& content)
 			Output::print("Requesting mass of atom that has not been defined");
 			Output::quit();
 		}
-		_massFactors(curRow, curCol) = sqrt(masses[type1]*masses[type2]);
+		_masses[curRow] = masses[type1];
 		
-		// Set vector
-		_vectors[curRow][curCol].set(atof(content[i][2].array()), atof(content[i][3].array()), \
-			atof(content[i][4].array()));
-		
-		// Get force constant values
-		for (j = 0; j < 3; ++j)
+		// Get force constant values and save if pair interacts in either orientation
+		readBlock(content, i, curMat);
+		readBlock(content, 1 + 4*(curCol*size + curRow), transMat);
+		if ((curRow == curCol) || (!isZero(curMat)) || (!isZero(transMat)))
 		{
-			for (k = 0; k < 3; ++k)
-				_forceConstants(3*curRow+j, 3*curCol+k) = atof(content[i+j+1][k].array());
+			addPair(curRow, curCol, curMat);
+			_pairVectors[curRow] += Vector3D(atof(content[i][2].array()), atof(content[i][3].array()), \
+				atof(content[i][4].array()));
 		}
 		
 		// Set new row and column
@@ -789,6 +1167,28 @@ void Phonons::set(const Text& content)
 
 
 
+/* void Phonons::readBlock(const Text& content, int line, Matrix3D& constants)
+ *
+ * Read 3x3 block of force constants that follows the header on a line of a force constant file
+ */
+
+void Phonons::readBlock(const Text& content, int line, Matrix3D& constants)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		if (content[line+i+1].length() < 3)
+		{
+			Output::newline(ERROR);
+			Output::print("Not enough force constants on force constant file line");
+			Output::quit();
+		}
+		for (int j = 0; j < 3; ++j)
+			constants(i, j) = atof(content[line+i+1][j].array());
+	}
+}
+
+
+
 /* bool Phonons::isForceConstantFile(const Text& content)
  * 
  * Return whether file contains force constant information
@@ -42,13 +42,24 @@ class Phonons
 	// Variables
 	bool _isSet;
 	bool _writeFCFile;
-	Matrix _forceConstants;
-	Matrix _massFactors;
-	OList<Vector3D>::D2 _vectors;
+	List<double> _masses;
+	List<int>::D2 _pairAtoms;
+	OList<Matrix3D>::D2 _pairConstants;
+	OList<Vector3D>::D2 _pairVectors;
+	
+	// Blocks of force constants with a Frobenius norm no larger than this are not stored
+	static const double _zeroTolerance;
 	
 	// Functions
 	static void getForceConstants(Vector& constants, const ISO& iso, const Symmetry& symmetry, \
 		const Potential& potential, Atom* atom, int direction);
+	static Vector3D pairVector(const ISO& iso, const Atom& atom1, const Atom& atom2);
+	static bool isZero(const Matrix3D& constants);
+	static void readBlock(const Text& content, int line, Matrix3D& constants);
+	static void sortPairs(List<int>& atoms, OList<Matrix3D>& constants, int left, int right);
+	int pairIndex(int atom1, int atom2) const;
+	void addPair(int atom1, int atom2, const Matrix3D& constants);
+	void dynamicalMatrix(const Vector3D& qFrac, CMatrix& matrix) const;
 	static void sortModes(CVector& freqs, CMatrix& modes, int left, int right);
 	static void moveAcousticToStart(CVector& freqs, CMatrix& modes);
 	static bool isAcoustic(CMatrix& modes, int index);
@@ -74,10 +85,18 @@ public:
 	
 	// Get modes at given reciprocal lattice vector
 	CVector frequencies(const Vector3D& qFrac, CMatrix* modes = 0) const;
+	CVector lowestFrequencies(const Vector3D& qFrac, int numModes, CMatrix* modes = 0) const;
+	
+	// Harmonic vibrational free energy
+	double freeEnergy(double temperature, int meshSize, const Symmetry* symmetry = 0, int* numImaginary = 0) const;
 	
 	// Access functions
-	bool isSet() const						{ return _isSet; }
-	const Matrix& forceConstants() const	{ return _forceConstants; }
+	bool isSet() const									{ return _isSet; }
+	int numAtoms() const								{ return _pairAtoms.length(); }
+	int numPairs(int atom) const						{ return _pairAtoms[atom].length(); }
+	int pairAtom(int atom, int pair) const				{ return _pairAtoms[atom][pair]; }
+	const Matrix3D& pairConstants(int atom, int pair) const	{ return _pairConstants[atom][pair]; }
+	Matrix forceConstants() const;
 	
 	// Other functions
 	static bool isForceConstantFile(const Text& content);
@@ -94,9 +113,10 @@ public:
 inline void Phonons::clear()
 {
 	_isSet = false;
-	_forceConstants.clear();
-	_massFactors.clear();
-	_vectors.clear();
+	_masses.clear();
+	_pairAtoms.clear();
+	_pairConstants.clear();
+	_pairVectors.clear();
 }
 
 
@@ -112,9 +132,10 @@ inline Phonons& Phonons::operator= (const Phonons& rhs)
 	{
 		clear();
 		_isSet = rhs._isSet;
-		_forceConstants = rhs._forceConstants;
-		_massFactors = rhs._massFactors;
-		_vectors = rhs._vectors;
+		_masses = rhs._masses;
+		_pairAtoms = rhs._pairAtoms;
+		_pairConstants = rhs._pairConstants;
+		_pairVectors = rhs._pairVectors;
 	}
 	return *this;
 }
@@ -135,4 +156,61 @@ inline Word Phonons::generateForceConstants(const ISO& iso, const Potential& pot
 
 
 
+/* inline int Phonons::pairIndex(int atom1, int atom2) const
+ *
+ * Return index of second atom in the stored pairs of the first atom or -1 if the pair is not stored
+ */
+
+inline int Phonons::pairIndex(int atom1, int atom2) const
+{
+	int mid;
+	int left = 0;
+	int right = _pairAtoms[atom1].length() - 1;
+	while (left <= right)
+	{
+		mid = (left + right) / 2;
+		if (_pairAtoms[atom1][mid] == atom2)
+			return mid;
+		if (_pairAtoms[atom1][mid] < atom2)
+			left = mid + 1;
+		else
+			right = mid - 1;
+	}
+	return -1;
+}
+
+
+
+/* inline void Phonons::addPair(int atom1, int atom2, const Matrix3D& constants)
+ *
+ * Add force constants for pair of atoms to the end of the list for the first atom
+ */
+
+inline void Phonons::addPair(int atom1, int atom2, const Matrix3D& constants)
+{
+	_pairAtoms[atom1] += atom2;
+	_pairConstants[atom1] += constants;
+}
+
+
+
+/* inline bool Phonons::isZero(const Matrix3D& constants)
+ *
+ * Return whether block of force constants is negligible (Frobenius norm is used so that the result does not
+ *	change under rotation or transposition of the block)
+ */
+
+inline bool Phonons::isZero(const Matrix3D& constants)
+{
+	double total = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+			total += constants(i, j) * constants(i, j);
+	}
+	return (sqrt(total) <= _zeroTolerance);
+}
+
+
+
 #endif
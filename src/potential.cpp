@@ -24,6 +24,11 @@
 #include "locPotential.h"
 #include "extPotential.h"
 #include "language.h"
+#include "multi.h"
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <unistd.h>
 
 
 
@@ -64,6 +69,29 @@ void Potential::set(const Text& text)
 		}
 	}
 	
+	// Save key for the potential settings so that cached reference states can be matched to them
+	// The key covers the program version, the settings, and the contents of any files that they name
+	int j, k;
+	#if defined(VERSION)
+		_settingsKey = Reference::hash(VERSION, 0);
+	#else
+		_settingsKey = Reference::hash("unknown version", 0);
+	#endif
+	for (i = 0; i < data.length(); ++i)
+	{
+		for (j = 0; j < data[i].length(); ++j)
+		{
+			for (k = 0; k < data[i][j].length(); ++k)
+			{
+				_settingsKey = Reference::hash(data[i][j][k].array(), _settingsKey);
+				_settingsKey = Reference::hash(" ", _settingsKey);
+				if ((_referenceCache.length()) && (File::exists(data[i][j][k])))
+					_settingsKey = Reference::hashFile(data[i][j][k], _settingsKey);
+			}
+			_settingsKey = Reference::hash("\n", _settingsKey);
+		}
+	}
+	
 	// Loop over parsed input to figure out what kind of potential to use
 	bool useVasp = false;
 	bool useLocal = false;
@@ -101,7 +129,7 @@ void Potential::set(const Text& text)
 			error(firstLocal, PT_QE);
 		
 		// Set potential
-		_ipo = new LocalPotential;
+		_ipo = _local = new LocalPotential;
 	}
 	
 	// Set Vasp potential
@@ -176,6 +204,14 @@ void Potential::set(const Text& text)
 			Output::print(_references[i].energyPerAtom());
 			Output::print(" eV/atom");
 		}
+		Output::newline();
+		if (_referenceCache.length())
+		{
+			Output::print("Calculated reference states will be cached in ");
+			Output::print(_referenceCache);
+		}
+		else
+			Output::print("Calculated reference states will not be cached");
 		Output::decrease();
 	}
 	
@@ -219,6 +255,29 @@ void Potential::setReferenceData(const Text& input)
 		if (Language::isComment(input[i][0]))
 			continue;
 		
+		// Found cache setting (caching is off unless it is turned on here)
+		if (input[i][0].equal("cache", false, 5))
+		{
+			if ((input[i].length() > 1) && ((input[i][1].equal("off", false)) || \
+				(input[i][1].equal("none", false)) || (input[i][1].equal("false", false))))
+				_referenceCache.clear();
+			else if ((input[i].length() < 2) || (input[i][1].equal("on", false)) || \
+				(input[i][1].equal("true", false)))
+			{
+				char* home = getenv("HOME");
+				if (!home)
+				{
+					Output::newline(ERROR);
+					Output::print("Could not determine home directory for reference state cache");
+					Output::quit();
+				}
+				_referenceCache = Directory::makePath(Word(home), Word(".mint_references"));
+			}
+			else
+				_referenceCache = input[i][1];
+			continue;
+		}
+		
 		// Check for errors
 		element = Element::find(input[i][0], true, true);
 		if (input[i].length() < 2)
@@ -314,36 +373,43 @@ double Potential::getReferenceEnergy(const ISO& iso) const
 	if (!_useReferences)
 		return 0;
 	
-	// Loop over elements in the structure
+	// Add reference states for any elements that have not been seen yet
 	int i, j;
 	bool found;
-	double res = 0;
+	int numKnown = _references.length();
 	for (i = 0; i < iso.atoms().length(); ++i)
 	{
-		
-		// Loop over reference states that have been set
 		found = false;
 		for (j = 0; j < _references.length(); ++j)
 		{
-			
-			// Found current element so save
 			if (iso.atoms()[i][0].element() == _references[j].element())
 			{
-				res += iso.atoms()[i].length() * _references[j].energyPerAtom();
 				found = true;
 				break;
 			}
 		}
-		
-		// Found a new element
 		if (!found)
 		{
-			
-			// Set reference state and get energy
 			_references.add();
 			_references.last().set(iso.atoms()[i][0].element(), true);
-			_references.last().set(*this);
-			res += iso.atoms()[i].length() * _references.last().energyPerAtom();
+		}
+	}
+	
+	// Calculate energies of new reference states together so that each is done once per run
+	for (i = numKnown; i < _references.length(); ++i)
+		_references[i].set(*this);
+	
+	// Loop over elements in the structure
+	double res = 0;
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < _references.length(); ++j)
+		{
+			if (iso.atoms()[i][0].element() == _references[j].element())
+			{
+				res += iso.atoms()[i].length() * _references[j].energyPerAtom();
+				break;
+			}
 		}
 	}
 	
@@ -392,6 +458,14 @@ Word Potential::potentialType(PotentialType type)
 	if (type == PT_EWALD)
 		return Word("Ewald");
 	
+	// Found damped-shifted-force
+	if (type == PT_WOLF)
+		return Word("Wolf");
+	
+	// Found embedded-atom method
+	if (type == PT_EAM)
+		return Word("EAM");
+	
 	// Found lennard jones
 	if (type == PT_LENNARDJONES)
 		return Word("Lennard-Jones");
@@ -442,6 +516,14 @@ PotentialType Potential::potentialType(const Word& word)
 	if (word.equal("electrostatic", false, 7))
 		return PT_ELECTROSTATIC;
 	
+	// Found damped-shifted-force
+	if ((word.equal("wolf", false)) || (word.equal("dsf", false)))
+		return PT_WOLF;
+	
+	// Found embedded-atom method
+	if (word.equal("eam", false))
+		return PT_EAM;
+	
 	// Found lennard jones
 	if (word.equal("lennard", false, 4))
 		return PT_LENNARDJONES;
@@ -514,11 +596,27 @@ void Reference::set(const Potential& potential)
 	Output::print(_iso.atoms()[0][0].element().symbol());
 	Output::increase();
 	
+	// Check whether the reference state was calculated in a previous run
+	unsigned long int curKey = key(potential);
+	if ((potential._referenceCache.length()) && (readCache(potential._referenceCache, curKey)))
+	{
+		Output::newline();
+		Output::print("Read energy of ");
+		Output::print(_energyPerAtom);
+		Output::print(" eV/atom from cache");
+		Output::decrease();
+		return;
+	}
+	
 	// Evaluate the potential
 	_energyPerAtom = 0;
 	potential._ipo->relax(_iso, &_energyPerAtom);
 	_energyPerAtom /= _iso.atoms()[0].length();
 	
+	// Save result
+	if (potential._referenceCache.length())
+		writeCache(potential._referenceCache, curKey);
+	
 	// Output
 	Output::newline();
 	Output::print("Energy of ");
@@ -531,6 +629,253 @@ void Reference::set(const Potential& potential)
 
 
 
+/* unsigned long int Reference::key(const Potential& potential) const
+ *
+ * Return key for the current reference structure evaluated with potential
+ */
+
+unsigned long int Reference::key(const Potential& potential) const
+{
+	
+	// Add element and potential settings
+	unsigned long int res = hash(_element.symbol().array(), potential._settingsKey);
+	
+	// Add basis
+	int i, j;
+	char buffer[50];
+	for (i = 0; i < 3; ++i)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			sprintf(buffer, "%.8f ", _iso.basis().vectors()(i, j));
+			res = hash(buffer, res);
+		}
+	}
+	
+	// Add atoms
+	for (i = 0; i < _iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < _iso.atoms()[i].length(); ++j)
+		{
+			res = hash(_iso.atoms()[i][j].element().symbol().array(), res);
+			sprintf(buffer, " %.8f %.8f %.8f\n", _iso.atoms()[i][j].fractional()[0], \
+				_iso.atoms()[i][j].fractional()[1], _iso.atoms()[i][j].fractional()[2]);
+			res = hash(buffer, res);
+		}
+	}
+	
+	// Return key
+	return res;
+}
+
+
+
+/* bool Reference::readCache(const Word& file, unsigned long int key)
+ *
+ * Set energy and structure from cache if present
+ */
+
+bool Reference::readCache(const Word& file, unsigned long int key)
+{
+	
+	// Return if the file does not exist
+	if (!File::exists(file))
+		return false;
+	
+	// Loop over entries in the file
+	// Each entry is "symbol key energy numAtoms" followed by basis vectors and fractional positions
+	int i, j, k;
+	int numAtoms;
+	Text content = Read::text(file);
+	for (i = 0; i < content.length(); ++i)
+	{
+		
+		// Skip if not an entry for the current structure
+		if (content[i].length() != 4)
+			continue;
+		if (content[i][0] != _element.symbol())
+			continue;
+		if (strtoul(content[i][1].array(), 0, 10) != key)
+			continue;
+		numAtoms = atoi(content[i][3].array());
+		if ((numAtoms <= 0) || (i + 3 + numAtoms >= content.length()))
+			continue;
+		
+		// Make sure that the entry is complete
+		bool complete = true;
+		for (j = i + 1; j <= i + 3 + numAtoms; ++j)
+		{
+			if (content[j].length() != 3)
+				complete = false;
+		}
+		if (!complete)
+			continue;
+		
+		// Save energy
+		_energyPerAtom = atof(content[i][2].array());
+		
+		// Save basis
+		Matrix3D vectors;
+		for (j = 0; j < 3; ++j)
+		{
+			for (k = 0; k < 3; ++k)
+				vectors(j, k) = atof(content[i+1+j][k].array());
+		}
+		_iso.clearAtoms();
+		_iso.basis(vectors, false);
+		
+		// Save atoms
+		Atom* atom;
+		for (j = 0; j < numAtoms; ++j)
+		{
+			atom = _iso.addAtom(_element);
+			atom->fractional(atof(content[i+4+j][0].array()), atof(content[i+4+j][1].array()), \
+				atof(content[i+4+j][2].array()));
+		}
+		return true;
+	}
+	
+	// Entry was not found
+	return false;
+}
+
+
+
+/* void Reference::writeCache(const Word& file, unsigned long int key) const
+ *
+ * Add current reference state to cache. The new file is written next to the cache and renamed over it so that
+ *		a run that is stopped part way, or another run reading the cache, never sees a partial file.
+ */
+
+void Reference::writeCache(const Word& file, unsigned long int key) const
+{
+	
+	// Only write from the root processor
+	if (Multi::rank() != 0)
+		return;
+	
+	// Get current contents so that entries from other runs are kept
+	Text content;
+	if (File::exists(file))
+		content = Read::text(file);
+	
+	// Open temporary file
+	Word tempFile = file;
+	tempFile += ".";
+	tempFile += Language::numberToWord((int)getpid());
+	tempFile += ".tmp";
+	ofstream outfile (tempFile.array());
+	if (!outfile.is_open())
+	{
+		Output::newline(WARNING);
+		Output::print("Could not write reference state cache to ");
+		Output::print(file);
+		return;
+	}
+	
+	// Print previous contents
+	int i, j;
+	for (i = 0; i < content.length(); ++i)
+	{
+		if (!content[i].length())
+			continue;
+		for (j = 0; j < content[i].length(); ++j)
+		{
+			if (j)
+				outfile << " ";
+			outfile << content[i][j].array();
+		}
+		outfile << "\n";
+	}
+	
+	// Print header for current reference
+	outfile << setiosflags(ios::fixed) << setprecision(14);
+	outfile << _element.symbol().array() << " " << key << " " << _energyPerAtom << " " << _iso.numAtoms() << "\n";
+	
+	// Print basis
+	for (i = 0; i < 3; ++i)
+	{
+		for (j = 0; j < 3; ++j)
+		{
+			if (j)
+				outfile << " ";
+			outfile << _iso.basis().vectors()(i, j);
+		}
+		outfile << "\n";
+	}
+	
+	// Print atoms
+	int k;
+	for (i = 0; i < _iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < _iso.atoms()[i].length(); ++j)
+		{
+			for (k = 0; k < 3; ++k)
+			{
+				if (k)
+					outfile << " ";
+				outfile << _iso.atoms()[i][j].fractional()[k];
+			}
+			outfile << "\n";
+		}
+	}
+	
+	// Replace the cache
+	outfile.close();
+	if ((outfile.fail()) || (rename(tempFile.array(), file.array())))
+	{
+		std::remove(tempFile.array());
+		Output::newline(WARNING);
+		Output::print("Could not write reference state cache to ");
+		Output::print(file);
+	}
+}
+
+
+
+/* unsigned long int Reference::hashFile(const Word& file, unsigned long int start)
+ *
+ * Add contents of a file to a running hash
+ */
+
+unsigned long int Reference::hashFile(const Word& file, unsigned long int start)
+{
+	unsigned long int res = (start) ? start : 14695981039346656037UL;
+	ifstream infile (file.array(), ios::binary);
+	char buffer[4096];
+	int i;
+	while (infile)
+	{
+		infile.read(buffer, 4096);
+		for (i = 0; i < infile.gcount(); ++i)
+		{
+			res ^= (unsigned char)buffer[i];
+			res *= 1099511628211UL;
+		}
+	}
+	return res;
+}
+
+
+
+/* unsigned long int Reference::hash(const char* string, unsigned long int start)
+ *
+ * Add string to a running 64-bit FNV-1a hash (start with empty string and zero to initialize)
+ */
+
+unsigned long int Reference::hash(const char* string, unsigned long int start)
+{
+	unsigned long int res = (start) ? start : 14695981039346656037UL;
+	for (; *string; ++string)
+	{
+		res ^= (unsigned char)(*string);
+		res *= 1099511628211UL;
+	}
+	return res;
+}
+
+
+
 /* void Reference::set(const Element& element, bool setISO)
  *
  * Set the structure for the reference element
@@ -39,12 +39,13 @@
 
 // Types of energy functions
 enum PotentialType {PT_UNKNOWN, PT_VASP, PT_QE, PT_EWALD, PT_LENNARDJONES, PT_BUCKINGHAM, PT_POWER, PT_EXPONENTIAL, \
-	PT_COVALENT, PT_ELECTROSTATIC};
+	PT_COVALENT, PT_ELECTROSTATIC, PT_WOLF, PT_EAM};
 
 
 
 // Declare that Potential object will be defined later
 class Potential;
+class LocalPotential;
 
 
 
@@ -96,6 +97,11 @@ class Reference
 	Element _element;
 	double _energyPerAtom;
 	
+	// Functions
+	unsigned long int key(const Potential& potential) const;
+	bool readCache(const Word& file, unsigned long int key);
+	void writeCache(const Word& file, unsigned long int key) const;
+	
 public:
 	
 	// Setup functions
@@ -106,6 +112,11 @@ public:
 	// Access functions
 	const Element& element() const			{ return _element; }
 	double energyPerAtom() const			{ return _energyPerAtom; }
+	const ISO& iso() const					{ return _iso; }
+	
+	// Static functions
+	static unsigned long int hash(const char* string, unsigned long int start);
+	static unsigned long int hashFile(const Word& file, unsigned long int start);
 };
 
 
@@ -118,7 +129,10 @@ class Potential
 	bool _useReferences;
 	double _unphysicalCutoff;
 	IPO* _ipo;
+	LocalPotential* _local;
 	mutable OList<Reference> _references;
+	Word _referenceCache;
+	unsigned long int _settingsKey;
 	
 	// Functions
 	bool finish(const ISO& iso, double* energy, OList<Vector3D >* forces) const;
@@ -136,7 +150,7 @@ class Potential
 public:
 	
 	// Destructor
-	Potential()		{ _ipo = 0; _useReferences = false; _unphysicalCutoff = -5; }
+	Potential()		{ _ipo = 0; _local = 0; _useReferences = false; _unphysicalCutoff = -5; _settingsKey = 0; }
 	~Potential()	{ clear(); }
 	
 	// Setup functions
@@ -170,6 +184,8 @@ public:
 	bool usesSymmetry() const	{ return isSet() ? _ipo->usesSymmetry() : false; }
 	bool supportsNEB()  const	{ return isSet() ? _ipo->supportsNEB()  : false; }
 	bool useReferences() const	{ return _useReferences; }
+	LocalPotential* local() const	{ return _local; }
+	const Word& referenceCache() const	{ return _referenceCache; }
 	
 	// Friends
 	friend class Reference;
@@ -191,9 +207,12 @@ inline void Potential::clear()
 	_references.clear();
 	_useReferences = false;
 	_unphysicalCutoff = -5;
+	_referenceCache.clear();
+	_settingsKey = 0;
 	if (_ipo)
 		delete _ipo;
 	_ipo = 0;
+	_local = 0;
 }
 
 
@@ -0,0 +1,854 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "multi.h"
+#include "potentialFit.h"
+#include "structureIO.h"
+#include "language.h"
+#include "output.h"
+#include "fileSystem.h"
+#include <cstdlib>
+#include <cmath>
+
+
+
+/**
+ * Set training set and settings from input
+ * @param input [in] Text to read
+ */
+void PotentialFit::set(const Text& input)
+{
+	for (int i = 0; i < input.length(); ++i)
+	{
+		
+		// Skip empty lines and comments
+		if ((!input[i].length()) || (Language::isComment(input[i][0])))
+			continue;
+		
+		// Found weights
+		if (input[i][0].equal("weights", false, 6))
+		{
+			if ((input[i].length() < 3) || (!Language::isNumber(input[i][1])) || \
+				(!Language::isNumber(input[i][2])))
+				readError(input[i]);
+			_energyWeight = atof(input[i][1].array());
+			_forceWeight = atof(input[i][2].array());
+			if ((input[i].length() > 3) && (!Language::isComment(input[i][3])))
+			{
+				if (!Language::isNumber(input[i][3]))
+					readError(input[i]);
+				_stressWeight = atof(input[i][3].array());
+			}
+		}
+		
+		// Found tolerance
+		else if (input[i][0].equal("tolerance", false, 3))
+		{
+			if ((input[i].length() < 2) || (!Language::isNumber(input[i][1])))
+				readError(input[i]);
+			_tolerance = atof(input[i][1].array());
+		}
+		
+		// Found structure
+		else if (input[i][0].equal("structure", false, 6))
+			addStructure(input[i]);
+		
+		// Unknown setting
+		else
+			readError(input[i]);
+	}
+}
+
+
+
+/**
+ * Add a training structure from a line of input
+ * @param line [in] Line that starts with the structure keyword
+ */
+void PotentialFit::addStructure(const OList<Word>& line)
+{
+	
+	// Line is too short
+	if (line.length() < 2)
+		readError(line);
+	
+	// Read structure
+	ISO iso = StructureIO::read(line[1]);
+	
+	// Loop over settings
+	int i, j;
+	bool hasEnergy = false;
+	double energy = 0;
+	double weight = 1;
+	OList<Vector3D> forces;
+	List<double> stress;
+	for (i = 2; i < line.length(); ++i)
+	{
+		
+		// Found comment
+		if (Language::isComment(line[i]))
+			break;
+		
+		// Found energy
+		if (line[i].equal("energy", false, 3))
+		{
+			if ((++i >= line.length()) || (!Language::isNumber(line[i])))
+				readError(line);
+			energy = atof(line[i].array());
+			hasEnergy = true;
+		}
+		
+		// Found forces
+		else if (line[i].equal("forces", false, 5))
+		{
+			if (++i >= line.length())
+				readError(line);
+			Text content = Read::text(line[i]);
+			for (j = 0; j < content.length(); ++j)
+			{
+				if ((!content[j].length()) || (Language::isComment(content[j][0])))
+					continue;
+				if ((content[j].length() < 3) || (!Language::isNumber(content[j][0])) || \
+					(!Language::isNumber(content[j][1])) || (!Language::isNumber(content[j][2])))
+					readError(content[j]);
+				forces.add();
+				forces.last().set(atof(content[j][0].array()), atof(content[j][1].array()), \
+					atof(content[j][2].array()));
+			}
+			if (forces.length() != iso.numAtoms())
+			{
+				Output::newline(ERROR);
+				Output::print("Number of forces in ");
+				Output::print(line[i]);
+				Output::print(" does not match the number of atoms in ");
+				Output::print(line[1]);
+				Output::quit();
+			}
+		}
+		
+		// Found stress
+		else if (line[i].equal("stress", false, 6))
+		{
+			stress.length(6);
+			for (j = 0; j < 6; ++j)
+			{
+				if ((++i >= line.length()) || (!Language::isNumber(line[i])))
+					readError(line);
+				stress[j] = atof(line[i].array());
+			}
+		}
+		
+		// Found weight
+		else if (line[i].equal("weight", false, 6))
+		{
+			if ((++i >= line.length()) || (!Language::isNumber(line[i])))
+				readError(line);
+			weight = atof(line[i].array());
+		}
+		
+		// Unknown setting
+		else
+			readError(line);
+	}
+	
+	// Energy was not set
+	if (!hasEnergy)
+		readError(line);
+	
+	// Save structure
+	add(iso, energy, (forces.length()) ? &forces : 0, (stress.length()) ? &stress : 0, weight);
+}
+
+
+
+/**
+ * Add a training structure
+ * @param iso [in] Structure
+ * @param energy [in] Total energy (eV)
+ * @param forces [in] Cartesian force on each atom by atom number (eV/Ang, optional)
+ * @param stress [in] Stress as xx yy zz yz xz xy (eV/Ang^3, optional)
+ * @param weight [in] Weight of structure in the fit
+ */
+void PotentialFit::add(const ISO& iso, double energy, const OList<Vector3D>* forces, const List<double>* stress, \
+	double weight)
+{
+	_structures += iso;
+	_energies += energy;
+	_forces.add();
+	if (forces)
+		_forces.last() = *forces;
+	_stresses.add();
+	if (stress)
+		_stresses.last() = *stress;
+	_weights += weight;
+}
+
+
+
+/**
+ * Remove all training structures
+ */
+void PotentialFit::clear()
+{
+	_structures.clear();
+	_energies.clear();
+	_forces.clear();
+	_stresses.clear();
+	_weights.clear();
+	_neighbors.clear();
+	_curParams.length(0);
+}
+
+
+
+/**
+ * Fit parameters of the pair potentials in a local potential
+ * @param potential [in/out] Potential to fit (fitted parameters are saved in the potential)
+ */
+void PotentialFit::fit(LocalPotential& potential)
+{
+	
+	// No training data
+	if (!_structures.length())
+	{
+		Output::newline(ERROR);
+		Output::print("No training structures were set for potential fit");
+		Output::quit();
+	}
+	
+	// Get potentials and contributions that are fixed
+	setPotentials(potential);
+	setBaseline(potential);
+	
+	// Output
+	Output::newline();
+	Output::print("Fitting ");
+	Output::print(_numParams);
+	Output::print(" parameter");
+	if (_numParams != 1)
+		Output::print("s");
+	Output::print(" of ");
+	Output::print(_pairs.length());
+	Output::print(" pair potential");
+	if (_pairs.length() != 1)
+		Output::print("s");
+	Output::print(" to ");
+	Output::print(_structures.length());
+	Output::print(" structure");
+	if (_structures.length() != 1)
+		Output::print("s");
+	Output::increase();
+	
+	// Set pairs in each structure and storage for residuals
+	setResiduals();
+	
+	// Initial parameters
+	int i, j;
+	Vector params(_numParams);
+	for (i = 0; i < _pairs.length(); ++i)
+	{
+		for (j = 0; j < _pairs[i]->numParameters(); ++j)
+			params[_paramStart[i] + j] = _pairs[i]->parameter(j);
+	}
+	
+	// Print initial errors
+	update(params);
+	Output::newline();
+	Output::print("Initial errors");
+	Output::increase();
+	printErrors();
+	Output::decrease();
+	
+	// Set data where each point is the index of a residual and its scaled target value
+	int k;
+	OList<List<double> > data(_scales.length());
+	for (i = 0; i < _structures.length(); ++i)
+	{
+		k = _residualStart[i];
+		data[k].length(2);
+		data[k][1] = _energies[i];
+		if (_forces[i].length())
+		{
+			for (j = 0; j < _forces[i].length(); ++j)
+			{
+				for (int m = 0; m < 3; ++m)
+				{
+					data[++k].length(2);
+					data[k][1] = _forces[i][j][m];
+				}
+			}
+		}
+		for (j = 0; j < _stresses[i].length(); ++j)
+		{
+			data[++k].length(2);
+			data[k][1] = _stresses[i][j];
+		}
+	}
+	for (i = 0; i < data.length(); ++i)
+	{
+		data[i][0] = i;
+		data[i][1] *= _scales[i];
+	}
+	
+	// Run fit
+	Functor<PotentialFit> fun(this, &PotentialFit::modelValue);
+	VectorFunctor<PotentialFit> deriv(this, &PotentialFit::modelDerivatives);
+	params = Fit::LM(data, fun, deriv, params, _tolerance);
+	update(params);
+	
+	// Print final errors
+	Output::newline();
+	Output::print("Final errors");
+	Output::increase();
+	printErrors();
+	Output::decrease();
+	
+	// Print fitted potentials
+	Output::newline();
+	Output::print("Fitted potentials");
+	Output::increase();
+	for (i = 0; i < _pairs.length(); ++i)
+		_pairs[i]->write();
+	Output::decrease();
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/**
+ * Write fitted potentials in the format of an input file
+ * @param file [in] File to write to (empty or stdout to write to the current stream)
+ */
+void PotentialFit::write(const Word& file) const
+{
+	
+	// Setup output
+	int origStream = Output::streamID();
+	PrintMethod origMethod = Output::method();
+	if ((file.length() > 0) && (file != "stdout"))
+		Output::setStream(Output::addStream(file));
+	Output::method(STANDARD);
+	
+	// Write potentials
+	for (int i = 0; i < _pairs.length(); ++i)
+		_pairs[i]->write();
+	
+	// Reset output
+	if ((file.length() > 0) && (file != "stdout"))
+		Output::removeStream(Output::streamID());
+	Output::setStream(origStream);
+	Output::method(origMethod);
+}
+
+
+
+/**
+ * Save the pair potentials that have parameters to fit
+ * @param potential [in] Local potential
+ */
+void PotentialFit::setPotentials(LocalPotential& potential)
+{
+	_numParams = 0;
+	_pairs.length(0);
+	_paramStart.length(0);
+	PairPotential* pair;
+	for (int i = 0; i < potential.numPotentials(); ++i)
+	{
+		pair = dynamic_cast<PairPotential*>(potential.potential(i));
+		if ((pair) && (pair->numParameters()))
+		{
+			_pairs += pair;
+			_paramStart += _numParams;
+			_numParams += pair->numParameters();
+		}
+	}
+	if (!_pairs.length())
+	{
+		Output::newline(ERROR);
+		Output::print("Potential does not contain any pair potentials with parameters that can be fit");
+		Output::quit();
+	}
+	_curParams.length(0);
+}
+
+
+
+/**
+ * Get the energy, forces and stress of each training structure from the potentials that are not fit
+ * @param potential [in] Local potential
+ */
+void PotentialFit::setBaseline(const LocalPotential& potential)
+{
+	
+	// Loop over structures
+	int i, j, k, m;
+	bool isFit;
+	double energy;
+	double plus, minus;
+	double step = 1e-5;
+	ISO strained;
+	OList<Vector3D> forces;
+	_baseEnergies.length(_structures.length());
+	_baseForces.length(_structures.length());
+	_baseStresses.length(_structures.length());
+	for (i = 0; i < _structures.length(); ++i)
+	{
+		
+		// Clear values
+		_baseEnergies[i] = 0;
+		_baseForces[i].length(_structures[i].numAtoms());
+		_baseForces[i].fill(0.0);
+		_baseStresses[i].length(6);
+		_baseStresses[i].fill(0);
+		
+		// Loop over potentials that are not fit
+		for (j = 0; j < potential.numPotentials(); ++j)
+		{
+			isFit = false;
+			for (k = 0; k < _pairs.length(); ++k)
+			{
+				if (_pairs[k] == potential.potential(j))
+					isFit = true;
+			}
+			if (isFit)
+				continue;
+			
+			// Energy and forces
+			energy = 0;
+			forces.length(_structures[i].numAtoms());
+			forces.fill(0.0);
+			potential.potential(j)->evaluate(_structures[i], &energy, &forces);
+			_baseEnergies[i] += energy;
+			_structures[i].basis().toCartesian(forces);
+			for (k = 0; k < forces.length(); ++k)
+				_baseForces[i][k] += forces[k];
+			
+			// Stress from central differences of the energy with strain
+			if ((_stresses[i].length()) && (_stressWeight > 0))
+			{
+				for (m = 0; m < 6; ++m)
+				{
+					plus = minus = 0;
+					strained = _structures[i];
+					strain(strained, m, step);
+					potential.potential(j)->evaluate(strained, &plus, 0);
+					strained = _structures[i];
+					strain(strained, m, -step);
+					potential.potential(j)->evaluate(strained, &minus, 0);
+					_baseStresses[i][m] += (plus - minus) / (2 * step * _structures[i].basis().volume());
+				}
+			}
+		}
+	}
+}
+
+
+
+/**
+ * Find pairs in each structure and set the layout of the residuals
+ */
+void PotentialFit::setResiduals()
+{
+	
+	// Get the largest cutoff
+	int i;
+	double maxCutoff = 0;
+	for (i = 0; i < _pairs.length(); ++i)
+		maxCutoff = Num<double>::max(maxCutoff, _pairs[i]->cutoff());
+	
+	// Build neighbor lists
+	_neighbors.length(_structures.length());
+	for (i = 0; i < _structures.length(); ++i)
+		_neighbors[i].set(_structures[i], maxCutoff);
+	
+	// Set residuals of each structure (energy per atom, forces, stress)
+	int j;
+	int numAtoms;
+	int numResiduals = 0;
+	_residualStart.length(_structures.length() + 1);
+	_scales.length(0);
+	for (i = 0; i < _structures.length(); ++i)
+	{
+		numAtoms = _structures[i].numAtoms();
+		_residualStart[i] = numResiduals;
+		_scales += sqrt(_weights[i] * _energyWeight) / numAtoms;
+		++numResiduals;
+		if (_forces[i].length())
+		{
+			for (j = 0; j < 3 * numAtoms; ++j)
+				_scales += sqrt(_weights[i] * _forceWeight / (3 * numAtoms));
+			numResiduals += 3 * numAtoms;
+		}
+		for (j = 0; j < _stresses[i].length(); ++j)
+			_scales += sqrt(_weights[i] * _stressWeight / 6);
+		numResiduals += _stresses[i].length();
+	}
+	_residualStart[_structures.length()] = numResiduals;
+	
+	// Allocate storage
+	_model.length(numResiduals);
+	_jacobian.length(numResiduals * _numParams);
+}
+
+
+
+/**
+ * Set parameters and evaluate all training structures if the parameters changed
+ * @param params [in] Parameters of all potentials being fit
+ */
+void PotentialFit::update(const Vector& params)
+{
+	
+	// Parameters did not change
+	int i, j;
+	if (_curParams.length() == params.length())
+	{
+		for (i = 0; i < params.length(); ++i)
+		{
+			if (_curParams[i] != params[i])
+				break;
+		}
+		if (i == params.length())
+			return;
+	}
+	_curParams = params;
+	
+	// Set parameters
+	for (i = 0; i < _pairs.length(); ++i)
+	{
+		for (j = 0; j < _pairs[i]->numParameters(); ++j)
+			_pairs[i]->parameter(j, params[_paramStart[i] + j]);
+	}
+	
+	// Evaluate structures on current processor
+	int count = 0;
+	for (i = 0; i < _structures.length(); ++i)
+	{
+		if ((++count + Multi::rank()) % Multi::worldSize() == 0)
+			evaluate(i, &_model[_residualStart[i]], &_jacobian[_residualStart[i] * _numParams]);
+	}
+	
+	// Send results between processors
+	if (Multi::worldSize() > 1)
+	{
+		int root;
+		int num;
+		for (i = 0; i < _structures.length(); ++i)
+		{
+			root = (Multi::worldSize() - (i + 1) % Multi::worldSize()) % Multi::worldSize();
+			num = _residualStart[i + 1] - _residualStart[i];
+			Multi::broadcast(&_model[_residualStart[i]], num, root);
+			Multi::broadcast(&_jacobian[_residualStart[i] * _numParams], num * _numParams, root);
+		}
+	}
+}
+
+
+
+/**
+ * Evaluate a training structure with the current parameters
+ * @param index [in] Index of the structure
+ * @param values [out] Energy, cartesian forces (if used) and stress (if used)
+ * @param derivatives [out] Derivative of each value with respect to each parameter
+ */
+void PotentialFit::evaluate(int index, double* values, double* derivatives)
+{
+	
+	// Clear values
+	int i, j, k, m;
+	const ISO& iso = _structures[index];
+	const NeighborList& neighbors = _neighbors[index];
+	int numAtoms = iso.numAtoms();
+	int numValues = _residualStart[index + 1] - _residualStart[index];
+	int stressStart = numValues - _stresses[index].length();
+	bool useForces = (_forces[index].length() > 0);
+	bool useStress = (_stresses[index].length() > 0);
+	for (i = 0; i < numValues; ++i)
+		values[i] = 0;
+	for (i = 0; i < numValues * _numParams; ++i)
+		derivatives[i] = 0;
+	
+	// Add contributions of potentials that are not fit
+	values[0] = _baseEnergies[index];
+	if (useForces)
+	{
+		for (i = 0; i < numAtoms; ++i)
+		{
+			for (j = 0; j < 3; ++j)
+				values[1 + 3*i + j] = _baseForces[index][i][j];
+		}
+	}
+	if (useStress)
+	{
+		for (i = 0; i < 6; ++i)
+			values[stressStart + i] = _baseStresses[index][i];
+	}
+	
+	// Loop over potentials being fit
+	int first;
+	int numParams;
+	int dir;
+	int axes[6][2] = {{0, 0}, {1, 1}, {2, 2}, {1, 2}, {0, 2}, {0, 1}};
+	double distance;
+	double energy;
+	double force;
+	double factor;
+	double volume = iso.basis().volume();
+	double energyDerivs[3];
+	double forceDerivs[3];
+	Vector3D unit;
+	for (i = 0; i < _pairs.length(); ++i)
+	{
+		
+		// Loop over pairs of atoms
+		first = _paramStart[i];
+		numParams = _pairs[i]->numParameters();
+		for (j = 0; j < numAtoms; ++j)
+		{
+			for (k = 0; k < neighbors.numNeighbors(j); ++k)
+			{
+				
+				// Skip if out of range or elements do not interact
+				distance = neighbors.distance(j, k);
+				if (distance > _pairs[i]->cutoff())
+					continue;
+				if (!_pairs[i]->interacts(neighbors.atom(j)->element(), neighbors.neighbor(j, k)->element()))
+					continue;
+				
+				// Get values and derivatives
+				energy = _pairs[i]->energyAt(distance);
+				force = _pairs[i]->forceAt(distance);
+				_pairs[i]->parameterDerivatives(distance, energyDerivs, forceDerivs);
+				
+				// Add energy (each pair is found from both atoms)
+				values[0] += energy / 2;
+				for (m = 0; m < numParams; ++m)
+					derivatives[first + m] += energyDerivs[m] / 2;
+				
+				// Add force on atom (positive force pushes atom away from neighbor)
+				unit = neighbors.cartVector(j, k);
+				unit /= distance;
+				if (useForces)
+				{
+					for (dir = 0; dir < 3; ++dir)
+					{
+						values[1 + 3*j + dir] -= force * unit[dir];
+						for (m = 0; m < numParams; ++m)
+							derivatives[(1 + 3*j + dir) * _numParams + first + m] -= \
+								forceDerivs[m] * unit[dir];
+					}
+				}
+				
+				// Add stress
+				if (useStress)
+				{
+					for (dir = 0; dir < 6; ++dir)
+					{
+						factor = unit[axes[dir][0]] * unit[axes[dir][1]] * distance / (2 * volume);
+						values[stressStart + dir] -= force * factor;
+						for (m = 0; m < numParams; ++m)
+							derivatives[(stressStart + dir) * _numParams + first + m] -= forceDerivs[m] * factor;
+					}
+				}
+			}
+		}
+		
+		// Get the number of atoms of each element
+		int numOne = 0;
+		int numTwo = 0;
+		for (j = 0; j < iso.atoms().length(); ++j)
+		{
+			if (iso.atoms()[j][0].element() == _pairs[i]->elementOne())
+				numOne = iso.atoms()[j].length();
+			if (iso.atoms()[j][0].element() == _pairs[i]->elementTwo())
+				numTwo = iso.atoms()[j].length();
+		}
+		if (_pairs[i]->elementOne() == _pairs[i]->elementTwo())
+			numTwo = 0;
+		
+		// Shift energy to zero at the cutoff
+		if ((_pairs[i]->shift()) && (!_pairs[i]->addTail()))
+		{
+			_pairs[i]->parameterDerivatives(_pairs[i]->cutoff(), energyDerivs, forceDerivs);
+			values[0] -= (numOne + numTwo) * _pairs[i]->energyAt(_pairs[i]->cutoff()) / 2;
+			for (m = 0; m < numParams; ++m)
+				derivatives[first + m] -= (numOne + numTwo) * energyDerivs[m] / 2;
+		}
+		
+		// Add tail (derivatives by central differences)
+		if (_pairs[i]->addTail())
+		{
+			values[0] += numOne * _pairs[i]->tailEnergy(iso, _pairs[i]->elementTwo());
+			if (numTwo)
+				values[0] += numTwo * _pairs[i]->tailEnergy(iso, _pairs[i]->elementOne());
+			double orig, step, plus, minus;
+			for (m = 0; m < numParams; ++m)
+			{
+				orig = _pairs[i]->parameter(m);
+				step = 1e-6 * Num<double>::max(Num<double>::abs(orig), 1e-3);
+				_pairs[i]->parameter(m, orig + step);
+				plus = numOne * _pairs[i]->tailEnergy(iso, _pairs[i]->elementTwo());
+				if (numTwo)
+					plus += numTwo * _pairs[i]->tailEnergy(iso, _pairs[i]->elementOne());
+				_pairs[i]->parameter(m, orig - step);
+				minus = numOne * _pairs[i]->tailEnergy(iso, _pairs[i]->elementTwo());
+				if (numTwo)
+					minus += numTwo * _pairs[i]->tailEnergy(iso, _pairs[i]->elementOne());
+				_pairs[i]->parameter(m, orig);
+				derivatives[first + m] += (plus - minus) / (2 * step);
+			}
+		}
+	}
+}
+
+
+
+/**
+ * Print root-mean-square errors over the training set
+ */
+void PotentialFit::printErrors() const
+{
+	
+	// Loop over structures
+	int i, j;
+	int numForces = 0;
+	int numStresses = 0;
+	double diff;
+	double energyError = 0;
+	double forceError = 0;
+	double stressError = 0;
+	for (i = 0; i < _structures.length(); ++i)
+	{
+		diff = (_model[_residualStart[i]] - _energies[i]) / _structures[i].numAtoms();
+		energyError += diff * diff;
+		for (j = 0; j < _forces[i].length(); ++j)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				diff = _model[_residualStart[i] + 1 + 3*j + k] - _forces[i][j][k];
+				forceError += diff * diff;
+			}
+		}
+		numForces += 3 * _forces[i].length();
+		for (j = 0; j < _stresses[i].length(); ++j)
+		{
+			diff = _model[_residualStart[i + 1] - _stresses[i].length() + j] - _stresses[i][j];
+			stressError += diff * diff;
+		}
+		numStresses += _stresses[i].length();
+	}
+	
+	// Print errors
+	Output::newline();
+	Output::print("Energy RMS error: ");
+	Output::print(1000 * sqrt(energyError / _structures.length()), 4);
+	Output::print(" meV/atom");
+	if (numForces)
+	{
+		Output::newline();
+		Output::print("Force RMS error: ");
+		Output::print(sqrt(forceError / numForces), 6);
+		Output::print(" eV/Ang");
+	}
+	if (numStresses)
+	{
+		Output::newline();
+		Output::print("Stress RMS error: ");
+		Output::print(sqrt(stressError / numStresses), 8);
+		Output::print(" eV/Ang^3");
+	}
+}
+
+
+
+/**
+ * Scaled value of a residual for Fit::LM
+ * @param params [in] Parameters of all potentials being fit
+ * @param index [in] Index of the residual
+ */
+double PotentialFit::modelValue(const Vector& params, double index)
+{
+	update(params);
+	int residual = (int) index;
+	return _scales[residual] * _model[residual];
+}
+
+
+
+/**
+ * Scaled derivatives of a residual for Fit::LM
+ * @param params [in] Parameters of all potentials being fit
+ * @param index [in] Index of the residual
+ */
+Vector PotentialFit::modelDerivatives(const Vector& params, double index)
+{
+	update(params);
+	int residual = (int) index;
+	Vector res(_numParams);
+	for (int i = 0; i < _numParams; ++i)
+		res[i] = _scales[residual] * _jacobian[residual * _numParams + i];
+	return res;
+}
+
+
+
+/**
+ * Apply a small strain to a structure with fixed fractional coordinates
+ * @param iso [in/out] Structure to strain
+ * @param component [in] Component of strain (xx yy zz yz xz xy)
+ * @param amount [in] Size of strain (engineering strain for shear components)
+ */
+void PotentialFit::strain(ISO& iso, int component, double amount)
+{
+	int axes[6][2] = {{0, 0}, {1, 1}, {2, 2}, {1, 2}, {0, 2}, {0, 1}};
+	Matrix3D deformation = Matrix3D::identity();
+	if (component < 3)
+		deformation(component, component) += amount;
+	else
+	{
+		deformation(axes[component][0], axes[component][1]) += amount / 2;
+		deformation(axes[component][1], axes[component][0]) += amount / 2;
+	}
+	iso.basis(iso.basis().vectors() * deformation, false);
+}
+
+
+
+/**
+ * Print error in potential fit input and quit
+ * @param line [in] Line with the error
+ */
+void PotentialFit::readError(const OList<Word>& line)
+{
+	Output::newline(ERROR);
+	Output::print("Did not recognize potential fit setting on line \"");
+	for (int i = 0; i < line.length(); ++i)
+	{
+		Output::print(line[i]);
+		if (i != line.length() - 1)
+			Output::print(" ");
+	}
+	Output::print("\"");
+	Output::quit();
+}
@@ -0,0 +1,152 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef POTENTIALFIT_H
+#define POTENTIALFIT_H
+
+
+
+#include "locPotential.h"
+#include "pairPotential.h"
+#include "iso.h"
+#include "text.h"
+#include "num.h"
+#include "list.h"
+
+
+
+/**
+ * Fit parameters of pair potentials to a training set of energies, forces and stresses
+ * 
+ * Minimizes the weighted sum of squared errors
+ * 
+ * L = sum_s w_s [ w_E (dE_s / N_s)^2 + w_F sum_i |dF_i|^2 / (3 N_s) + w_S sum_k dS_k^2 / 6 ]
+ * 
+ * with the Levenberg-Marquardt algorithm in Fit::LM. Derivatives with respect to the parameters are
+ *  analytic for the pair terms. Every pair potential in the local potential that has fitting
+ *  parameters is fit, and all other potentials are held fixed. Pairs within the largest cutoff are
+ *  found once for each training structure, and structures are split between processors on each
+ *  evaluation. Stresses are dE/dstrain divided by the volume (eV/Ang^3) in the order xx yy zz yz xz xy,
+ *  and exclude the tail correction.
+ * 
+ * Input format:
+ *	weights <energy> <force> [stress]
+ *	tolerance <value>
+ *	structure <file> energy <total energy> [forces <file>] [stress <6 values>] [weight <value>]
+ * 
+ * A forces file contains the three cartesian components of the force on each atom in eV/Ang, with one
+ *  line per atom in the order of the structure file.
+ */
+class PotentialFit
+{
+	
+	// Settings
+	double _energyWeight;
+	double _forceWeight;
+	double _stressWeight;
+	double _tolerance;
+	
+	// Training set
+	OList<ISO> _structures;
+	List<double> _energies;
+	OList<OList<Vector3D> > _forces;
+	OList<List<double> > _stresses;
+	List<double> _weights;
+	
+	// Contributions of potentials that are not fit
+	List<double> _baseEnergies;
+	OList<OList<Vector3D> > _baseForces;
+	OList<List<double> > _baseStresses;
+	
+	// Potentials being fit
+	List<PairPotential*> _pairs;
+	List<int> _paramStart;
+	int _numParams;
+	
+	// Residuals of the current parameters
+	OList<NeighborList> _neighbors;
+	List<int> _residualStart;
+	List<double> _scales;
+	List<double> _model;
+	List<double> _jacobian;
+	Vector _curParams;
+	
+	// Functions
+	void addStructure(const OList<Word>& line);
+	void setPotentials(LocalPotential& potential);
+	void setBaseline(const LocalPotential& potential);
+	void setResiduals();
+	void update(const Vector& params);
+	void evaluate(int index, double* values, double* derivatives);
+	void printErrors() const;
+	
+	// Functions for Fit::LM
+	double modelValue(const Vector& params, double index);
+	Vector modelDerivatives(const Vector& params, double index);
+	
+	// Helper functions
+	static void strain(ISO& iso, int component, double amount);
+	static void readError(const OList<Word>& line);
+	
+public:
+	
+	// Constructor
+	PotentialFit();
+	
+	// Setup
+	void set(const Text& input);
+	void add(const ISO& iso, double energy, const OList<Vector3D>* forces = 0, const List<double>* stress = 0, \
+		double weight = 1);
+	void clear();
+	
+	// Settings
+	void weights(double energy, double force, double stress)
+		{ _energyWeight = energy; _forceWeight = force; _stressWeight = stress; }
+	void tolerance(double input)	{ _tolerance = input; }
+	
+	// Run fit
+	void fit(LocalPotential& potential);
+	
+	// Write fitted potentials in input format
+	void write(const Word& file) const;
+	
+	// Access functions
+	int numStructures() const		{ return _structures.length(); }
+};
+
+
+
+/**
+ * Constructor
+ */
+inline PotentialFit::PotentialFit()
+{
+	_energyWeight = 1;
+	_forceWeight = 0.1;
+	_stressWeight = 0;
+	_tolerance = 1e-6;
+	_numParams = 0;
+}
+
+
+
+#endif
@@ -48,6 +48,16 @@ void Random::set(RandomPackage package, unsigned long int seed)
 		return;
 	}
 	
+	// Set counter-based package
+	if (package == RP_PHILOX)
+	{
+		delete _generator;
+		_generator = new Philox;
+		_generator->seed(seed);
+		_normalSpareSet = false;
+		return;
+	}
+	
 	// Unknown package
 	Output::newline(ERROR);
 	Output::print("Attempting to set random number generator with unknown package");
@@ -56,6 +66,158 @@ void Random::set(RandomPackage package, unsigned long int seed)
 
 
 
+/* void Random::set(RandomPackage package, unsigned long int seed, unsigned long int stream)
+ *
+ * Set the random number generator and the stream that it draws from
+ */
+
+void Random::set(RandomPackage package, unsigned long int seed, unsigned long int stream)
+{
+	set(package, seed);
+	_generator->stream(stream);
+}
+
+
+
+/* void Random::fillDecimal(List<double>& values, double min, double max) const
+ *
+ * Fill list with values on uniform distribution
+ */
+
+void Random::fillDecimal(List<double>& values, double min, double max) const
+{
+	if (!values.length())
+		return;
+	_generator->fill(&values[0], values.length());
+	double range = max - min;
+	for (int i = 0; i < values.length(); ++i)
+		values[i] = min + values[i] * range;
+}
+
+
+
+/* void Random::fillInteger(List<int>& values, int min, int max) const
+ *
+ * Fill list with integers on uniform distribution over [min, max]
+ */
+
+void Random::fillInteger(List<int>& values, int min, int max) const
+{
+	if (!values.length())
+		return;
+	List<double> uniform(values.length());
+	_generator->fill(&uniform[0], uniform.length());
+	double range = max - min + 1;
+	for (int i = 0; i < values.length(); ++i)
+		values[i] = min + (int)(uniform[i] * range);
+}
+
+
+
+/* void Random::fillNormal(List<double>& values, double mean, double standardDeviation) const
+ *
+ * Fill list with values on normal distribution using Box-Muller transform of pairs of uniform values
+ */
+
+void Random::fillNormal(List<double>& values, double mean, double standardDeviation) const
+{
+	
+	// Get uniform values, using an extra value if length is odd
+	if (!values.length())
+		return;
+	int numPairs = (values.length() + 1) / 2;
+	List<double> uniform(2 * numPairs);
+	_generator->fill(&uniform[0], uniform.length());
+	
+	// Transform pairs
+	int i;
+	double mag;
+	double angle;
+	for (i = 0; i < numPairs; ++i)
+	{
+		mag = standardDeviation * sqrt(-2 * log(1 - uniform[2*i]));
+		angle = 2 * Constants::pi * uniform[2*i + 1];
+		values[2*i] = mean + mag * cos(angle);
+		if (2*i + 1 < values.length())
+			values[2*i + 1] = mean + mag * sin(angle);
+	}
+}
+
+
+
+/* void Random::fillInCell(OList<Vector3D>& points) const
+ *
+ * Fill list with fractional coordinates uniform in the unit cell
+ */
+
+void Random::fillInCell(OList<Vector3D>& points) const
+{
+	if (!points.length())
+		return;
+	List<double> uniform(3 * points.length());
+	_generator->fill(&uniform[0], uniform.length());
+	for (int i = 0; i < points.length(); ++i)
+		points[i].set(uniform[3*i], uniform[3*i + 1], uniform[3*i + 2]);
+}
+
+
+
+/* void Random::fillInSphere(OList<Vector3D>& points, double radius) const
+ *
+ * Fill list with points uniform in a sphere centered at the origin
+ */
+
+void Random::fillInSphere(OList<Vector3D>& points, double radius) const
+{
+	
+	// Get directions on unit sphere
+	fillDirections(points, 1, 1);
+	
+	// Scale so that density is uniform
+	if (!points.length())
+		return;
+	List<double> uniform(points.length());
+	_generator->fill(&uniform[0], uniform.length());
+	for (int i = 0; i < points.length(); ++i)
+		points[i] *= radius * pow(uniform[i], 1.0/3.0);
+}
+
+
+
+/* void Random::fillDirections(OList<Vector3D>& points, double minMagnitude, double maxMagnitude) const
+ *
+ * Fill list with vectors in uniformly random directions with magnitudes uniform on [minMagnitude, maxMagnitude]
+ */
+
+void Random::fillDirections(OList<Vector3D>& points, double minMagnitude, double maxMagnitude) const
+{
+	
+	// Get normal values for directions and uniform values for magnitudes
+	if (!points.length())
+		return;
+	List<double> normal(3 * points.length());
+	fillNormal(normal, 0, 1);
+	List<double> magnitude(points.length());
+	if (minMagnitude == maxMagnitude)
+		magnitude.fill(minMagnitude);
+	else
+		fillDecimal(magnitude, minMagnitude, maxMagnitude);
+	
+	// Save vectors
+	double norm;
+	for (int i = 0; i < points.length(); ++i)
+	{
+		points[i].set(normal[3*i], normal[3*i + 1], normal[3*i + 2]);
+		norm = points[i].magnitude();
+		if (norm == 0)
+			points[i].set(0, 0, magnitude[i]);
+		else
+			points[i] *= magnitude[i] / norm;
+	}
+}
+
+
+
 /* int Random::integerOnNormal(int min, int max, double mean, double standardDeviation) const
  *
  * Generate a random integer on normal distribution
@@ -133,6 +295,225 @@ double Random::decimalOnNormal(double mean, double standardDeviation, double ran
 
 
 
+/* void Random::Generator::stream(unsigned long int id)
+ *
+ * Generators without independent streams
+ */
+
+void Random::Generator::stream(unsigned long int id)
+{
+	if (id == 0)
+		return;
+	Output::newline(ERROR);
+	Output::print("Random number generator does not support independent streams");
+	Output::quit();
+}
+
+
+
+/* void Random::Generator::skip(unsigned long int numValues) const
+ *
+ * Skip values by drawing them for generators without random access
+ */
+
+void Random::Generator::skip(unsigned long int numValues) const
+{
+	for (unsigned long int i = 0; i < numValues; ++i)
+		decimal(0, 1);
+}
+
+
+
+/* void Random::Generator::fill(double* values, int count) const
+ *
+ * Fill array with values on [0, 1)
+ */
+
+void Random::Generator::fill(double* values, int count) const
+{
+	for (int i = 0; i < count; ++i)
+		values[i] = decimal(0, 1);
+}
+
+
+
+/* void Random::Mersenne::fill(double* values, int count) const
+ *
+ * Fill array with values on [0, 1) without a virtual call for each value
+ */
+
+void Random::Mersenne::fill(double* values, int count) const
+{
+	for (int i = 0; i < count; ++i)
+		values[i] = _generator.uniform(0, 1);
+}
+
+
+
+/* void Random::Philox::seed(unsigned long int seed)
+ *
+ * Set key and restart stream
+ */
+
+void Random::Philox::seed(unsigned long int seed)
+{
+	uint64_t value = seed;
+	_key[0] = (uint32_t)value;
+	_key[1] = (uint32_t)(value >> 32);
+	_position = 0;
+	_blockIndex = (uint64_t)-1;
+}
+
+
+
+/* void Random::Philox::stream(unsigned long int id)
+ *
+ * Set stream and move to its start
+ */
+
+void Random::Philox::stream(unsigned long int id)
+{
+	uint64_t value = id;
+	_stream[0] = (uint32_t)value;
+	_stream[1] = (uint32_t)(value >> 32);
+	_position = 0;
+	_blockIndex = (uint64_t)-1;
+}
+
+
+
+/* void Random::Philox::generate(uint64_t blockIndex) const
+ *
+ * Generate the four words for a counter value
+ */
+
+void Random::Philox::generate(uint64_t blockIndex) const
+{
+	
+	// Set counter and key
+	uint32_t counter[4] = {(uint32_t)blockIndex, (uint32_t)(blockIndex >> 32), _stream[0], _stream[1]};
+	uint32_t key[2] = {_key[0], _key[1]};
+	
+	// Apply rounds
+	uint64_t prod0;
+	uint64_t prod1;
+	for (int i = 0; i < 10; ++i)
+	{
+		if (i)
+		{
+			key[0] += 0x9E3779B9U;
+			key[1] += 0xBB67AE85U;
+		}
+		prod0 = (uint64_t)0xD2511F53U * counter[0];
+		prod1 = (uint64_t)0xCD9E8D57U * counter[2];
+		counter[0] = (uint32_t)(prod1 >> 32) ^ counter[1] ^ key[0];
+		counter[1] = (uint32_t)prod1;
+		counter[2] = (uint32_t)(prod0 >> 32) ^ counter[3] ^ key[1];
+		counter[3] = (uint32_t)prod0;
+	}
+	
+	// Save result
+	_blockIndex = blockIndex;
+	for (int i = 0; i < 4; ++i)
+		_block[i] = counter[i];
+}
+
+
+
+/* uint32_t Random::Philox::word() const
+ *
+ * Return next 32-bit word in sequence
+ */
+
+uint32_t Random::Philox::word() const
+{
+	if (_blockIndex != _position / 4)
+		generate(_position / 4);
+	return _block[_position++ % 4];
+}
+
+
+
+/* double Random::Philox::unit() const
+ *
+ * Return value on [0, 1) with 53 bits from the next two words
+ */
+
+double Random::Philox::unit() const
+{
+	uint32_t high = word() >> 5;
+	uint32_t low = word() >> 6;
+	return (high * 67108864.0 + low) / 9007199254740992.0;
+}
+
+
+
+/* void Random::Philox::fill(double* values, int count) const
+ *
+ * Fill array with values on [0, 1) generating two values from each block
+ */
+
+void Random::Philox::fill(double* values, int count) const
+{
+	
+	// Finish current block
+	int i = 0;
+	while ((i < count) && (_position % 4))
+		values[i++] = unit();
+	
+	// Fill from whole blocks
+	uint64_t curBlock = _position / 4;
+	for (; i + 1 < count; i += 2, ++curBlock)
+	{
+		generate(curBlock);
+		values[i] = ((_block[0] >> 5) * 67108864.0 + (_block[1] >> 6)) / 9007199254740992.0;
+		values[i+1] = ((_block[2] >> 5) * 67108864.0 + (_block[3] >> 6)) / 9007199254740992.0;
+	}
+	_position = 4*curBlock;
+	
+	// Set last value
+	if (i < count)
+		values[i] = unit();
+}
+
+
+
+/* RandomPackage Random::package(const Word& input)
+ *
+ * Convert word to random number package
+ */
+
+RandomPackage Random::package(const Word& input)
+{
+	if (input.equal("mersenne", false, 4))
+		return RP_MERSENNE;
+	if (input.equal("philox", false, 4))
+		return RP_PHILOX;
+	return RP_UNKNOWN;
+}
+
+
+
+/* Word Random::package(RandomPackage input)
+ *
+ * Convert random number package to word
+ */
+
+Word Random::package(RandomPackage input)
+{
+	switch (input)
+	{
+		case RP_MERSENNE:
+			return Word("Mersenne");
+		case RP_PHILOX:
+			return Word("Philox");
+		default:
+			return Word("Unknown");
+	}
+}
+
+
+
 /* unsigned long int Random::readTSC(bool uniqueOnEachProcessor)
  *
  * Return the value of the time stamp counter
@@ -27,11 +27,15 @@
 
 #include "mtwist.h"
 #include "randistrs.h"
+#include "list.h"
+#include "num.h"
+#include "text.h"
+#include <stdint.h>
 
 
 
 // Random number generator packages
-enum RandomPackage {RP_UNKNOWN, RP_MERSENNE};
+enum RandomPackage {RP_UNKNOWN, RP_MERSENNE, RP_PHILOX};
 
 
 
@@ -45,8 +49,11 @@ class Random
 	public:
 		virtual ~Generator() {}
 		virtual void seed(unsigned long int seed) = 0;
+		virtual void stream(unsigned long int id);
+		virtual void skip(unsigned long int numValues) const;
 		virtual int integer(int min, int max) const = 0;
 		virtual double decimal(double min, double max) const = 0;
+		virtual void fill(double* values, int count) const;
 	};
 	
 	// Mersenne generator
@@ -57,6 +64,29 @@ class Random
 		void seed(unsigned long int seed)				{ _generator.seed32(seed); }
 		int integer(int min, int max) const				{ return _generator.iuniform(min, max+1); }
 		double decimal(double min, double max) const	{ return _generator.uniform(min, max); }
+		void fill(double* values, int count) const;
+	};
+	
+	// Counter-based Philox4x32-10 generator (Salmon et al., SC11), the key is set by the seed and half of the
+	// counter by the stream id so that each (seed, stream) pair is an independent sequence
+	class Philox : public Generator
+	{
+		uint32_t _key[2];
+		uint32_t _stream[2];
+		mutable uint64_t _position;
+		mutable uint64_t _blockIndex;
+		mutable uint32_t _block[4];
+		void generate(uint64_t blockIndex) const;
+		uint32_t word() const;
+		double unit() const;
+	public:
+		Philox()										{ _key[0] = _key[1] = 0; stream(0); }
+		void seed(unsigned long int seed);
+		void stream(unsigned long int id);
+		void skip(unsigned long int numValues) const	{ _position += 2*numValues; }
+		int integer(int min, int max) const				{ return min + (int)(unit() * (max - min + 1)); }
+		double decimal(double min, double max) const	{ return min + unit() * (max - min); }
+		void fill(double* values, int count) const;
 	};
 	
 	// Variable to store generator
@@ -73,7 +103,12 @@ public:
 	// Setup functions
 	void set(RandomPackage package, unsigned long int seed);
 	void set(RandomPackage package)		{ set(package, readTSC()); }
+	void set(RandomPackage package, unsigned long int seed, unsigned long int stream);
 	void seed(unsigned long int seed)	{ _generator->seed(seed); }
+	void stream(unsigned long int id)	{ _generator->stream(id); }
+	
+	// Move ahead in the sequence by a number of values
+	void skip(unsigned long int numValues) const	{ _generator->skip(numValues); }
     
 	// Uniform distributions
 	int integer(int min, int max) const				{ return _generator->integer(min, max); }
@@ -82,9 +117,21 @@ public:
 	// Non-uniform distributions
 	int integerOnNormal(int min, int max, double mean, double standardDeviation) const;
 	double decimalOnNormal(double mean, double standardDeviation, double range) const;
+	
+	// Fill list with values (does not use or change the spare normal value)
+	void fillDecimal(List<double>& values, double min, double max) const;
+	void fillInteger(List<int>& values, int min, int max) const;
+	void fillNormal(List<double>& values, double mean, double standardDeviation) const;
+	
+	// Fill list with points (does not use or change the spare normal value)
+	void fillInCell(OList<Vector3D>& points) const;
+	void fillInSphere(OList<Vector3D>& points, double radius) const;
+	void fillDirections(OList<Vector3D>& points, double minMagnitude, double maxMagnitude) const;
     
 	// Static member functions
 	static unsigned long int readTSC(bool uniqueOnEachProcessor = false);
+	static RandomPackage package(const Word& input);
+	static Word package(RandomPackage input);
 };
 
 
@@ -122,11 +122,22 @@ void RandomStructure::perturbAtoms(ISO& iso, double min, double max, Random& ran
 	Output::print(" Ang");
 	Output::increase();
 	
+	// Generate displacements for all atoms that are not fixed
+	int i, j;
+	int numMoved = 0;
+	for (i = 0; i < iso.atoms().length(); ++i)
+	{
+		for (j = 0; j < iso.atoms()[i].length(); ++j)
+		{
+			if (!iso.atoms()[i][j].anyFixed())
+				++numMoved;
+		}
+	}
+	OList<Vector3D> displacements(numMoved);
+	random.fillDirections(displacements, min, max);
+	
 	// Loop over atoms
-	int i, j, k;
-	double mag;
-	double norm;
-	Vector3D vector;
+	int curMoved = 0;
 	for (i = 0; i < iso.atoms().length(); ++i)
 	{
 		for (j = 0; j < iso.atoms()[i].length(); ++j)
@@ -136,19 +147,8 @@ void RandomStructure::perturbAtoms(ISO& iso, double min, double max, Random& ran
 			if (iso.atoms()[i][j].anyFixed())
 				continue;
 			
-			// Generator magnitude
-			mag = (min == max) ? min : random.decimal(min, max);
-
-			// Generate random direction
-			for (k = 0; k < 3; ++k)
-				vector[k] = random.decimal(-1, 1);
-
-			// Normalize vector to magnitude
-			norm = vector.magnitude();
-			vector *= mag / norm;
-			
 			// Set new position
-			iso.atoms()[i][j].cartesian(iso.atoms()[i][j].cartesian() + vector);
+			iso.atoms()[i][j].cartesian(iso.atoms()[i][j].cartesian() + displacements[curMoved++]);
 			
 			// Output
 			Output::newline();
@@ -439,29 +439,17 @@ Matrix3D RandomStructure::generateBasis(const Matrix3D origMat, double min, doub
 	
 	// Loop until a good basis is found
 	int i, j;
-	double mag;
-	Vector3D vector;
 	Matrix3D newBasis;
+	OList<Vector3D> displacements(3);
 	do
 	{
 		
-		// Loop over directions
+		// Generate change to each basis vector
+		random.fillDirections(displacements, min, max);
 		for (i = 0; i < 3; ++i)
 		{
-
-			// Generator magnitude
-			mag = (min == max) ? min : random.decimal(min, max);
-
-			// Generate random direction
-			for (j = 0; j < 3; ++j)
-				vector[j] = random.decimal(-1, 1);
-
-			// Normalize vector to magnitude
-			vector *= mag / vector.magnitude();
-
-			// Set new basis row
 			for (j = 0; j < 3; ++j)
-				newBasis(i, j) = origMat(i, j) + vector[j];
+				newBasis(i, j) = origMat(i, j) + displacements[i][j];
 		}
 		
 		// Confine basis
@@ -591,6 +579,9 @@ void RandomStructure::generatePositions(ISO& iso, Random& random)
 	double bestWorstDistance;
 	Vector3D position;
 	Vector3D bestPosition;
+	const int trialBatchSize = 16;
+	int curTrial = trialBatchSize;
+	OList<Vector3D> trialPositions(trialBatchSize);
 	for (i = 0; i < atomsToAssign.length(); ++i)
 	{
 		for (j = 0; j < atomsToAssign[i].length(); ++j)
@@ -600,9 +591,13 @@ void RandomStructure::generatePositions(ISO& iso, Random& random)
 			for (k = 0; k < _maxTrialLoops; ++k)
 			{
 				
-				// Generate random position
-				for (m = 0; m < 3; ++m)
-					position[m] = random.decimal(0, 1);
+				// Generate random position, drawing trial positions in batches
+				if (curTrial == trialBatchSize)
+				{
+					random.fillInCell(trialPositions);
+					curTrial = 0;
+				}
+				position = trialPositions[curTrial++];
 				
 				// Loop over atoms and check distance to those that are defined
 				curWorstDist = 0;
@@ -280,8 +280,7 @@ void Relax::evaluateForces(OList<Vector3D >& forces, ISO& iso, const LocalPotent
 	
 	// Save cartesian forces
 	int i;
-	for (i = 0; i < forces.length(); ++i)
-		iso.basis().toCartesian(forces[i]);
+	iso.basis().toCartesian(forces);
 	
 	// Print forces
 	if (print)
@@ -157,6 +157,23 @@ bool Setting::set(const OList<Word>& input)
 		}
 	}
 	
+	// Value is a random number package
+	else if (_valueType == VT_RANDOMPACKAGE)
+	{
+		RandomPackage curPackage;
+		for (int i = 1; i < input.length(); ++i)
+		{
+			if (Language::isComment(input[i]))
+				break;
+			curPackage = Random::package(input[i]);
+			if (curPackage != RP_UNKNOWN)
+			{
+				_valueRandomPackage = curPackage;
+				return true;
+			}
+		}
+	}
+	
 	// Something went wrong
 	error(input);
 	return false;
@@ -214,6 +231,10 @@ void Setting::printDefault()
 	// Print GA selection method
 	else if (_valueType == VT_GASELECTION)
 		Output::print(GeneticAlgorithm<int, Setting>::selection(_defaultGASelection));
+	
+	// Print random number package
+	else if (_valueType == VT_RANDOMPACKAGE)
+		Output::print(Random::package(_defaultRandomPackage));
 }
 
 
@@ -268,6 +289,10 @@ void Setting::printValue()
 	// Print GA selection method
 	else if (_valueType == VT_GASELECTION)
 		Output::print(GeneticAlgorithm<int, Setting>::selection(_valueGASelection));
+	
+	// Print random number package
+	else if (_valueType == VT_RANDOMPACKAGE)
+		Output::print(Random::package(_valueRandomPackage));
 }
 
 
@@ -290,7 +315,7 @@ void Setting::error(const OList<Word>& input)
 
 // Static member values of Settings
 Word Settings::_globalFile;
-const int Settings::_numSettings = 39;
+const int Settings::_numSettings = 49;
 Setting* Settings::_settings = new Setting[Settings::_numSettings];
 
 
@@ -348,6 +373,9 @@ Settings::Helper::Helper()
 	// RANDSTR_MINBOND
 	Settings::_settings[(int)RANDSTR_MINBOND].setup(0.5, "randstrminbond");
 	
+	// RANDOM_PACKAGE
+	Settings::_settings[(int)RANDOM_PACKAGE].setup(RP_MERSENNE, "randompackage");
+	
 	// GAOPT_NUMSIM
 	Settings::_settings[(int)GAOPT_NUMSIM].setup(1, "gaoptnumsim");
 	
@@ -399,6 +427,18 @@ Settings::Helper::Helper()
 	// GAOPT_SAVEALLRESULTS
 	Settings::_settings[(int)GAOPT_SAVEALLRESULTS].setup(false, "gaoptsavecandidates");
 	
+	// GAOPT_FREENUM
+	Settings::_settings[(int)GAOPT_FREENUM].setup(0, "gaoptfreenum");
+	
+	// GAOPT_FREETEMP
+	Settings::_settings[(int)GAOPT_FREETEMP].setup(300.0, "gaoptfreetemp");
+	
+	// GAOPT_FREEMESH
+	Settings::_settings[(int)GAOPT_FREEMESH].setup(2, "gaoptfreemesh");
+	
+	// GAOPT_POSTRIALS
+	Settings::_settings[(int)GAOPT_POSTRIALS].setup(1, "gaoptpostrials");
+	
 	// WYCKOFFBIAS
 	Settings::_settings[(int)WYCKOFFBIAS].setup(0.5, "wyckoffbias");
 	
@@ -414,6 +454,21 @@ Settings::Helper::Helper()
 	// KMC_CONVERGENCE
 	Settings::_settings[(int)KMC_CONVERGENCE].setup(.5, "kmcconverge");
 	
+	// MD_NUMSTEPS
+	Settings::_settings[(int)MD_NUMSTEPS].setup(1000, "mdsteps");
+	
+	// MD_TIMESTEP
+	Settings::_settings[(int)MD_TIMESTEP].setup(1.0, "mdtimestep");
+	
+	// MD_DAMPING
+	Settings::_settings[(int)MD_DAMPING].setup(100.0, "mddamping");
+	
+	// MD_PRINTFREQ
+	Settings::_settings[(int)MD_PRINTFREQ].setup(100, "mdprintfreq");
+	
+	// MD_TRAJFREQ
+	Settings::_settings[(int)MD_TRAJFREQ].setup(0, "mdtrajfreq");
+	
 	// XRD_BACKGROUNDCOUNT
 	Settings::_settings[(int)XRD_BACKGROUNDCOUNT].setup(4, "xrdbackgroundcount");
     
@@ -453,6 +508,15 @@ void Settings::set(const Text& content) {
             Output::print(content[i][0]);
             Output::quit();
         }
+        
+        // Check settings that must be positive
+        if (((j == (int)GAOPT_FREEMESH) || (j == (int)GAOPT_POSTRIALS)) && (value<int>((SettingsLabel)j) <= 0)) {
+            Output::newline(ERROR);
+            Output::print("Error when reading settings file. Value of ");
+            Output::print(content[i][0]);
+            Output::print(" must be a positive integer");
+            Output::quit();
+        }
     }
 }
 
@@ -48,6 +48,7 @@
 #include "structureIO.h"
 #include "ga.h"
 #include "gaPredict.h"
+#include "random.h"
 #include "text.h"
 #include "list.h"
 #include <cmath>
@@ -56,11 +57,13 @@
 
 // Types of settings
 enum SettingsLabel {NUMPROCS, OUTPUT_LEVEL, OUTPUT_TAB, TIME_SHOW, TIME_PRECISION, TIME_FORMAT, TOLERANCE, CLUSTERTOL,\
-	USE_STDOUT, COORDINATES, STRUCTURE_FORMAT, OVERWRITE, ADD_EXTENSION, RANDSTR_MAXLOOPS, RANDSTR_MINBOND, \
+	USE_STDOUT, COORDINATES, STRUCTURE_FORMAT, OVERWRITE, ADD_EXTENSION, RANDSTR_MAXLOOPS, RANDSTR_MINBOND, RANDOM_PACKAGE, \
 	GAOPT_NUMSIM, GAOPT_POPSIZE, GAOPT_CELLMUTPROB, GAOPT_POSMUTPROB, GAOPT_WYCKMUTPROB, GAOPT_METRICTOOPT, \
 	GAOPT_CONVERGEOVER, GAOPT_MAXGENS, GAOPT_NUMTOKEEP, GAOPT_SELECTION, GAOPT_ENERGYTOL, GAOPT_DIFFRACTIONTOL, \
 	GAOPT_USERIETVELD, GAOPT_SCREENMETHOD, GAOPT_SCREENNUM, GAOPT_ALLOWRESTART, GAOPT_SAVEALLRESULTS, \
+	GAOPT_FREENUM, GAOPT_FREETEMP, GAOPT_FREEMESH, GAOPT_POSTRIALS, \
 	WYCKOFFBIAS, MINIMAGEDISTANCE, MAXJUMPDISTANCE, KMC_JUMPSPERATOM, KMC_CONVERGENCE, \
+	MD_NUMSTEPS, MD_TIMESTEP, MD_DAMPING, MD_PRINTFREQ, MD_TRAJFREQ, \
 	XRD_BACKGROUNDCOUNT, XRD_LATPARAM};
 
 
@@ -72,7 +75,8 @@ class Setting
 public:
 	
 	// Possible types
-	enum ValueType {VT_BOOL, VT_INT, VT_DOUBLE, VT_COORDINATES, VT_STRFORMAT, VT_GAOPTMETRIC, VT_GASELECTION};
+	enum ValueType {VT_BOOL, VT_INT, VT_DOUBLE, VT_COORDINATES, VT_STRFORMAT, VT_GAOPTMETRIC, VT_GASELECTION, \
+		VT_RANDOMPACKAGE};
 	
 private:
 
@@ -88,6 +92,7 @@ private:
 	StructureFormat _defaultStrFormat;
 	GAPredictMetric _defaultGAPredictMetric;
 	GASelectionMethod _defaultGASelection;
+	RandomPackage _defaultRandomPackage;
 	
 	// Store current values
 	bool _valueBool;
@@ -97,6 +102,7 @@ private:
 	StructureFormat _valueStrFormat;
 	GAPredictMetric _valueGAPredictMetric;
 	GASelectionMethod _valueGASelection;
+	RandomPackage _valueRandomPackage;
 	
 	// Functions
 	void commonSetup(const Word& tag);
@@ -112,6 +118,7 @@ public:
 	void setup(  StructureFormat defValue, const Word& tag);
 	void setup(  GAPredictMetric defValue, const Word& tag);
 	void setup(GASelectionMethod defValue, const Word& tag);
+	void setup(    RandomPackage defValue, const Word& tag);
 	
 	// Print functions
 	void printDefault();
@@ -132,6 +139,7 @@ public:
 	void value(StructureFormat input)	{ _valueStrFormat       = input; }
 	void value(GAPredictMetric input)	{ _valueGAPredictMetric = input; }
 	void value(GASelectionMethod input)	{ _valueGASelection     = input; }
+	void value(RandomPackage input)		{ _valueRandomPackage   = input; }
 	
 	// Access functions
 	bool valueBool() const							{ return _valueBool; }
@@ -141,6 +149,7 @@ public:
 	StructureFormat valueStrFormat() const			{ return _valueStrFormat; }
 	GAPredictMetric valueGAPredictMetric() const	{ return _valueGAPredictMetric; }
 	GASelectionMethod valueGASelection() const		{ return _valueGASelection; }
+	RandomPackage valueRandomPackage() const		{ return _valueRandomPackage; }
 };
 
 
@@ -235,6 +244,13 @@ inline void Setting::setup(GASelectionMethod defValue, const Word& tag)
 	commonSetup(tag);
 }
 
+inline void Setting::setup(RandomPackage defValue, const Word& tag)
+{
+	_valueType = VT_RANDOMPACKAGE;
+	_defaultRandomPackage = _valueRandomPackage = defValue;
+	commonSetup(tag);
+}
+
 
 
 /* inline void Setting::commonSetup(const Word& tag)
@@ -286,6 +302,10 @@ template <>
 inline GASelectionMethod Settings::value<GASelectionMethod>(SettingsLabel setting)
 { return _settings[(int)setting].valueGASelection(); }
 
+template <>
+inline RandomPackage Settings::value<RandomPackage>(SettingsLabel setting)
+{ return _settings[(int)setting].valueRandomPackage(); }
+
 
 
 #endif
@@ -1778,19 +1778,21 @@ void Symmetry::clusterAtoms(ISO& iso, const OList<Atom>& uniqueAtoms, double clu
 	
 	// Generate full list of sites for each unique atom
 	int i, j, k, m;
-	bool found;
+	int index;
+	int numGenerated = 0;
 	Vector3D rotPos;
 	Vector3D position;
 	Vector3D nearCell;
-	Linked<int> timesFound;
-	Linked<int>::iterator itFound;
-	Linked<Vector3D >::iterator itPos;
-	OList<Linked<Vector3D > > positions(uniqueAtoms.length());
+	List<int> timesFound;
+	OList<PositionHash> positions(uniqueAtoms.length());
+	for (i = 0; i < _operations.length(); ++i)
+		numGenerated += _operations[i].translations().length();
 	for (i = 0; i < uniqueAtoms.length(); ++i)
 	{
 		
 		// Loop over symmetry operations
-		timesFound.clear();
+		timesFound.length(0);
+		positions[i].set(iso.basis(), clusterTol, numGenerated);
 		for (j = 0; j < _operations.length(); ++j)
 		{
 			
@@ -1803,27 +1805,21 @@ void Symmetry::clusterAtoms(ISO& iso, const OList<Atom>& uniqueAtoms, double clu
 				position = rotPos + _operations[j].translations()[k];
 				ISO::moveIntoCell(position);
 				
-				// Check whether position is already known
-				found = false;
-				itFound = timesFound.begin();
-				itPos = positions[i].begin();
-				for (; itPos != positions[i].end(); ++itPos, ++itFound)
+				// Position is already known so average with it
+				index = positions[i].find(position, &nearCell);
+				if (index >= 0)
 				{
-					if (iso.basis().distance(*itPos, FRACTIONAL, position, FRACTIONAL, &nearCell) < clusterTol)
-					{
-						for (m = 0; m < 3; ++m)
-							(*itPos)[m] = (*itFound * (*itPos)[m] + position[m] + nearCell[m]) / (*itFound + 1);
-						ISO::moveIntoCell(*itPos);
-						++(*itFound);
-						found = true;
-						break;
-					}
+					for (m = 0; m < 3; ++m)
+						position[m] = (timesFound[index] * positions[i][index][m] + position[m] + nearCell[m]) / \
+							(timesFound[index] + 1);
+					positions[i].move(index, position);
+					++timesFound[index];
 				}
 				
 				// Found a new position
-				if (!found)
+				else
 				{
-					positions[i] += position;
+					positions[i].add(position);
 					timesFound += 1;
 				}
 			}
@@ -1835,12 +1831,12 @@ void Symmetry::clusterAtoms(ISO& iso, const OList<Atom>& uniqueAtoms, double clu
 	Atom* atom;
 	for (i = 0; i < uniqueAtoms.length(); ++i)
 	{
-		for (itPos = positions[i].begin(); itPos != positions[i].end(); ++itPos)
+		for (j = 0; j < positions[i].length(); ++j)
 		{
 			
 			// Set atom
 			atom = iso.addAtom(uniqueAtoms[i]);
-			atom->fractional(*itPos);
+			atom->fractional(positions[i][j]);
 			
 			// Output
 			Output::newline();
@@ -1849,7 +1845,7 @@ void Symmetry::clusterAtoms(ISO& iso, const OList<Atom>& uniqueAtoms, double clu
 			Output::print(" (");
 			Output::print(atom->element().symbol());
 			Output::print(") at ");
-			Output::print(*itPos, 8);
+			Output::print(positions[i][j], 8);
 		}
 	}
 }
@@ -1866,14 +1862,16 @@ void Symmetry::addAtom(ISO& iso, const Atom& atom, const OList<SymmetryOperation
 	
 	// Loop over symmetry operations
 	int i, j;
+	int index;
+	int numGenerated = 0;
 	bool found;
-	Linked<int> timesFound;
+	List<int> timesFound;
 	Vector3D rotPos;
 	Vector3D position;
 	Vector3D nearCell;
-	Linked<Vector3D > positions;
-	Linked<int>::iterator itFound;
-	Linked<Vector3D>::iterator itPos;
+	for (i = 0; i < operations.length(); ++i)
+		numGenerated += operations[i].translations().length();
+	PositionHash positions(iso.basis(), clusterTol, numGenerated);
 	for (i = 0; i < operations.length(); ++i)
 	{
 		rotPos = operations[i].rotation() * atom.fractional();
@@ -1884,34 +1882,28 @@ void Symmetry::addAtom(ISO& iso, const Atom& atom, const OList<SymmetryOperation
 			position = rotPos + operations[i].translations()[j];
 			ISO::moveIntoCell(position);
 			
-			// Check if position is already saved
-			found = false;
-			for (itFound = timesFound.begin(), itPos = positions.begin(); itPos != positions.end(); ++itFound, ++itPos)
+			// Position is already saved so average with it
+			index = positions.find(position, &nearCell);
+			if (index >= 0)
 			{
-				
-				// Positions are the same
-				if (iso.basis().distance(*itPos, FRACTIONAL, position, FRACTIONAL, &nearCell) < clusterTol)
-				{
-					*itPos = (*itPos * *itFound + position + nearCell) / (*itFound + 1);
-					ISO::moveIntoCell(*itPos);
-					++(*itFound);
-					found = true;
-					break;
-				}
+				positions.move(index, (positions[index] * timesFound[index] + position + nearCell) / \
+					(timesFound[index] + 1));
+				++timesFound[index];
 			}
 			
 			// Found a new position
-			if (!found)
+			else
 			{
-				positions += position;
+				positions.add(position);
 				timesFound += 1;
 			}
 		}
 	}
 	
 	// Loop over atoms to add
+	int k;
 	Atom* newAtom;
-	for (itPos = positions.begin(); itPos != positions.end(); ++itPos)
+	for (k = 0; k < positions.length(); ++k)
 	{
 		
 		// Check if position is already in the structure
@@ -1924,7 +1916,7 @@ void Symmetry::addAtom(ISO& iso, const Atom& atom, const OList<SymmetryOperation
 			{
 				
 				// Positions are the same
-				if (iso.basis().distance(iso.atoms()[i][j].fractional(), FRACTIONAL, *itPos, FRACTIONAL) < clusterTol)
+				if (iso.basis().distance(iso.atoms()[i][j].fractional(), FRACTIONAL, positions[k], FRACTIONAL) < clusterTol)
 				{
 					found = true;
 					break;
@@ -1937,14 +1929,14 @@ void Symmetry::addAtom(ISO& iso, const Atom& atom, const OList<SymmetryOperation
 		
 		// Add atom
 		newAtom = iso.addAtom(atom);
-		newAtom->fractional(*itPos);
+		newAtom->fractional(positions[k]);
 		
 		// Output
 		Output::newline();
 		Output::print("Adding atom ");
 		Output::print(newAtom->atomNumber() + 1);
 		Output::print(" at ");
-		Output::print(*itPos, 8);
+		Output::print(positions[k], 8);
 	}
 }
 
@@ -2012,124 +2004,39 @@ Matrix3D Symmetry::idealTransformation(const ISO& iso, int numAtoms, bool numAto
 	if ((runForMinDis) || ((runForMinDis == false) && (numAtomsAsMin == true)))
 		numCells = 10000;
 	
-	// Initialize the transformation matrix
-	Matrix3D resTrans = Matrix3D::identity();
-	Matrix3D startTrans = resTrans;
+	// When running for a minimum number of atoms, smaller cells are never kept so start at the target
+	int startDet = 2;
+	if ((!runForMinDis) && (numAtomsAsMin))
+		startDet = Num<int>::max(2, (int) Num<double>::ceil((double) numAtoms / primRedISO.numAtoms()));
+	
+	// Get the generators of the point group as integer matrices in the reduced primitive cell
+	OList<IMatrix3D> generators = latticeGenerators(primRedSymm);
+	
+	// Squared length of the shortest vector of any lattice with the volume of the primitive cell is at most
+	// gamma * V^(2/3) where gamma = 2^(1/3) is the Hermite constant in three dimensions
+	double maxLenScale = pow(2.0, 1.0/3.0) * pow(primRedISO.basis().volume(), 2.0/3.0);
 	
 	// Loop until the target number of cells is reached
-	int i;
-	bool first;
-	int curNum;
-	int bestNum;
-	double range;
-	double curLen;
-	double minLen = 0;
+	Matrix3D resTrans = Matrix3D::identity();
 	double resLen = 0;
-	Vector3D vec;
-	Vector3D curVec;
-	Matrix3D P;
-	Matrix3D Q;
-	Matrix3D modMat;
-	Matrix3D curTrans(0.0);
+	double maxLen;
+	double minLen;
 	Matrix3D bestTrans;
-	Matrix3D transformedCell;
-	for (double curDet = 2; curDet <= numCells; ++curDet)
+	for (int curDet = startDet; curDet <= numCells; ++curDet)
 	{
 		
-		// Loop over range from -1 to 1, and -2 to 2 if needed
-		const int maxRange = 2;
-		for (range = 1; range <= maxRange; ++range)
-		{
-			
-			// Loop over all permutations of vectors to add
-			first = true;
-			for (modMat(0, 0) = -range; modMat(0, 0) <= range+1e-6; modMat(0, 0) += 1)
-			{
-				for (modMat(0, 1) = -range; modMat(0, 1) <= range+1e-6; modMat(0, 1) += 1)
-				{
-					for (modMat(0, 2) = -range; modMat(0, 2) <= range+1e-6; modMat(0, 2) += 1)
-					{
-						for (modMat(1, 0) = -range; modMat(1, 0) <= range+1e-6; modMat(1, 0) += 1)
-						{
-							for (modMat(1, 1) = -range; modMat(1, 1) <= range+1e-6; modMat(1, 1) += 1)
-							{
-								for (modMat(1, 2) = -range; modMat(1, 2) <= range+1e-6; modMat(1, 2) += 1)
-								{
-									for (modMat(2, 0) = -range; modMat(2, 0) <= range+1e-6; modMat(2, 0) += 1)
-									{
-										for (modMat(2, 1) = -range; modMat(2, 1) <= range+1e-6; modMat(2, 1) += 1)
-										{
-											for (modMat(2, 2) = -range; modMat(2, 2) <= range+1e-6; modMat(2, 2) += 1)
-											{
-								
-												// Save transformation
-												curTrans = startTrans;
-												curTrans += modMat;
-
-												// Skip if determinant is not correct
-												if (Num<double>::neq(curTrans.determinant(), curDet, 1e-4))
-													continue;
-								
-												// Get the reduced cell
-												curTrans *= Basis::reducedTransformation(curTrans * \
-													primRedISO.basis().vectors());
-												transformedCell = curTrans * primRedISO.basis().vectors();
-								
-												// Get the length of the A vector (will be the shortest since reduced)
-												vec[0] = transformedCell(0, 0);
-												vec[1] = transformedCell(0, 1);
-												vec[2] = transformedCell(0, 2);
-												curLen = vec * vec;
-							
-												// Check whether operation preserves all symmetries as integer
-												P = curTrans.transpose();
-												Q = P.inverse();
-												curNum = 0;
-												for (i = primRedSymm.operations().length() - 1; i >= 0; --i)
-												{
-													if ((Q * primRedSymm.operations()[i].rotation() * \
-														 P).isInteger(1e-2) == true)
-														++curNum;
-												}
-											
-												// Save if the number of symmetries improved
-												if ((first) || (curNum > bestNum))
-												{
-													minLen = curLen;
-													bestNum = curNum;
-													bestTrans = curTrans;
-												}
-											
-												// If number of symmetries was the same then check if length was better
-												if ((curNum == bestNum) && (curLen > minLen))
-												{
-													minLen = curLen;
-													bestTrans = curTrans;
-												}
-											
-												// Save that a loop was made
-												first = false;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
-				}
-			}
-			
-			// Break condition to improve efficiency
-			// THIS SEEMS TO CAUSE BAD BEHAVIOR IF UNCOMMENTED
-			//if (bestNum >= primRedSymm.operations().length()/2)
-			//	break;
-		}
+		// Skip if no cell of the current size could be accepted
+		maxLen = maxLenScale * pow((double) curDet, 2.0/3.0);
+		if ((runForMinDis) && (sqrt(maxLen) * (1 + 1e-8) <= minDis))
+			continue;
+		if ((!runForMinDis) && (!numAtomsAsMin) && (sqrt(maxLen) * (1 + 1e-8) <= resLen + 1e-6))
+			continue;
 		
-		// Save best transformation for current determinant
-		startTrans = bestTrans;
+		// Get the cell with the longest shortest vector that preserves all symmetries
+		minLen = bestIdealCell(primRedISO.basis().vectors(), curDet, generators, maxLen, bestTrans);
 		
 		// Only process if a valid cell was found
-		if (bestNum == primRedSymm.operations().length())
+		if (minLen >= 0)
 		{
 			
 			// Not running for distance
@@ -2172,7 +2079,7 @@ Matrix3D Symmetry::idealTransformation(const ISO& iso, int numAtoms, bool numAto
 	transformation *= resTrans;
 	
 	// Output
-	int j;
+	int i, j;
 	Output::newline();
     Output::print("Relative to the unit cell, the most ideal basis vectors are:");
 	for (i = 0; i < 3; ++i)
@@ -2195,6 +2102,191 @@ Matrix3D Symmetry::idealTransformation(const ISO& iso, int numAtoms, bool numAto
 
 
 
+/* OList<IMatrix3D> Symmetry::latticeGenerators(const Symmetry& symmetry)
+ *
+ * Get a set of rotations that generates the point group of a structure, as integer matrices in its basis
+ */
+
+OList<IMatrix3D> Symmetry::latticeGenerators(const Symmetry& symmetry)
+{
+	
+	// Loop over operations and save any rotation that is not already in the generated group
+	int i, j, k, m;
+	bool found;
+	IMatrix3D rotation;
+	IMatrix3D product;
+	OList<IMatrix3D> group;
+	OList<IMatrix3D> generators;
+	group += IMatrix3D::identity();
+	for (i = 0; i < symmetry.operations().length(); ++i)
+	{
+		
+		// Skip if rotation is not integer or is already known
+		if (!rotation.set(symmetry.operations()[i].rotation(), 1e-2))
+			continue;
+		for (found = false, j = 0; j < group.length(); ++j)
+		{
+			if (group[j] == rotation)
+			{
+				found = true;
+				break;
+			}
+		}
+		if (found)
+			continue;
+		
+		// Save generator and add all new products to the group
+		generators += rotation;
+		for (j = 0; j < group.length(); ++j)
+		{
+			for (k = 0; k < generators.length(); ++k)
+			{
+				product = group[j] * generators[k];
+				for (found = false, m = 0; m < group.length(); ++m)
+				{
+					if (group[m] == product)
+					{
+						found = true;
+						break;
+					}
+				}
+				if (!found)
+					group += product;
+			}
+		}
+	}
+	
+	// Return generators
+	return generators;
+}
+
+
+
+/* bool Symmetry::preservesLattice(const IMatrix3D& transformation, const OList<IMatrix3D>& generators)
+ *
+ * Check whether every rotation maps the lattice with basis rows transformation onto itself
+ */
+
+bool Symmetry::preservesLattice(const IMatrix3D& transformation, const OList<IMatrix3D>& generators)
+{
+	
+	// Rotation R preserves the lattice when P^-1 R P is integer where the columns of P are the lattice vectors,
+	//   or equivalently when adj(P) R P is divisible by det(P)
+	int i, j, k;
+	IMatrix3D P = transformation.transpose();
+	IMatrix3D adjP = P.adjugate();
+	long det = P.determinant();
+	IMatrix3D product;
+	for (i = 0; i < generators.length(); ++i)
+	{
+		product = adjP * generators[i] * P;
+		for (j = 0; j < 3; ++j)
+		{
+			for (k = 0; k < 3; ++k)
+			{
+				if (product(j, k) % det != 0)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+/* double Symmetry::idealCellLength(const Matrix3D& vectors, const IMatrix3D& sublattice,
+ *		const OList<IMatrix3D>& generators, Matrix3D& transformation)
+ *
+ * Get the squared length of the shortest vector of a sublattice and the transformation to its reduced cell,
+ *	or -1 if the sublattice does not preserve all symmetries
+ */
+
+double Symmetry::idealCellLength(const Matrix3D& vectors, const IMatrix3D& sublattice, \
+	const OList<IMatrix3D>& generators, Matrix3D& transformation)
+{
+	
+	// Return if symmetry is broken
+	if (!preservesLattice(sublattice, generators))
+		return -1;
+	
+	// Get the reduced cell
+	transformation = sublattice.toDouble();
+	transformation *= Basis::reducedTransformation(transformation * vectors);
+	Matrix3D cell = transformation * vectors;
+	
+	// Return the length of the A vector (will be the shortest since reduced)
+	return cell(0, 0)*cell(0, 0) + cell(0, 1)*cell(0, 1) + cell(0, 2)*cell(0, 2);
+}
+
+
+
+/* double Symmetry::bestIdealCell(const Matrix3D& vectors, int index, const OList<IMatrix3D>& generators,
+ *		double maxLength, Matrix3D& transformation)
+ *
+ * Search all sublattices of an index for the one that preserves all symmetries and has the longest shortest
+ *	vector. Sublattices are enumerated in blocks, so memory does not grow with the number of sublattices, and
+ *	each block is evaluated in parallel then compared in order, so ties always go to the first Hermite normal
+ *	form. idealCellLength only works on its arguments and locals (Basis::reducedTransformation is static and
+ *	only reads the vectors it is given), so it is safe to call in the parallel loop. The search stops after the
+ *	block in which a cell reaches maxLength, since no cell can be longer. Returns the squared length, or -1 if
+ *	no sublattice preserves all symmetries.
+ */
+
+double Symmetry::bestIdealCell(const Matrix3D& vectors, int index, const OList<IMatrix3D>& generators, \
+	double maxLength, Matrix3D& transformation)
+{
+	
+	// Loop over blocks of sublattices
+	int i;
+	int numInBlock;
+	const int blockSize = 256;
+	bool more = true;
+	double bestLen = -1;
+	IMatrix3D sublattice(0);
+	List<double> lengths(blockSize);
+	OList<IMatrix3D> candidates(blockSize);
+	OList<Matrix3D> transformations(blockSize);
+	while (more)
+	{
+		
+		// Get next block of sublattices
+		for (numInBlock = 0; numInBlock < blockSize; ++numInBlock)
+		{
+			if (!(more = IMatrix3D::nextSublattice(index, sublattice)))
+				break;
+			candidates[numInBlock] = sublattice;
+		}
+		
+		// Evaluate current block
+		#ifdef MINT_OPENMP
+		#pragma omp parallel for schedule(dynamic)
+		#endif
+		for (int j = 0; j < numInBlock; ++j)
+			lengths[j] = idealCellLength(vectors, candidates[j], generators, transformations[j]);
+		
+		// Save best cell in block
+		for (i = 0; i < numInBlock; ++i)
+		{
+			if (lengths[i] < 0)
+				continue;
+			if ((bestLen < 0) || (Num<double>::gt(lengths[i], bestLen, 1e-8 * bestLen)))
+			{
+				bestLen = lengths[i];
+				transformation = transformations[i];
+			}
+		}
+		
+		// Stop if no better cell can exist
+		if (bestLen >= maxLength * (1 - 1e-8))
+			break;
+	}
+	
+	// Return the length of the best cell
+	return bestLen;
+}
+
+
+
 /* Matrix3D Symmetry::makeIdeal(ISO& iso, int numAtoms, bool numAtomsAsMin, double minDis, double tol)
  *
  * Convert to ideal cell
@@ -187,6 +187,12 @@ class Symmetry
 	void clusterAtoms(ISO& iso, const OList<Atom>& uniqueAtoms, double clusterTol) const;
 	
 	// Helper functions for ideal cell conversions
+	static OList<IMatrix3D> latticeGenerators(const Symmetry& symmetry);
+	static bool preservesLattice(const IMatrix3D& transformation, const OList<IMatrix3D>& generators);
+	static double idealCellLength(const Matrix3D& vectors, const IMatrix3D& sublattice, \
+		const OList<IMatrix3D>& generators, Matrix3D& transformation);
+	static double bestIdealCell(const Matrix3D& vectors, int index, const OList<IMatrix3D>& generators, \
+		double maxLength, Matrix3D& transformation);
 	static Matrix3D idealTransformation(const ISO& iso, int numAtoms, bool numAtomsAsMin, double minDis, double tol);
 	static Matrix3D makeIdeal(ISO& iso, int numAtoms, bool numAtomsAsMin, double minDis, double tol);
 
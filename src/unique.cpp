@@ -1027,8 +1027,10 @@ Word Unique::makeISO(ISO& iso, int group) const
 	atoms.sort();
 	
 	// Loop over atoms in reverse and remove
+	iso.beginEdit();
 	for (i = atoms.length() - 1; i >= 0; --i)
 		iso.removeAtom(atoms[i]);
+	iso.commitEdit();
 	
 	// Make description to return
 	Word des = "Removed atom";
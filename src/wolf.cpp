@@ -0,0 +1,432 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "multi.h"
+#include "wolf.h"
+#include "language.h"
+#include "output.h"
+#include <cstdlib>
+#include <cmath>
+
+/**
+ *
+ * Set damped-shifted-force parameters. Expected format of line #1
+ *	wolf <element #1 symbol> <element #1 charge> <element #2 symbol> <element #2 charge> <...>
+ * 
+ * Subsequent options:
+ *	cutoff [value] - Cutoff distance in Angstrom (default 12)
+ *	damping [value] - Damping parameter in 1/Angstrom (default 0.2)
+ *  permittivity [value] - Value of permittivity constant in eV*Angstrom
+ *  relative [value] - Permittivity relative to epsilon_0
+ */
+void Wolf::set(const Text& input)
+{
+	
+	// Finished if empty
+	if (!input.length())
+		return;
+	
+	// Output
+	Output::newline();
+	Output::print("Coulomb potential using damped-shifted-force summation");
+	Output::increase();
+	
+	// Get elements and charges from first line
+	int i;
+	for (i = 1; i < input[0].length(); ++i)
+	{
+		
+		// Break if a comment
+		if (Language::isComment(input[0][i]))
+			break;
+		
+		// Found element
+		if (Element::isElement(input[0][i], false))
+			_elements += Element::find(input[0][i], false);
+		
+		// Found number
+		else if (Language::isNumber(input[0][i]))
+			_charges += atof(input[0][i].array());
+		
+		// Found something else
+		else
+			readError(input[0]);
+	}
+	
+	// Charges and elements do not match
+	if (_elements.length() != _charges.length())
+	{
+		Output::newline(ERROR);
+		Output::print("Number of elements and charges must be equal in damped-shifted-force potential");
+		Output::quit();
+	}
+	
+	// Look for other values
+	for (i = 1; i < input.length(); ++i)
+	{
+		
+		// Line is empty
+		if (!input[i].length())
+			continue;
+		
+		// Found a comment
+		if (Language::isComment(input[i][0]))
+			continue;
+		
+		// Line is too short or value is not a number
+		if ((input[i].length() < 2) || (!Language::isNumber(input[i][1])))
+			readError(input[i]);
+		
+		// Found cutoff
+		if (input[i][0].equal("cutoff", false, 3))
+			_cutoff = atof(input[i][1].array());
+		
+		// Found damping parameter
+		else if ((input[i][0].equal("damping", false, 4)) || (input[i][0].equal("alpha", false, 5)))
+			_alpha = atof(input[i][1].array());
+		
+		// Found permittivity
+		else if (input[i][0].equal("permittivity", false, 4))
+			_perm = atof(input[i][1].array());
+		
+		// Found relative permittivity
+		else if (input[i][0].equal("relative", false, 3))
+			_perm = Constants::eps0 * atof(input[i][1].array());
+		
+		// Anything else
+		else
+			readError(input[i]);
+	}
+	
+	// Check values
+	if ((_cutoff <= 0) || (_alpha < 0))
+	{
+		Output::newline(ERROR);
+		Output::print("Cutoff must be positive and damping must not be negative in damped-shifted-force potential");
+		Output::quit();
+	}
+	setCutoffTerms();
+	
+	// Print elements and charges
+	for (i = 0; i < _elements.length(); ++i)
+	{
+		Output::newline();
+		Output::print("Charge of ");
+		Output::print(_elements[i].symbol());
+		Output::print(": ");
+		Output::print(_charges[i]);
+	}
+	
+	// Print other parameters
+	Output::newline();
+	Output::print("Relative permitivity: ");
+	Output::print(_perm / Constants::eps0);
+	Output::newline();
+	Output::print("Permitivity: ");
+	Output::printSci(_perm);
+	Output::print(" eV*Ang");
+	Output::newline();
+	Output::print("Cutoff: ");
+	Output::print(_cutoff);
+	Output::print(" Ang");
+	Output::newline();
+	Output::print("Damping: ");
+	Output::print(_alpha);
+	Output::print(" 1/Ang");
+	
+	// Output
+	Output::decrease();
+}
+
+
+
+/**
+ * Compute the damped-shifted-force energy
+ * @param iso [in] System to evaluate
+ * @param totalEnergy [out] Total energy, Coulomb energy will be added to this value
+ * @param totalForces [out] Force on each atom, Coulomb force (in fractional units) will be added to this value
+ */
+void Wolf::evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const
+{
+	
+	// Build neighbor list (only saved between evaluations if reused with a skin)
+	NeighborList tempNeighbors;
+	NeighborList& neighbors = (_skin > 0) ? _neighbors : tempNeighbors;
+	neighbors.update(iso, _cutoff, _skin);
+	
+	// Variable to store forces
+	OList<Vector3D > localForces;
+	if (totalForces)
+	{
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Variable to store energy of each atom
+	List<double> terms;
+	if (totalEnergy)
+	{
+		terms.length(neighbors.numAtoms());
+		terms.fill(0);
+	}
+	
+	// Loop over atoms
+	int i;
+	int count = 0;
+	for (i = 0; i < neighbors.numAtoms(); ++i)
+	{
+		if ((++count + Multi::rank()) % Multi::worldSize() == 0)
+		{
+			if (totalEnergy)
+				terms[i] = atomEnergy(neighbors, neighbors.atom(i));
+			if (totalForces)
+				localForces[i] = atomForce(iso, neighbors, neighbors.atom(i));
+		}
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms);
+	
+	// Send forces between processors
+	if (totalForces)
+	{
+		int j;
+		Vector3D temp;
+		for (i = 0; i < localForces.length(); ++i)
+		{
+			for (j = 0; j < Multi::worldSize(); ++j)
+			{
+				temp = localForces[i];
+				Multi::broadcast(temp, j);
+				(*totalForces)[i] += temp;
+			}
+		}
+	}
+}
+
+
+
+/**
+ * Compute the damped-shifted-force energy using symmetry
+ * @param iso [in] System to evaluate
+ * @param symmetry [in] Symmetry of the structure
+ * @param totalEnergy [out] Total energy, Coulomb energy will be added to this value
+ * @param totalForces [out] Force on each atom, Coulomb force (in fractional units) will be added to this value
+ */
+void Wolf::evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, \
+	OList<Vector3D >* totalForces) const
+{
+	
+	// Do not use symmetry unless if reduces the number of atoms by at least a factor of two
+	if (iso.numAtoms() / symmetry.orbits().length() < 2) {
+		evaluate(iso, totalEnergy, totalForces);
+		return;
+	}
+	
+	// Build neighbor list (only saved between evaluations if reused with a skin)
+	NeighborList tempNeighbors;
+	NeighborList& neighbors = (_skin > 0) ? _neighbors : tempNeighbors;
+	neighbors.update(iso, _cutoff, _skin);
+	
+	// Variable to store forces
+	OList<Vector3D > localForces;
+	if (totalForces)
+	{
+		localForces.length(totalForces->length());
+		localForces.fill(0.0);
+	}
+	
+	// Variable to store energy of each unique atom
+	List<double> terms;
+	if (totalEnergy)
+	{
+		terms.length(symmetry.orbits().length());
+		terms.fill(0);
+	}
+	
+	// Loop over unique atoms
+	int i, j;
+	int count = 0;
+	for (i = 0; i < symmetry.orbits().length(); ++i)
+	{
+		
+		// Check if adding on current processor
+		if ((++count + Multi::rank()) % Multi::worldSize() != 0)
+			continue;
+		
+		// Add energy
+		if (totalEnergy)
+			terms[i] = symmetry.orbits()[i].atoms().length() * \
+				atomEnergy(neighbors, symmetry.orbits()[i].atoms()[0]);
+		
+		// Get force
+		if (totalForces)
+			localForces[symmetry.orbits()[i].atoms()[0]->atomNumber()] = \
+				symmetry.orbits()[i].specialPositions()[0].rotation() * \
+					atomForce(iso, neighbors, symmetry.orbits()[i].atoms()[0]);
+	}
+	
+	// Sum energy over processors
+	if (totalEnergy)
+		*totalEnergy += Multi::sum(terms);
+	
+	// Send forces between processors
+	if (totalForces)
+	{
+		
+		// Send forces
+		Vector3D temp;
+		OList<Vector3D > uniqueForces(localForces.length());
+		uniqueForces.fill(0.0);
+		for (i = 0; i < localForces.length(); ++i)
+		{
+			for (j = 0; j < Multi::worldSize(); ++j)
+			{
+				temp = localForces[i];
+				Multi::broadcast(temp, j);
+				uniqueForces[i] += temp;
+			}
+		}
+		
+		// Apply symmetry operations to generate forces on equivalent atoms
+		int rep;
+		for (i = 0; i < symmetry.orbits().length(); ++i)
+		{
+			rep = symmetry.orbits()[i].atoms()[0]->atomNumber();
+			(*totalForces)[rep] += uniqueForces[rep];
+			for (j = 1; j < symmetry.orbits()[i].atoms().length(); ++j)
+				(*totalForces)[symmetry.orbits()[i].atoms()[j]->atomNumber()] += \
+					symmetry.orbits()[i].generators()[j].rotation() * uniqueForces[rep];
+		}
+	}
+}
+
+
+
+/**
+ * Compute the change in energy from a local move using the reference state saved by commit
+ * @param iso [in] Reference structure
+ * @param move [in] Changes to apply to the structure
+ * @return Energy after the move minus energy before the move
+ */
+double Wolf::deltaEnergy(const ISO& iso, const LocalMove& move) const
+{
+	
+	// Save reference if it has not been set or the structure has changed
+	if (!committed(iso))
+		commit(iso);
+	
+	// Get change in pair energy
+	double res = localPairEnergy(iso, _reference, move, true) - localPairEnergy(iso, _reference, move, false);
+	
+	// Get change in self energy
+	int i;
+	for (i = 0; i < move.length(); ++i)
+	{
+		if (move.present(i, true))
+			res -= selfEnergy(getCharge(move.element(i, true))) / (4 * Constants::pi * _perm);
+		if (move.present(i, false))
+			res += selfEnergy(getCharge(move.element(i, false))) / (4 * Constants::pi * _perm);
+	}
+	
+	// Return energy change
+	return res;
+}
+
+
+
+/**
+ * Compute the energy of a single atom, including half of each pair interaction and the self term
+ * @param neighbors [in] Current neighbor list of the structure
+ * @param atom [in] Atom being considered
+ */
+double Wolf::atomEnergy(const NeighborList& neighbors, const Atom* atom) const
+{
+	
+	// Get the charge of the current atom
+	double atomCharge = getCharge(atom->element());
+	if (atomCharge == 0)
+		return 0;
+	
+	// Loop over neighbors
+	int i;
+	int atomNumber = atom->atomNumber();
+	double res = 0;
+	for (i = 0; i < neighbors.numNeighbors(atomNumber); ++i)
+		res += getCharge(neighbors.neighbor(atomNumber, i)->element()) * pairEnergy(neighbors.distance(atomNumber, i));
+	
+	// Return the energy
+	return (atomCharge * res / 2 - selfEnergy(atomCharge)) / (4 * Constants::pi * _perm);
+}
+
+
+
+/**
+ * Compute the force on a single atom
+ * @param iso [in] Structure being evaluated
+ * @param neighbors [in] Current neighbor list of the structure
+ * @param atom [in] Atom on which force is active
+ * @return Force in fractional units
+ */
+Vector3D Wolf::atomForce(const ISO& iso, const NeighborList& neighbors, const Atom* atom) const
+{
+	
+	// Get the charge of the current atom
+	Vector3D force(0.0);
+	double atomCharge = getCharge(atom->element());
+	if (atomCharge == 0)
+		return force;
+	
+	// Loop over neighbors
+	int i;
+	int atomNumber = atom->atomNumber();
+	double distance;
+	for (i = 0; i < neighbors.numNeighbors(atomNumber); ++i)
+	{
+		distance = neighbors.distance(atomNumber, i);
+		force -= neighbors.cartVector(atomNumber, i) * (getCharge(neighbors.neighbor(atomNumber, i)->element()) * \
+			pairForce(distance) / distance);
+	}
+	
+	// Return force in fractional units
+	force *= atomCharge / (4 * Constants::pi * _perm);
+	iso.basis().toFractional(force);
+	return force;
+}
+
+
+
+/**
+ * Get the charge of an element
+ * @param element [in] Element to look up
+ * @return Charge of element, or zero if not set
+ */
+double Wolf::getCharge(const Element& element) const
+{
+	for (int i = 0; i < _elements.length(); ++i)
+	{
+		if (_elements[i] == element)
+			return _charges[i];
+	}
+	return 0;
+}
@@ -0,0 +1,144 @@
+/* Copyright 2011-2014 Kyle Michel, Logan Ward, Christopher Wolverton
+ *
+ * Contact: Kyle Michel (kylemichel@gmail.com)
+ *			Logan Ward (LoganWard2012@u.northwestern.edu)
+ *
+ *
+ * This file is part of Mint.
+ *
+ * Mint is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General
+ * Public License as published by the Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * Mint is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with Mint.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef WOLF_H
+#define WOLF_H
+
+
+
+#include "locPotential.h"
+#include "iso.h"
+#include "elements.h"
+#include "symmetry.h"
+#include "text.h"
+#include "constants.h"
+#include <cmath>
+
+
+
+/**
+ * Coulomb potential using the damped-shifted-force (Wolf) pairwise summation.
+ * 
+ * Interactions are damped by erfc(alpha*r) and both the energy and force are shifted
+ *  to go to zero at the cutoff, so no reciprocal space sum is needed and the cost
+ *  scales linearly with the number of atoms. See: Fennell and Gezelter, J. Chem.
+ *  Phys. 124, 234104 (2006)
+ * 
+ * E = 1/(4*pi*eps) * { sum_{i<j, r<Rc} q_i*q_j*[erfc(a*r)/r - erfc(a*Rc)/Rc
+ *		+ (erfc(a*Rc)/Rc^2 + 2*a/sqrt(pi)*exp(-a^2*Rc^2)/Rc)*(r - Rc)]
+ *		- sum_i q_i^2*[erfc(a*Rc)/(2*Rc) + a/sqrt(pi)] }
+ */
+class Wolf : public SingleLocalPotential {
+	
+	// Elements and charges
+	List<double> _charges;
+	OList<Element> _elements;
+	
+	// General variables
+	double _perm;
+	double _cutoff;
+	double _alpha;
+	
+	// Helper variables
+	// Energy and force of the erfc term at the cutoff
+	double _cutEnergy;
+	double _cutForce;
+	// Neighbor list kept between evaluations when a skin is set (otherwise each evaluation uses its own list)
+	mutable NeighborList _neighbors;
+	mutable NeighborList _reference;
+	
+	// Functions
+	void setCutoffTerms();
+	double atomEnergy(const NeighborList& neighbors, const Atom* atom) const;
+	Vector3D atomForce(const ISO& iso, const NeighborList& neighbors, const Atom* atom) const;
+	double pairEnergy(double distance) const;
+	double pairForce(double distance) const;
+	double selfEnergy(double charge) const;
+	
+	// Helper functions
+	double getCharge(const Element& element) const;
+	double interaction(const Element& elem1, const Element& elem2, double distance) const
+		{ return getCharge(elem1) * getCharge(elem2) * pairEnergy(distance) / (4 * Constants::pi * _perm); }
+	
+public:
+	
+	// Constructor
+	Wolf()	{ _perm = Constants::eps0; _cutoff = 12; _alpha = 0.2; setCutoffTerms(); }
+	
+	// Setup by file input
+	void set(const Text& input);
+	
+	// Evaluation functions
+	void evaluate(const ISO& iso, double* totalEnergy, OList<Vector3D >* totalForces) const;
+	void evaluate(const ISO& iso, const Symmetry& symmetry, double* totalEnergy, \
+		OList<Vector3D >* totalForces) const;
+	
+	// Energy changes for local moves
+	void commit(const ISO& iso) const	{ _reference.set(iso, _cutoff, false); markCommitted(iso); }
+	double deltaEnergy(const ISO& iso, const LocalMove& move) const;
+};
+
+
+
+/**
+ * Save the erfc energy and force terms evaluated at the cutoff
+ */
+inline void Wolf::setCutoffTerms() {
+	_cutEnergy = erfc(_alpha * _cutoff) / _cutoff;
+	_cutForce = _cutEnergy / _cutoff + 2 * _alpha / sqrt(Constants::pi) * \
+		exp(-_alpha * _alpha * _cutoff * _cutoff) / _cutoff;
+}
+
+
+
+/**
+ * Shifted pair energy per unit charge squared (without 1/(4*pi*eps) prefactor)
+ * @param distance [in] Distance between atoms
+ */
+inline double Wolf::pairEnergy(double distance) const {
+	return erfc(_alpha * distance) / distance - _cutEnergy + _cutForce * (distance - _cutoff);
+}
+
+
+
+/**
+ * Shifted pair force (-dE/dr) per unit charge squared (without 1/(4*pi*eps) prefactor)
+ * @param distance [in] Distance between atoms
+ */
+inline double Wolf::pairForce(double distance) const {
+	return erfc(_alpha * distance) / (distance * distance) + 2 * _alpha / sqrt(Constants::pi) * \
+		exp(-_alpha * _alpha * distance * distance) / distance - _cutForce;
+}
+
+
+
+/**
+ * Self energy of an atom (without 1/(4*pi*eps) prefactor)
+ * @param charge [in] Charge of the atom
+ */
+inline double Wolf::selfEnergy(double charge) const {
+	return charge * charge * (_cutEnergy / 2 + _alpha / sqrt(Constants::pi));
+}
+
+
+
+#endif